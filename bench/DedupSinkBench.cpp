@@ -0,0 +1,43 @@
+#include "nealog/DedupSink.h"
+#include "nealog/Logger.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <memory>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[!benchmark][DedupSink]";
+
+
+
+TEST_CASE("a retry storm written to a file", TAG)
+{
+    const char* pattern = "%(time) %(severity) %(logger) [%(thread)] %(message)\n";
+    auto makeLogger     = [pattern](Sink::SPtr sink) {
+        auto logger = std::make_unique<Logger>("svc.db");
+        logger->setFormatter(PatternFormatter{pattern});
+        logger->addSink(std::move(sink));
+        return logger;
+    };
+
+    auto direct  = makeLogger(SinkFactory::createFileSink("/dev/null"));
+    auto deduped = makeLogger(std::make_shared<DedupSink>(SinkFactory::createFileSink("/dev/null"), DedupPolicy{},
+                                                          PatternFormatter{pattern}));
+
+    BENCHMARK("written")
+    {
+        direct->warn("connection to {} refused, retrying", "10.0.0.7:5432");
+    };
+
+    BENCHMARK("collapsed")
+    {
+        deduped->warn("connection to {} refused, retrying", "10.0.0.7:5432");
+    };
+
+    int request = 0;
+    BENCHMARK("distinct messages through the dedup sink")
+    {
+        deduped->warn("request {} failed", request++);
+    };
+}
@@ -0,0 +1,41 @@
+#include "nealog/Logger.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[!benchmark][FlightRecorder]";
+
+
+
+TEST_CASE("a debug call on a logger at info", TAG)
+{
+    auto makeLogger = [](Severity severity) {
+        auto logger = std::make_unique<Logger>("svc.db");
+        logger->setSeverity(severity);
+        logger->setFormatter(PatternFormatter{"%(time) %(severity) %(logger) [%(thread)] %(message)\n"});
+        logger->addSink(std::make_shared<NoopSink>());
+        return logger;
+    };
+
+    auto dropping = makeLogger(Severity::Info);
+    auto writing  = makeLogger(Severity::Debug);
+    auto keeping  = makeLogger(Severity::Info);
+    keeping->setFlightRecorder({1024, Severity::Debug, Severity::Error});
+
+    BENCHMARK("dropped")
+    {
+        dropping->debug("pool resized to {} connections", 32);
+    };
+
+    BENCHMARK("kept by the flight recorder")
+    {
+        keeping->debug("pool resized to {} connections", 32);
+    };
+
+    BENCHMARK("written with a pattern")
+    {
+        writing->debug("pool resized to {} connections", 32);
+    };
+}
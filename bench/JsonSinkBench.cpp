@@ -0,0 +1,59 @@
+#include "nealog/JsonSink.h"
+#include "nealog/Logger.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <utility>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[!benchmark][JsonSink]";
+
+
+
+TEST_CASE("escape a message for JSON", TAG)
+{
+    // a long message with a quoted value, like most of them have only a few characters to escape
+    std::string message;
+    while (message.size() < 256)
+        message += "connection pool of \"svc.db\" resized to 32 connections after 3 timeouts; ";
+
+    fmt::memory_buffer buffer;
+    for (auto [name, kernel] : {std::pair{"JsonEscapeKernel::Scalar", JsonEscapeKernel::Scalar},
+                                std::pair{"JsonEscapeKernel::Sse2", JsonEscapeKernel::Sse2},
+                                std::pair{"JsonEscapeKernel::Avx2", JsonEscapeKernel::Avx2}})
+    {
+        if (!isJsonEscapeKernelSupported(kernel))
+            continue;
+
+        BENCHMARK(name)
+        {
+            buffer.clear();
+            appendJsonEscaped(buffer, message, kernel);
+            return buffer.size();
+        };
+    }
+}
+
+
+
+TEST_CASE("log a line of text or JSON", TAG)
+{
+    Logger text{"svc.db"};
+    text.setFormatter(PatternFormatter{"%(time) %(severity) %(logger) [%(thread)] %(message)\n"});
+    text.addSink(std::make_shared<NoopSink>());
+
+    Logger json{"svc.db"};
+    json.addSink(std::make_shared<JsonSink>(std::make_shared<NoopSink>()));
+
+    BENCHMARK("text sink with a pattern")
+    {
+        text.info("pool resized to {} connections", 32, kv("user", "bob"), kv("ms", 1.5));
+    };
+
+    BENCHMARK("JsonSink")
+    {
+        json.info("pool resized to {} connections", 32, kv("user", "bob"), kv("ms", 1.5));
+    };
+}
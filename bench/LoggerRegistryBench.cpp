@@ -0,0 +1,91 @@
+#include "nealog/ConcurrentLoggerRegistry.h"
+#include "nealog/Logger.h"
+#include "nealog/Macros.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG            = "[!benchmark][LoggerRegistry]";
+constexpr const char* LOGGER_NAME    = "svc.db.connection.pool";
+constexpr int LOOKUPS_PER_THREAD     = 100000;
+constexpr int CONCURRENT_LOOKUP_THREADS = 4;
+
+
+
+template <typename TRegistry>
+auto lookupOnThreads(TRegistry& registry, int threadCount) -> std::size_t
+{
+    std::vector<std::thread> threads;
+    std::vector<std::size_t> found(threadCount, 0);
+
+    for (int thread = 0; thread < threadCount; thread++)
+    {
+        threads.emplace_back([&registry, &found, thread]() {
+            for (int i = 0; i < LOOKUPS_PER_THREAD; i++)
+                found[thread] += registry.getOrCreate(LOGGER_NAME) != nullptr;
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::size_t total = 0;
+    for (std::size_t count : found)
+        total += count;
+    return total;
+}
+
+
+
+TEST_CASE("look up an existing logger", TAG)
+{
+    LoggerRegistry_mt mapRegistry;
+    ConcurrentLoggerRegistry trieRegistry;
+    mapRegistry.getOrCreate(LOGGER_NAME);
+    trieRegistry.getOrCreate(LOGGER_NAME);
+    const std::string name{LOGGER_NAME};
+
+    BENCHMARK("LoggerRegistry_mt")
+    {
+        return mapRegistry.getOrCreate(name);
+    };
+
+    BENCHMARK("ConcurrentLoggerRegistry")
+    {
+        return trieRegistry.getOrCreate(LOGGER_NAME);
+    };
+
+    BENCHMARK("ConcurrentLoggerRegistry without reference counting")
+    {
+        return &trieRegistry.getOrCreateReference(LOGGER_NAME);
+    };
+
+    BENCHMARK("NEALOG_LOGGER call site")
+    {
+        return &NEALOG_LOGGER("svc.db.connection.pool");
+    };
+}
+
+
+
+TEST_CASE("look up an existing logger on multiple threads", TAG)
+{
+    LoggerRegistry_mt mapRegistry;
+    ConcurrentLoggerRegistry trieRegistry;
+    mapRegistry.getOrCreate(LOGGER_NAME);
+    trieRegistry.getOrCreate(LOGGER_NAME);
+
+    BENCHMARK("LoggerRegistry_mt")
+    {
+        return lookupOnThreads(mapRegistry, CONCURRENT_LOOKUP_THREADS);
+    };
+
+    BENCHMARK("ConcurrentLoggerRegistry")
+    {
+        return lookupOnThreads(trieRegistry, CONCURRENT_LOOKUP_THREADS);
+    };
+}
@@ -0,0 +1,99 @@
+#include "nealog/Clock.h"
+#include "nealog/Formatter.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <fmt/format.h>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[!benchmark][Pattern]";
+
+
+
+TEST_CASE("capture a timestamp", TAG)
+{
+    BENCHMARK("std::chrono::system_clock")
+    {
+        return std::chrono::system_clock::now();
+    };
+
+    for (auto [name, source] : {std::pair{"ClockSource::Standard", ClockSource::Standard},
+                                std::pair{"ClockSource::RealtimeCoarse", ClockSource::RealtimeCoarse},
+                                std::pair{"ClockSource::Tsc", ClockSource::Tsc}})
+    {
+        if (!setClockSource(source))
+            continue;
+
+        BENCHMARK(name)
+        {
+            return captureTimestamp();
+        };
+    }
+
+    setClockSource(ClockSource::Standard);
+}
+
+
+
+TEST_CASE("render a timestamp with the message", TAG)
+{
+    const auto timestamp = std::chrono::system_clock::now();
+    PatternFormatter formatter{"%(time) %(message)\n"};
+    fmt::memory_buffer buffer;
+
+    BENCHMARK("localtime and strftime for every message")
+    {
+        buffer.clear();
+        const std::time_t seconds = std::chrono::system_clock::to_time_t(timestamp);
+
+        char text[32];
+        const std::size_t size = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+        const auto milliseconds =
+            std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count() % 1000;
+        fmt::format_to(std::back_inserter(buffer), "{}.{:03} {}\n", std::string_view{text, size}, milliseconds,
+                       "connection pool resized");
+        return buffer.size();
+    };
+
+    BENCHMARK("PatternFormatter with %(time)")
+    {
+        buffer.clear();
+        formatter.render(buffer, "connection pool resized", PatternContext{timestamp});
+        return buffer.size();
+    };
+}
+
+
+
+TEST_CASE("render severity, logger and thread with the message", TAG)
+{
+    const std::string loggerName = "svc.db";
+    PatternFormatter formatter{"%(severity) %(logger) [%(thread)] %(message)\n"};
+    const PatternContext context{{}, Severity::Info, loggerName};
+    fmt::memory_buffer buffer;
+
+    BENCHMARK("severityToString and std::thread::id for every message")
+    {
+        buffer.clear();
+        std::ostringstream threadId;
+        threadId << std::this_thread::get_id();
+        fmt::format_to(std::back_inserter(buffer), "{} {} [{}] {}\n", severityToString(Severity::Info), loggerName,
+                       threadId.str(), "connection pool resized");
+        return buffer.size();
+    };
+
+    BENCHMARK("PatternFormatter with constant names and cached thread id")
+    {
+        buffer.clear();
+        formatter.render(buffer, "connection pool resized", context);
+        return buffer.size();
+    };
+}
@@ -0,0 +1,44 @@
+#include "nealog/Logger.h"
+#include "nealog/Macros.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[!benchmark][RateLimit]";
+
+
+
+TEST_CASE("a warning in a hot loop", TAG)
+{
+    auto logger = std::make_shared<Logger>("svc.db");
+    logger->setSeverity(Severity::Warn);
+    logger->setFormatter(PatternFormatter{"%(time) %(severity) %(logger) [%(thread)] %(message)\n"});
+    logger->addSink(std::make_shared<NoopSink>());
+
+    BENCHMARK("below the severity")
+    {
+        NEALOG_INFO(logger, "pool resized to {} connections", 32);
+    };
+
+    BENCHMARK("suppressed by a rate limit")
+    {
+        NEALOG_WARN_LIMITED(logger, RateLimit(1, 1), "pool resized to {} connections", 32);
+    };
+
+    BENCHMARK("suppressed by every nth")
+    {
+        NEALOG_WARN_LIMITED(logger, EveryN(1000000000), "pool resized to {} connections", 32);
+    };
+
+    BENCHMARK("suppressed by sampling")
+    {
+        NEALOG_WARN_LIMITED(logger, Sampled(0.0), "pool resized to {} connections", 32);
+    };
+
+    BENCHMARK("written")
+    {
+        NEALOG_WARN(logger, "pool resized to {} connections", 32);
+    };
+}
@@ -0,0 +1,218 @@
+#include "nealog/BinaryFileSink.h"
+#include "nealog/IoUringFileSink.h"
+#include "nealog/Logger.h"
+#include "nealog/MmapSink.h"
+#include "nealog/Sink.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG     = "[!benchmark][Sink]";
+constexpr const char* MESSAGE = "2024-01-01 12:00:00.000 INFO  svc.db connection pool resized to 32 connections\n";
+
+
+
+TEST_CASE("write a line to a file", TAG)
+{
+    const auto directory   = std::filesystem::temp_directory_path();
+    const auto streamPath  = (directory / "nealog_bench_stream.log").string();
+    const auto filePath    = (directory / "nealog_bench_file.log").string();
+    const auto mmapPath    = (directory / "nealog_bench_mmap.log").string();
+    const auto ioUringPath = (directory / "nealog_bench_io_uring.log").string();
+
+    {
+        std::ofstream file{streamPath, std::ios::app};
+        StreamSink streamSink{file};
+
+        BENCHMARK("StreamSink over std::ofstream")
+        {
+            streamSink.write(Severity::Info, MESSAGE);
+        };
+    }
+
+    {
+        FileSink fileSink{filePath};
+
+        BENCHMARK("FileSink")
+        {
+            fileSink.write(Severity::Info, MESSAGE);
+        };
+    }
+
+    {
+        IoUringFileSink ioUringSink{ioUringPath};
+
+        BENCHMARK("IoUringFileSink")
+        {
+            ioUringSink.write(Severity::Info, MESSAGE);
+        };
+    }
+
+    {
+        MmapSink mmapSink{mmapPath};
+
+        BENCHMARK("MmapSink")
+        {
+            mmapSink.write(Severity::Info, MESSAGE);
+        };
+    }
+
+    std::filesystem::remove(streamPath);
+    std::filesystem::remove(filePath);
+    std::filesystem::remove(ioUringPath);
+    for (std::uint64_t segment = 1; segment <= findLastSegment(mmapPath); segment++)
+        std::filesystem::remove(mmapPath + "." + std::to_string(segment));
+}
+
+
+
+TEST_CASE("write a burst of lines to a file and flush it", TAG)
+{
+    constexpr int LINES_PER_BURST = 100000;
+    const auto directory          = std::filesystem::temp_directory_path();
+    const auto filePath           = (directory / "nealog_bench_burst_file.log").string();
+    const auto ioUringPath        = (directory / "nealog_bench_burst_io_uring.log").string();
+
+    {
+        FileSink fileSink{filePath};
+
+        BENCHMARK("FileSink")
+        {
+            for (int i = 0; i < LINES_PER_BURST; i++)
+                fileSink.write(Severity::Info, MESSAGE);
+            fileSink.flush();
+        };
+    }
+
+    {
+        IoUringFileSink ioUringSink{ioUringPath};
+
+        BENCHMARK("IoUringFileSink")
+        {
+            for (int i = 0; i < LINES_PER_BURST; i++)
+                ioUringSink.write(Severity::Info, MESSAGE);
+            ioUringSink.flush();
+        };
+    }
+
+    std::filesystem::remove(filePath);
+    std::filesystem::remove(ioUringPath);
+}
+
+
+
+TEST_CASE("write 64 lines one by one or as a batch", TAG)
+{
+    constexpr std::size_t BATCH_SIZE = 64;
+    const auto directory             = std::filesystem::temp_directory_path();
+    const auto streamPath            = (directory / "nealog_bench_batch_stream.log").string();
+    const auto filePath              = (directory / "nealog_bench_batch_file.log").string();
+    const std::vector<SinkRecord> records(BATCH_SIZE, SinkRecord{Severity::Info, MESSAGE});
+
+    {
+        std::ofstream file{streamPath, std::ios::app};
+        StreamSink streamSink{file};
+
+        BENCHMARK("StreamSink write")
+        {
+            for (const SinkRecord& record : records)
+                streamSink.write(record.severity, record.message);
+        };
+
+        BENCHMARK("StreamSink writeBatch")
+        {
+            streamSink.writeBatch(records.data(), records.size());
+        };
+    }
+
+    {
+        // a buffer smaller than the batch, so every batch goes out with writev
+        FileSink fileSink{filePath, FileFlushPolicy{}, 1024};
+
+        BENCHMARK("FileSink write with a small buffer")
+        {
+            for (const SinkRecord& record : records)
+                fileSink.write(record.severity, record.message);
+        };
+
+        BENCHMARK("FileSink writeBatch with a small buffer")
+        {
+            fileSink.writeBatch(records.data(), records.size());
+        };
+    }
+
+    std::filesystem::remove(streamPath);
+    std::filesystem::remove(filePath);
+}
+
+
+
+TEST_CASE("log a call with arguments as text or binary", TAG)
+{
+    const auto directory  = std::filesystem::temp_directory_path();
+    const auto filePath   = (directory / "nealog_bench_text.log").string();
+    const auto binaryPath = (directory / "nealog_bench_binary.nlb").string();
+
+    {
+        Logger logger{"svc.db"};
+        logger.setFormatter(PatternFormatter{"2024-01-01 12:00:00.000 INFO  svc.db %(message)\n"});
+        logger.addSink(std::make_shared<FileSink>(filePath));
+
+        int connections = 0;
+        BENCHMARK("Logger with FileSink")
+        {
+            logger.info("connection pool resized to {} connections", connections++);
+        };
+    }
+
+    {
+        Logger logger{"svc.db"};
+        logger.addSink(std::make_shared<BinaryFileSink>(binaryPath));
+
+        int connections = 0;
+        BENCHMARK("Logger with BinaryFileSink")
+        {
+            logger.info("connection pool resized to {} connections", connections++);
+        };
+    }
+
+    std::filesystem::remove(filePath);
+    std::filesystem::remove(binaryPath);
+}
+
+
+
+TEST_CASE("write a line to a file with or without a sidecar index", TAG)
+{
+    const auto directory   = std::filesystem::temp_directory_path();
+    const auto filePath    = (directory / "nealog_bench_plain.log").string();
+    const auto indexedPath = (directory / "nealog_bench_indexed.log").string();
+
+    {
+        FileSink fileSink{filePath};
+
+        BENCHMARK("FileSink")
+        {
+            fileSink.writeFromLogger("svc.db", Severity::Info, MESSAGE);
+        };
+    }
+
+    {
+        FileSink fileSink{indexedPath, FileFlushPolicy{}, FileSink::DEFAULT_BUFFER_SIZE, FileIndexPolicy{true}};
+
+        BENCHMARK("FileSink with sidecar index")
+        {
+            fileSink.writeFromLogger("svc.db", Severity::Info, MESSAGE);
+        };
+    }
+
+    std::filesystem::remove(filePath);
+    std::filesystem::remove(indexedPath);
+    std::filesystem::remove(indexedPath + SIDECAR_INDEX_SUFFIX);
+}
@@ -0,0 +1,66 @@
+#include "nealog/Logger.h"
+#include "nealog/TcpSink.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <arpa/inet.h>
+#include <memory>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[!benchmark][TcpSink]";
+
+
+
+TEST_CASE("a message sent to a collector on the loopback interface", TAG)
+{
+    // the collector reads and discards everything on one connection
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    ::listen(listener, 1);
+    socklen_t length = sizeof(address);
+    ::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+
+    std::thread collector{[listener] {
+        const int connection = ::accept(listener, nullptr, nullptr);
+        char buffer[64 * 1024];
+        while (::recv(connection, buffer, sizeof(buffer), 0) > 0)
+        {
+        }
+        ::close(connection);
+    }};
+
+    const char* pattern = "%(time) %(severity) %(logger) [%(thread)] %(message)\n";
+    auto makeLogger     = [pattern](Sink::SPtr sink) {
+        auto logger = std::make_unique<Logger>("svc.api");
+        logger->setFormatter(PatternFormatter{pattern});
+        logger->addSink(std::move(sink));
+        return logger;
+    };
+
+    {
+        auto file = makeLogger(SinkFactory::createFileSink("/dev/null"));
+        auto tcp  = makeLogger(std::make_shared<TcpSink>("127.0.0.1", ntohs(address.sin_port),
+                                                         TcpSinkPolicy{64 * 1024 * 1024, TcpOverflow::Block}));
+
+        int request = 0;
+        BENCHMARK("file sink")
+        {
+            file->info("request {} done in {} ms", request++, 1.5);
+        };
+
+        BENCHMARK("tcp sink")
+        {
+            tcp->info("request {} done in {} ms", request++, 1.5);
+        };
+    }
+
+    collector.join();
+    ::close(listener);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "nealog/Logger.h"
+#include "nealog/Record.h"
+#include "nealog/RingBuffer.h"
+#include "nealog/Severity.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nealog
+{
+
+    /*!
+     * Decides what AsyncLogger::log does when the queue is full.
+     */
+    enum class OverflowPolicy
+    {
+        Block, // wait until the worker made room
+        Drop,  // discard the message and count it
+    };
+
+
+
+    /*!
+     * Logger that hands its messages to a background worker instead of
+     * writing them on the calling thread.
+     *
+     * log() only captures the call into a Record inside a bounded lock-free
+     * queue. The worker formats the records and drains them into the sinks, so
+     * neither fmt nor a slow sink stalls the producers. It takes up to
+     * WRITE_BATCH_SIZE records at once and hands them to Sink::writeBatch().
+     * Destroying the logger drains the queue before the worker is joined.
+     * A formatter or sink throwing on the worker costs the records it was
+     * writing, which are counted, but neither the worker nor the process.
+     *
+     * The variadic overloads of LoggerBase capture their arguments and defer
+     * the formatting to the worker, so their format string needs static
+     * storage duration.
+     */
+    class AsyncLogger : public Logger
+    {
+      public:
+        static constexpr std::size_t DEFAULT_QUEUE_CAPACITY = 8192;
+        static constexpr std::size_t WRITE_BATCH_SIZE       = 64;
+
+      public:
+        AsyncLogger(const std::string& name, std::size_t queueCapacity = DEFAULT_QUEUE_CAPACITY,
+                    OverflowPolicy overflowPolicy = OverflowPolicy::Block);
+        ~AsyncLogger() override;
+
+      public:
+        using Logger::log;
+
+        auto log(Severity, const std::string_view& message, const SourceLocation* location = nullptr)
+            -> void override;
+        auto vlog(Severity, fmt::string_view format, fmt::format_args args,
+                  const SourceLocation* location = nullptr) -> void override;
+        auto logRecord(Record& record) -> void override;
+
+        /*!
+         * Blocks until every message enqueued before the call is written and
+         * flushes all sinks. Called by the worker, e.g. by a sink logging a
+         * fatal error, it only flushes the sinks.
+         */
+        auto flush() -> void override;
+
+        /*!
+         * Gives the worker until the deadline to write the queue and flushes
+         * all sinks. The worker is not woken, that would take a lock, it
+         * looks at the queue on its own within ASYNC_WORKER_IDLE_TIMEOUT.
+         */
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
+        auto getDroppedCount() const noexcept -> std::size_t;
+
+        /*!
+         * Records lost because formatting or writing them threw on the worker.
+         */
+        auto getFailedCount() const noexcept -> std::size_t;
+        auto getOverflowPolicy() const noexcept -> OverflowPolicy;
+
+      private:
+        template <typename TCapture>
+        auto enqueue(TCapture&& capture) -> void;
+        auto wakeWorker() -> void;
+        auto run() -> void;
+        auto waitForRecords() -> void;
+
+      private:
+        MpscRingBuffer<Record> queue_;
+        fmt::memory_buffer messageBuffer_{};
+        fmt::memory_buffer outputBuffer_{};
+        // the batch in outputBuffer_, each record ends at its entry in batchEnds_
+        std::vector<SinkRecord> batch_{};
+        std::vector<std::size_t> batchEnds_{};
+        OverflowPolicy overflowPolicy_;
+        std::atomic<bool> running_{true};
+        std::atomic<bool> workerSleeping_{false};
+        std::atomic<std::size_t> writtenCount_{0};
+        std::atomic<std::size_t> droppedCount_{0};
+        std::atomic<std::size_t> failedCount_{0};
+        std::mutex wakeMutex_;
+        std::condition_variable wakeCondition_;
+        std::thread worker_;
+    };
+
+
+
+    template <typename TCapture>
+    auto AsyncLogger::enqueue(TCapture&& capture) -> void
+    {
+        while (!queue_.tryEmplace(capture))
+        {
+            if (overflowPolicy_ == OverflowPolicy::Drop)
+            {
+                droppedCount_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            wakeWorker();
+            std::this_thread::yield();
+        }
+
+        // pairs with the fence in waitForRecords() so either the worker sees
+        // the new record or we see that it went to sleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (workerSleeping_.load(std::memory_order_relaxed))
+            wakeWorker();
+    }
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/AsyncLoggerImpl.h"
+#endif // NEALOG_HEADERONLY
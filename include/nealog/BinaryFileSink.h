@@ -0,0 +1,179 @@
+#pragma once
+
+#include "nealog/Record.h"
+#include "nealog/Severity.h"
+#include "nealog/Sink.h"
+#include "nealog/Varint.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace nealog
+{
+
+    constexpr const char* BINARY_LOG_MAGIC        = "NEALOGB";
+    constexpr std::uint8_t BINARY_LOG_VERSION     = 1;
+    constexpr std::uint32_t BINARY_LOG_BYTE_ORDER = 0x01020304;
+
+
+
+    /*!
+     * Kind of an entry in a binary log file, written as its first byte.
+     * Numbers are LEB128 varints unless noted otherwise.
+     */
+    enum class BinaryEntryType : std::uint8_t
+    {
+        // BINARY_LOG_MAGIC, version byte and BINARY_LOG_BYTE_ORDER in native
+        // byte order. Starts an empty string table.
+        Session = 1,
+        // id and length of a string followed by its characters
+        String = 2,
+        // zigzag encoded nanoseconds since the previous record of the session,
+        // severity byte, ids of the format and the logger name, size of the
+        // arguments followed by the arguments as captured by Record
+        Record = 3,
+    };
+
+
+
+    class BinaryLogFormatException : public std::runtime_error
+    {
+      public:
+        BinaryLogFormatException(const std::string& reason);
+    };
+
+
+
+    /*!
+     * Sink writing the captured calls in a compact binary form instead of text.
+     *
+     * Format strings and logger names are written once into a string table,
+     * records refer to them by id and keep the timestamp, the severity and the
+     * raw argument bytes of the Record. So the logging thread never formats a
+     * message for this sink. Calls with kv() fields are the exception, they
+     * are stored formatted like a text sink shows them. BinaryLogReader and
+     * the nealog-decode tool turn the file back into text. Every sink
+     * appending to a file starts a new session with a string table of its
+     * own. Fixed size values are stored in native byte order, the file has to
+     * be read on a machine of the same byte order. The bytes go through a
+     * FileSink and share its buffering and flush policy.
+     */
+    class BinaryFileSink : public Sink
+    {
+      public:
+        explicit BinaryFileSink(const std::string& path, FileFlushPolicy flushPolicy = {},
+                                std::size_t bufferSize = FileSink::DEFAULT_BUFFER_SIZE);
+
+        // make it non-copyable and non-assignable
+        BinaryFileSink(const BinaryFileSink&) = delete;
+        BinaryFileSink(BinaryFileSink&&)      = delete;
+
+        auto operator=(const BinaryFileSink&) -> BinaryFileSink& = delete;
+        auto operator=(BinaryFileSink&&) -> BinaryFileSink&      = delete;
+
+      public:
+        auto getType() -> SinkType override;
+
+        /*!
+         * Writes an already formatted message as a record without logger name.
+         */
+        auto write(Severity, std::string_view) -> void override;
+        auto writeRecord(const Record& record, std::string_view loggerName) -> void override;
+        auto flush() -> void override;
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
+        auto getPath() const -> const std::string&;
+        auto getWriteErrorCount() const noexcept -> std::size_t;
+
+      private:
+        struct KnownAddress
+        {
+            const char* address = nullptr;
+            std::uint64_t id    = 0;
+        };
+
+      private:
+        auto writeEntry(Severity, std::chrono::system_clock::time_point timestamp, std::string_view format,
+                        std::string_view loggerName, std::string_view arguments) -> void;
+        auto internString(std::string_view value) -> std::uint64_t;
+
+      private:
+        FileSink file_;
+        // owns the strings the keys of stringIds_ point to
+        std::deque<std::string> strings_{};
+        std::unordered_map<std::string_view, std::uint64_t> stringIds_{};
+        // Format strings are mostly literals, so their address finds the id
+        // without hashing them. The content is still compared because a
+        // runtime format string may be replaced at the same address.
+        std::array<KnownAddress, 64> knownAddresses_{};
+        fmt::memory_buffer entries_{};
+        fmt::memory_buffer plainArguments_{};
+        fmt::memory_buffer plainMessage_{};
+        std::int64_t lastTimestamp_ = 0;
+    };
+
+
+
+    /*!
+     * A record read from a binary log file. The views stay valid until the next call to BinaryLogReader::next().
+     */
+    struct BinaryLogEntry
+    {
+        std::chrono::system_clock::time_point timestamp{};
+        Severity severity = Severity::Trace;
+        std::string_view loggerName{};
+        std::string_view format{};
+        std::string_view arguments{};
+
+        /*!
+         * Formats the message like Record::formatMessage() and appends it to out.
+         */
+        auto formatMessage(fmt::memory_buffer& out) const -> void;
+    };
+
+
+
+    /*!
+     * Reads the records of files written by BinaryFileSink in their order.
+     * Malformed or truncated input throws BinaryLogFormatException.
+     */
+    class BinaryLogReader
+    {
+      public:
+        explicit BinaryLogReader(std::istream& input);
+
+      public:
+        /*!
+         * Reads the next record into entry. Returns false at the end of the input.
+         */
+        auto next(BinaryLogEntry& entry) -> bool;
+
+      private:
+        auto readSession() -> void;
+        auto readString() -> void;
+        auto readRecord(BinaryLogEntry& entry) -> void;
+        auto readByte() -> std::uint8_t;
+        auto readVarint() -> std::uint64_t;
+        auto readBytes(std::string& target, std::uint64_t size) -> void;
+        auto lookUpString(std::uint64_t id) const -> std::string_view;
+
+      private:
+        std::istream& input_;
+        std::deque<std::string> strings_{};
+        std::string arguments_{};
+        std::int64_t lastTimestamp_ = 0;
+        bool inSession_             = false;
+    };
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/BinaryFileSinkImpl.h"
+#endif // NEALOG_HEADERONLY
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace nealog
+{
+
+    /*!
+     * Clock the timestamps of log calls are read from.
+     */
+    enum class ClockSource : std::uint8_t
+    {
+        // std::chrono::system_clock, exact but the most expensive one
+        Standard,
+        // CLOCK_REALTIME_COARSE of Linux, as cheap as reading memory but it
+        // only advances every few milliseconds (once per kernel tick)
+        RealtimeCoarse,
+        // the time stamp counter of x86 CPUs scaled to nanoseconds. Each
+        // thread anchors it to the system clock once per second.
+        Tsc,
+    };
+
+
+
+    /*!
+     * True if the platform provides the clock. The standard one is always
+     * there, the TSC needs an x86 CPU with an invariant counter.
+     */
+    auto isClockSourceSupported(ClockSource source) -> bool;
+
+    /*!
+     * Selects the clock for every following timestamp. An unsupported source
+     * selects the standard clock and returns false. Choosing the TSC the
+     * first time calibrates it, which blocks the caller for about 10 ms.
+     */
+    auto setClockSource(ClockSource source) -> bool;
+    auto getClockSource() noexcept -> ClockSource;
+
+    /*!
+     * Reads the selected clock.
+     */
+    auto captureTimestamp() noexcept -> std::chrono::system_clock::time_point;
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/ClockImpl.h"
+#endif // NEALOG_HEADERONLY
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "nealog/Logger.h"
+#include "nealog/LoggerBase.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nealog
+{
+
+    /*!
+     * Registry storing the loggers in a trie keyed on the "."-separated
+     * segments of their names.
+     *
+     * Lookups of existing loggers take no lock and do not allocate: every
+     * node keeps its children in a chain of append-only chunks, each twice
+     * as large as the one before, and publishes a new child by storing its
+     * chunk size with release semantics. Only creating a logger takes a
+     * mutex. No chunk is ever replaced, so the memory of the children grows
+     * linearly with their number and nothing is kept for readers.
+     */
+    class ConcurrentLoggerRegistry : public ParentHolder
+    {
+      public:
+        static constexpr char LOGGER_TREE_SEPARATOR = '.';
+
+      public:
+        ConcurrentLoggerRegistry();
+
+        // make it non-copyable and non-assignable
+        ConcurrentLoggerRegistry(const ConcurrentLoggerRegistry&) = delete;
+        ConcurrentLoggerRegistry(ConcurrentLoggerRegistry&&)      = delete;
+
+        auto operator=(const ConcurrentLoggerRegistry&) -> ConcurrentLoggerRegistry& = delete;
+        auto operator=(ConcurrentLoggerRegistry&&) -> ConcurrentLoggerRegistry&      = delete;
+
+      public:
+        auto getOrCreate(std::string_view name) -> LoggerBase::SPtr;
+
+        /*!
+         * Returns the logger without touching its reference count. The
+         * reference stays valid as long as the registry exists.
+         */
+        auto getOrCreateReference(std::string_view name) -> LoggerBase&;
+
+        /*!
+         * Calls visit with every logger, parents before their children. It
+         * takes no lock and does not allocate, so the crash handler can use
+         * it. Loggers created meanwhile may be missed.
+         */
+        template <typename TVisit>
+        auto forEachLogger(TVisit&& visit) const -> void;
+
+      private:
+        struct Node;
+
+        struct ChildChunk
+        {
+            explicit ChildChunk(std::size_t chunkCapacity)
+                : children(new Node*[chunkCapacity]), capacity(chunkCapacity)
+            {
+            }
+
+            // the first size entries are set, readers load size first
+            std::unique_ptr<Node*[]> children;
+            std::size_t capacity;
+            std::atomic<std::size_t> size{0};
+            std::atomic<ChildChunk*> next{nullptr};
+        };
+
+        struct Node
+        {
+            std::string segment{};
+            LoggerBase::SPtr logger = nullptr;
+            std::atomic<ChildChunk*> children{nullptr};
+            // only touched under the creation mutex
+            ChildChunk* lastChunk = nullptr;
+        };
+
+        static constexpr std::size_t FIRST_CHILD_CHUNK_CAPACITY = 4;
+
+      private:
+        auto getOrCreateNode(std::string_view name) -> Node*;
+        auto find(std::string_view name) const -> Node*;
+        auto create(std::string_view name) -> Node*;
+        auto createChild(Node& parent, std::string_view segment, std::string_view name) -> Node*;
+        static auto findChild(const Node& parent, std::string_view segment) -> Node*;
+
+        template <typename TVisit>
+        static auto visitNode(const Node& node, TVisit& visit) -> void;
+
+      private:
+        std::mutex creationMutex_;
+        std::shared_ptr<GenerationCounter> generation_ = std::make_shared<GenerationCounter>(0);
+        std::vector<std::unique_ptr<Node>> nodes_{};
+        std::vector<std::unique_ptr<ChildChunk>> childChunks_{};
+        Node* root_ = nullptr;
+    };
+
+
+
+    template <typename TVisit>
+    auto ConcurrentLoggerRegistry::forEachLogger(TVisit&& visit) const -> void
+    {
+        visitNode(*root_, visit);
+    }
+
+
+
+    template <typename TVisit>
+    auto ConcurrentLoggerRegistry::visitNode(const Node& node, TVisit& visit) -> void
+    {
+        visit(*node.logger);
+
+        for (const ChildChunk* chunk = node.children.load(std::memory_order_acquire); chunk != nullptr;
+             chunk                   = chunk->next.load(std::memory_order_acquire))
+        {
+            const std::size_t size = chunk->size.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < size; i++)
+                visitNode(*chunk->children[i], visit);
+        }
+    }
+
+
+
+    /*!
+     * Process-wide registry behind NEALOG_LOGGER. It is created on first use
+     * and destroyed with the other function-local statics at exit.
+     */
+    auto getDefaultRegistry() -> ConcurrentLoggerRegistry&;
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/ConcurrentLoggerRegistryImpl.h"
+#endif // NEALOG_HEADERONLY
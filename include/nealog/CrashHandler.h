@@ -0,0 +1,62 @@
+#pragma once
+
+#include "nealog/ConcurrentLoggerRegistry.h"
+#include "nealog/LoggerBase.h"
+
+#include <chrono>
+#include <cstddef>
+
+namespace nealog
+{
+
+    // time the crash handler gives queues to drain and locked sinks to become free
+    constexpr std::chrono::milliseconds CRASH_FLUSH_TIMEOUT{2000};
+    constexpr std::size_t CRASH_WATCHED_LOGGER_SLOTS = 64;
+    constexpr std::size_t CRASH_SIGNAL_STACK_SIZE    = 64 * 1024;
+
+
+
+    /*!
+     * Installs handlers for SIGSEGV, SIGABRT, SIGFPE, SIGILL and SIGBUS
+     * which flush every logger of the registry and every watched logger.
+     * Then the signal goes on to the handler installed before, so by default
+     * the process dies of it as it would have without nealog. Installing it
+     * again replaces the registry. Call it before other threads start.
+     *
+     * Everything else keeps buffering, only a crash flushes. The handler
+     * takes no lock a crashed thread may hold: it tries the mutex of each
+     * sink until CRASH_FLUSH_TIMEOUT has passed and skips it if the sink
+     * stays locked. FileSink and BinaryFileSink write their buffer with
+     * write(2) alone. Other sinks flush with calls which are not
+     * async-signal-safe, e.g. the ones of std::ostream, so for them it is a
+     * best effort. The handler runs on an alternate stack to survive a stack
+     * overflow, which covers the thread installing it.
+     */
+    auto installCrashHandler(ConcurrentLoggerRegistry& registry = getDefaultRegistry()) -> void;
+
+    /*!
+     * Restores the handlers installed before installCrashHandler().
+     */
+    auto uninstallCrashHandler() -> void;
+
+    /*!
+     * Adds a logger outside the registry to the ones the crash handler
+     * flushes, AsyncLoggers add themselves. Returns false if all
+     * CRASH_WATCHED_LOGGER_SLOTS are taken. unwatchForCrash() has to remove
+     * the logger before it is destroyed.
+     */
+    auto watchForCrash(LoggerBase& logger) -> bool;
+    auto unwatchForCrash(LoggerBase& logger) -> void;
+
+    /*!
+     * What the crash handler does before it hands the signal on: flushes the
+     * watched loggers, whose queues are drained first, and then the loggers
+     * of the registry.
+     */
+    auto flushForCrash() -> void;
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/CrashHandlerImpl.h"
+#endif // NEALOG_HEADERONLY
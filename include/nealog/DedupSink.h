@@ -0,0 +1,171 @@
+#pragma once
+
+#include "nealog/Formatter.h"
+#include "nealog/Record.h"
+#include "nealog/Severity.h"
+#include "nealog/Sink.h"
+#include "nealog/SourceLocation.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace nealog
+{
+
+    /*!
+     * Configures which repeated messages a DedupSink collapses.
+     */
+    struct DedupPolicy
+    {
+        // repeats of a message within this time after it was written are collapsed
+        std::chrono::milliseconds window{1000};
+        // distinct messages tracked at most, the oldest one is reported early to make room. 0 disables collapsing.
+        std::size_t capacity = 1024;
+    };
+
+
+
+    class DedupPatternException : public std::runtime_error
+    {
+      public:
+        DedupPatternException();
+    };
+
+
+
+    /*!
+     * Sink collapsing repeated messages before they reach another sink.
+     *
+     * The first call with a message is written. Calls repeating it with the
+     * same severity and logger within the window are dropped and counted.
+     * Once the window closed the sink writes one line "repeated <n> times:
+     * <message>" instead of them. A thread of the sink closes the windows at
+     * their end, a window also closes when the message is one of the
+     * capacity tracked ones for the longest time and a new one needs room,
+     * and on flush() or the destruction of the sink.
+     *
+     * The sink takes records, so it compares the messages without the
+     * pattern of the logger, whose timestamps would make every line differ.
+     * A target writing text therefore needs a pattern of its own for the
+     * lines, usually the one of the logger, while targets taking records
+     * themselves, e.g. a JsonSink, get the records. Messages
+     * are looked up by hash in a table of fixed size allocated with the
+     * sink, whose strings keep their memory when the slot is reused.
+     */
+    class DedupSink : public Sink
+    {
+      public:
+        /*!
+         * Renders the lines for the target with the pattern of formatter.
+         */
+        DedupSink(Sink::SPtr target, DedupPolicy policy, const PatternFormatter& formatter);
+
+        /*!
+         * For a target taking records, which renders them itself. Throws a
+         * DedupPatternException for any other target.
+         */
+        explicit DedupSink(Sink::SPtr target, DedupPolicy policy = {});
+
+        /*!
+         * Stops the thread and writes the lines for the repeats counted so far.
+         */
+        ~DedupSink() override;
+
+        // make it non-copyable and non-assignable
+        DedupSink(const DedupSink&) = delete;
+        DedupSink(DedupSink&&)      = delete;
+
+        auto operator=(const DedupSink&) -> DedupSink& = delete;
+        auto operator=(DedupSink&&) -> DedupSink&      = delete;
+
+      public:
+        auto getType() -> SinkType override;
+
+        /*!
+         * Collapses the message like a call without logger and call site.
+         */
+        auto write(Severity, std::string_view) -> void override;
+        auto writeRecord(const Record& record, std::string_view loggerName) -> void override;
+
+        /*!
+         * Closes every window, writing the lines for the repeats counted so
+         * far, and flushes the target.
+         */
+        auto flush() -> void override;
+
+        /*!
+         * Like flush(), but skips the windows if the sink stays locked until
+         * the deadline and flushes the target with its flushOnCrash().
+         */
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
+        auto getTarget() const -> const Sink::SPtr&;
+        auto getPolicy() const noexcept -> const DedupPolicy&;
+
+        /*!
+         * Calls dropped as repeats.
+         */
+        auto getCollapsedCount() const noexcept -> std::size_t;
+
+      private:
+        struct Entry
+        {
+            std::uint64_t hash = 0;
+            Severity severity  = Severity::Trace;
+            std::string loggerName{};
+            std::string message{};
+            const SourceLocation* location = nullptr;
+            std::chrono::system_clock::time_point windowEnd{};
+            std::uint64_t repeats = 0;
+        };
+
+      private:
+        auto isRepeat(const Record& record, std::string_view loggerName, std::string_view message) -> bool;
+        auto closeWindowsUntil(std::chrono::system_clock::time_point timestamp) -> void;
+
+        /*!
+         * Closes the windows once they end, until the sink is destroyed.
+         */
+        auto run() -> void;
+        auto closeOldestWindow() -> void;
+        auto findSlot(std::uint64_t hash) const -> std::size_t;
+        auto eraseSlot(std::uint64_t hash, std::size_t slot) -> void;
+        auto forward(const Record& record, std::string_view loggerName, std::string_view message) -> void;
+
+      private:
+        Sink::SPtr target_;
+        const DedupPolicy policy_;
+        PatternFormatter formatter_;
+        // ring of the tracked messages in the order they were first written
+        std::vector<Entry> entries_;
+        std::size_t oldest_ = 0;
+        std::size_t size_   = 0;
+        // open addressing table of slot + 1 by hash, 0 is free. At most half of it is taken.
+        std::vector<std::uint32_t> slotByHash_;
+        std::size_t hashMask_ = 0;
+        // the line written for the repeats of a message
+        Record repeatsRecord_{};
+        fmt::memory_buffer repeatsMessage_;
+        // the rendered line handed to the target
+        fmt::memory_buffer line_;
+        std::atomic<std::size_t> collapsedCount_{0};
+
+        // notified when the first message is tracked and on destruction, guarded by mutex_
+        std::condition_variable windowCondition_;
+        bool running_ = true;
+        std::thread worker_;
+    };
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/DedupSinkImpl.h"
+#endif // NEALOG_HEADERONLY
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace nealog
+{
+
+    /*!
+     * Frees the snapshots a logger replaces while other threads may still
+     * read them, i.e. its sink lists and flight recorders.
+     *
+     * A thread reads such a snapshot only inside a ReadGuard, which announces
+     * the global epoch in a slot of the thread. A replaced snapshot is retired
+     * with the epoch current at that time. The epoch advances once every
+     * thread inside a guard announced the current one, so no guard can see a
+     * snapshot anymore once the epoch is two past the one it was retired in,
+     * and it is freed. retire() collects, so a replaced snapshot is freed
+     * right away if no thread reads one at that moment, and else by one of the
+     * next retirements of any logger or by reclaim().
+     */
+    class EpochReclaimer
+    {
+      private:
+        static constexpr std::uint64_t IDLE = ~std::uint64_t{0};
+
+        struct ThreadSlot
+        {
+            // the epoch announced by the outermost guard, IDLE outside of one
+            std::atomic<std::uint64_t> epoch{IDLE};
+            // cleared when the thread exits, another thread may then take the slot
+            std::atomic<bool> inUse{true};
+            ThreadSlot* next = nullptr;
+            // only touched by the thread owning the slot
+            unsigned depth = 0;
+        };
+
+        struct ThreadSlotOwner
+        {
+            ~ThreadSlotOwner();
+
+            ThreadSlot* slot;
+        };
+
+      public:
+        /*!
+         * Keeps every snapshot the thread loads while it exists from being
+         * freed. Guards may nest, e.g. for a sink logging from inside write().
+         */
+        class ReadGuard
+        {
+          public:
+            ReadGuard() : slot_{EpochReclaimer::getInstance().enter()}
+            {
+            }
+
+            ~ReadGuard()
+            {
+                EpochReclaimer::leave(slot_);
+            }
+
+            // make it non-copyable and non-assignable
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard(ReadGuard&&)      = delete;
+
+            auto operator=(const ReadGuard&) -> ReadGuard& = delete;
+            auto operator=(ReadGuard&&) -> ReadGuard&      = delete;
+
+          private:
+            ThreadSlot& slot_;
+        };
+
+      public:
+        /*!
+         * Never destroyed, so loggers destroyed at exit can still retire their snapshots.
+         */
+        static auto getInstance() -> EpochReclaimer&;
+
+        /*!
+         * Frees the snapshot once no guard can see it anymore. The caller
+         * must have replaced every pointer to it which guards load.
+         */
+        auto retire(std::shared_ptr<const void> snapshot) -> void;
+
+        /*!
+         * Frees the retired snapshots no guard can see anymore.
+         */
+        auto reclaim() -> void;
+
+        /*!
+         * Snapshots retired but not yet freed.
+         */
+        auto getRetiredCount() -> std::size_t;
+
+      private:
+        EpochReclaimer() = default;
+
+        auto enter() -> ThreadSlot&
+        {
+            thread_local ThreadSlotOwner owner{acquireSlot()};
+
+            ThreadSlot& slot = *owner.slot;
+            if (slot.depth++ == 0)
+            {
+                slot.epoch.store(epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+                // pairs with the fence in tryAdvance(): either the epoch is not
+                // advanced past the announced one, or the snapshot loads below
+                // see the replacement of every snapshot retired before
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            return slot;
+        }
+
+        static auto leave(ThreadSlot& slot) noexcept -> void
+        {
+            if (--slot.depth == 0)
+                slot.epoch.store(IDLE, std::memory_order_release);
+        }
+
+        /*!
+         * Takes the slot of an exited thread or adds a new one.
+         */
+        auto acquireSlot() -> ThreadSlot*;
+
+        /*!
+         * Advances the epoch if every thread inside a guard announced the
+         * current one. Called with mutex_ held.
+         */
+        auto tryAdvance() -> bool;
+
+        /*!
+         * Moves the snapshots no guard can see anymore to freed. Called with mutex_ held.
+         */
+        auto collect(std::vector<std::shared_ptr<const void>>& freed) -> void;
+
+      private:
+        std::atomic<std::uint64_t> epoch_{0};
+        // never shrinks, the slots of exited threads are taken again
+        std::atomic<ThreadSlot*> slots_{nullptr};
+
+        std::mutex mutex_;
+        std::vector<std::pair<std::uint64_t, std::shared_ptr<const void>>> retired_{};
+    };
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/EpochReclaimerImpl.h"
+#endif // NEALOG_HEADERONLY
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "nealog/Record.h"
+#include "nealog/Severity.h"
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace nealog
+{
+
+    /*!
+     * Configures the flight recorder of a logger.
+     */
+    struct FlightRecorderPolicy
+    {
+        // calls kept at most, the oldest one is overwritten. 0 disables the recorder.
+        std::size_t capacity = 0;
+        // calls of this severity or a higher one are kept if they are below the severity of the logger
+        Severity keepFrom = Severity::Trace;
+        // a call of this severity or a higher one which reaches the sinks writes the kept calls in front of it
+        Severity trigger = Severity::Error;
+    };
+
+
+
+    /*!
+     * Fixed size ring of captured calls a logger keeps instead of dropping
+     * them for being below its severity.
+     *
+     * Keeping a call costs capturing it into a Record and moving that into
+     * the ring under a lock, it is formatted only if the ring is written. So
+     * a logger at Info can keep the Debug calls leading up to an error for a
+     * fraction of the cost of writing them.
+     */
+    class FlightRecorder
+    {
+      public:
+        explicit FlightRecorder(const FlightRecorderPolicy& policy);
+
+        // make it non-copyable and non-assignable
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder(FlightRecorder&&)      = delete;
+
+        auto operator=(const FlightRecorder&) -> FlightRecorder& = delete;
+        auto operator=(FlightRecorder&&) -> FlightRecorder&      = delete;
+
+      public:
+        /*!
+         * Moves the record into the ring, replacing the oldest one if it is full.
+         */
+        auto keep(Record& record) -> void;
+
+        /*!
+         * Moves the kept records to records, the oldest first, and empties the ring.
+         */
+        auto takeAll(std::vector<Record>& records) -> void;
+
+        auto getSize() -> std::size_t;
+        auto getPolicy() const noexcept -> const FlightRecorderPolicy&;
+
+      private:
+        const FlightRecorderPolicy policy_;
+        std::mutex mutex_;
+        std::vector<Record> records_;
+        // slot the next record is moved to
+        std::size_t next_ = 0;
+        std::size_t size_ = 0;
+    };
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/FlightRecorderImpl.h"
+#endif // NEALOG_HEADERONLY
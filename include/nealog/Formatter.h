@@ -1,9 +1,23 @@
 #pragma once
 
 #include "fmt/compile.h"
+#include "nealog/Clock.h"
+#include "nealog/Severity.h"
+#include "nealog/SourceLocation.h"
+#include "nealog/Thread.h"
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <fmt/core.h>
+#include <fmt/format.h>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 
 #define nlFormat(msg, ...) nealog::Formatter().format(msg, __VA_ARGS__)
@@ -29,7 +43,204 @@ namespace nealog
 
 
 
-    constexpr const char* MESSAGE_SUBSTITUTOR = "%(message)";
+    constexpr const char* MESSAGE_SUBSTITUTOR            = "%(message)";
+    constexpr const char* TIME_SUBSTITUTOR               = "%(time)";
+    constexpr const char* TIME_MICROSECONDS_SUBSTITUTOR  = "%(time.us)";
+    constexpr const char* TIME_NANOSECONDS_SUBSTITUTOR   = "%(time.ns)";
+    constexpr const char* SEVERITY_SUBSTITUTOR           = "%(severity)";
+    constexpr const char* SEVERITY_UPPERCASE_SUBSTITUTOR = "%(SEVERITY)";
+    constexpr const char* LOGGER_SUBSTITUTOR             = "%(logger)";
+    constexpr const char* THREAD_SUBSTITUTOR             = "%(thread)";
+    constexpr const char* THREAD_NAME_SUBSTITUTOR        = "%(thread.name)";
+    constexpr const char* FILE_SUBSTITUTOR               = "%(file)";
+    constexpr const char* LINE_SUBSTITUTOR               = "%(line)";
+    constexpr const char* FUNCTION_SUBSTITUTOR           = "%(function)";
+    constexpr const char* PLACEHOLDER_START              = "%(";
+
+
+
+    enum class PatternTokenType : std::uint8_t
+    {
+        Literal,
+        Message,
+        // local time like 2024-05-01 12:00:00.123
+        Time,
+        // like Time with six fractional digits
+        TimeMicroseconds,
+        // like Time with nine fractional digits
+        TimeNanoseconds,
+        Severity,
+        SeverityUppercase,
+        Logger,
+        // the id of the thread
+        Thread,
+        // the name set with setThreadName() or else the id
+        ThreadName,
+        // file, line and function of the call, empty for calls outside of the logging macros
+        File,
+        Line,
+        Function,
+    };
+
+
+
+    struct PatternPlaceholder
+    {
+        std::string_view name;
+        PatternTokenType type;
+    };
+
+    constexpr std::array<PatternPlaceholder, 12> PATTERN_PLACEHOLDERS{{
+        {MESSAGE_SUBSTITUTOR, PatternTokenType::Message},
+        {TIME_SUBSTITUTOR, PatternTokenType::Time},
+        {TIME_MICROSECONDS_SUBSTITUTOR, PatternTokenType::TimeMicroseconds},
+        {TIME_NANOSECONDS_SUBSTITUTOR, PatternTokenType::TimeNanoseconds},
+        {SEVERITY_SUBSTITUTOR, PatternTokenType::Severity},
+        {SEVERITY_UPPERCASE_SUBSTITUTOR, PatternTokenType::SeverityUppercase},
+        {LOGGER_SUBSTITUTOR, PatternTokenType::Logger},
+        {THREAD_SUBSTITUTOR, PatternTokenType::Thread},
+        {THREAD_NAME_SUBSTITUTOR, PatternTokenType::ThreadName},
+        {FILE_SUBSTITUTOR, PatternTokenType::File},
+        {LINE_SUBSTITUTOR, PatternTokenType::Line},
+        {FUNCTION_SUBSTITUTOR, PatternTokenType::Function},
+    }};
+
+
+
+    /*!
+     * What a pattern may show about a message besides its text. All of it
+     * is either constant or captured with the call, so placeholders only
+     * copy text and never look anything up.
+     */
+    struct PatternContext
+    {
+        // Read from the selected clock while rendering if it is unset.
+        std::chrono::system_clock::time_point timestamp{};
+        Severity severity = Severity::Trace;
+        std::string_view loggerName{};
+        // the rendering thread if unset
+        const ThreadIdentity* thread   = nullptr;
+        const SourceLocation* location = nullptr;
+    };
+
+
+
+    /*!
+     * Appends the local time of timestamp like 2024-05-01 12:00:00.123 with
+     * fractionDigits (at most 9) digits after the seconds. The text up to
+     * the seconds is cached per thread and only rendered again when the
+     * second changes, otherwise the fractional digits are patched into it.
+     */
+    auto appendTimestamp(fmt::memory_buffer& out, std::chrono::system_clock::time_point timestamp,
+                         unsigned fractionDigits) -> void;
+
+    /*!
+     * Appends what a severity, logger, thread or source location placeholder shows of context.
+     */
+    auto appendContext(fmt::memory_buffer& out, PatternTokenType type, const PatternContext& context) -> void;
+
+
+
+    /*!
+     * A literal span of the pattern or a placeholder. Offset and length point into the pattern.
+     */
+    struct PatternToken
+    {
+        PatternTokenType type = PatternTokenType::Literal;
+        std::size_t offset    = 0;
+        std::size_t length    = 0;
+    };
+
+
+
+    /*!
+     * Splits the pattern into literal spans and placeholders and hands every
+     * token to emit. An empty pattern consists of the message alone, unknown
+     * placeholders are kept as literals. Usable in constant expressions.
+     */
+    template <typename TEmit>
+    constexpr auto tokenizePattern(std::string_view pattern, TEmit&& emit) -> void
+    {
+        if (pattern.empty())
+        {
+            emit(PatternToken{PatternTokenType::Message, 0, 0});
+            return;
+        }
+
+        const std::string_view placeholderStart{PLACEHOLDER_START};
+        std::size_t literalStart = 0;
+        std::size_t position     = pattern.find(placeholderStart);
+
+        while (position != std::string_view::npos)
+        {
+            const PatternPlaceholder* placeholder = nullptr;
+            for (const PatternPlaceholder& candidate : PATTERN_PLACEHOLDERS)
+            {
+                if (pattern.compare(position, candidate.name.size(), candidate.name) == 0)
+                {
+                    placeholder = &candidate;
+                    break;
+                }
+            }
+
+            if (placeholder == nullptr)
+            {
+                position = pattern.find(placeholderStart, position + placeholderStart.size());
+                continue;
+            }
+
+            if (position > literalStart)
+                emit(PatternToken{PatternTokenType::Literal, literalStart, position - literalStart});
+
+            emit(PatternToken{placeholder->type, position, placeholder->name.size()});
+            literalStart = position + placeholder->name.size();
+            position     = pattern.find(placeholderStart, literalStart);
+        }
+
+        if (literalStart < pattern.size())
+            emit(PatternToken{PatternTokenType::Literal, literalStart, pattern.size() - literalStart});
+    }
+
+
+
+    /*!
+     * Appends the tokens to out in a single pass. appendMessage(out) is called for every message placeholder.
+     */
+    template <typename TAppendMessage>
+    auto renderPattern(fmt::memory_buffer& out, std::string_view pattern, const PatternToken* begin,
+                       const PatternToken* end, const PatternContext& context, TAppendMessage&& appendMessage)
+        -> void
+    {
+        std::chrono::system_clock::time_point timestamp = context.timestamp;
+
+        for (const PatternToken* token = begin; token != end; ++token)
+        {
+            switch (token->type)
+            {
+            case PatternTokenType::Literal:
+                out.append(pattern.data() + token->offset, pattern.data() + token->offset + token->length);
+                break;
+            case PatternTokenType::Message:
+                appendMessage(out);
+                break;
+            case PatternTokenType::Time:
+            case PatternTokenType::TimeMicroseconds:
+            case PatternTokenType::TimeNanoseconds:
+                if (timestamp == std::chrono::system_clock::time_point{})
+                    timestamp = captureTimestamp();
+
+                appendTimestamp(out, timestamp,
+                                token->type == PatternTokenType::Time               ? 3
+                                : token->type == PatternTokenType::TimeMicroseconds ? 6
+                                                                                    : 9);
+                break;
+            default:
+                appendContext(out, token->type, context);
+            }
+        }
+    }
+
+
 
     class PatternFormatter : public Formatter
     {
@@ -45,23 +256,91 @@ namespace nealog
         template <typename... TArg>
         auto format(const std::string_view& msg, TArg&&... args) -> std::string
         {
-            std::string messageToFormat{msg};
-
-            if (!pattern_.empty())
-            {
-                messageToFormat = wrapMessageWithPattern(msg);
-            }
+            fmt::memory_buffer out;
+            formatTo(out, msg, std::forward<TArg>(args)...);
+            return fmt::to_string(out);
+        }
 
-            return Formatter::format(messageToFormat, std::forward<TArg>(args)...);
+        /*!
+         * Formats msg with args and appends it wrapped into the pattern to out.
+         */
+        template <typename... TArg>
+        auto formatTo(fmt::memory_buffer& out, std::string_view msg, TArg&&... args) const -> void
+        {
+            vformatTo(out, msg, fmt::make_format_args(args...));
         }
 
+        auto vformatTo(fmt::memory_buffer& out, fmt::string_view msg, fmt::format_args args,
+                       const PatternContext& context = {}) const -> void;
+
+        /*!
+         * Appends the already formatted message wrapped into the pattern to out.
+         */
+        auto render(fmt::memory_buffer& out, std::string_view message, const PatternContext& context = {}) const
+            -> void;
+
         auto getPattern() const -> const std::string&;
 
       private:
-        auto wrapMessageWithPattern(const std::string_view& msg) -> std::string;
+        std::string pattern_{};
+        std::vector<PatternToken> tokens_{};
+    };
+
+
+
+    /*!
+     * Pattern that is tokenized at compile time:
+     *
+     *     constexpr nealog::StaticPattern<> pattern{"[%(message)]"};
+     *
+     * MaxTokens bounds the number of literal spans and placeholders; a
+     * pattern with more tokens does not compile in a constant expression.
+     */
+    template <std::size_t MaxTokens = 16>
+    class StaticPattern
+    {
+      public:
+        constexpr explicit StaticPattern(std::string_view pattern) : pattern_{pattern}
+        {
+            tokenizePattern(pattern, [this](PatternToken token) constexpr {
+                if (tokenCount_ == MaxTokens)
+                    throw std::length_error("pattern has more tokens than MaxTokens");
+                tokens_[tokenCount_++] = token;
+            });
+        }
+
+        template <typename... TArg>
+        auto formatTo(fmt::memory_buffer& out, std::string_view msg, TArg&&... args) const -> void
+        {
+            renderPattern(out, pattern_, tokens_.data(), tokens_.data() + tokenCount_, {},
+                          [&](fmt::memory_buffer& buffer) {
+                              fmt::vformat_to(std::back_inserter(buffer), msg, fmt::make_format_args(args...));
+                          });
+        }
+
+        auto render(fmt::memory_buffer& out, std::string_view message, const PatternContext& context = {}) const
+            -> void
+        {
+            renderPattern(out, pattern_, tokens_.data(), tokens_.data() + tokenCount_, context,
+                          [&](fmt::memory_buffer& buffer) {
+                              buffer.append(message.data(), message.data() + message.size());
+                          });
+        }
+
+        constexpr auto getPattern() const noexcept -> std::string_view
+        {
+            return pattern_;
+        }
+
+        constexpr auto getTokenCount() const noexcept -> std::size_t
+        {
+            return tokenCount_;
+        }
 
       private:
-        std::string pattern_{};
+        std::string_view pattern_;
+        std::array<PatternToken, MaxTokens> tokens_{};
+        std::size_t tokenCount_ = 0;
     };
 
 
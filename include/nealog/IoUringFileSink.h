@@ -0,0 +1,150 @@
+#pragma once
+
+#include "nealog/Severity.h"
+#include "nealog/Sink.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+
+namespace nealog
+{
+
+    /*!
+     * What an IoUringFileSink does after writing a buffer.
+     */
+    enum class FileDurability
+    {
+        None,      // leave it to the page cache
+        Fdatasync, // sync the data and the metadata needed to read it
+        Fsync,     // sync the data and all metadata
+    };
+
+
+
+    /*!
+     * File sink handing full buffers to io_uring instead of writing them itself.
+     *
+     * Messages are collected like in FileSink, including the FileFlushTimer
+     * for the interval of the flush policy. A full buffer, one the flush
+     * policy fires on or flush() is submitted as a write at the end of the
+     * file and the sink continues with the next free buffer, so several
+     * buffers can be in flight while the writing thread never waits for the
+     * disk unless all of them are. With a durability other than None every
+     * write is linked with a fsync or fdatasync entry and its buffer is free
+     * again once that completed.
+     *
+     * If the kernel does not support io_uring the buffers are written with
+     * pwrite (and synced) synchronously instead. The same happens once
+     * waiting for a completion failed MAX_ENTER_FAILURES times in a row: the
+     * entries the kernel did not take yet are written synchronously and the
+     * ring is given up. The sink keeps its own file offset, so the file must
+     * not be appended to by anyone else.
+     */
+    class IoUringFileSink : public Sink
+    {
+      public:
+        static constexpr std::size_t DEFAULT_BUFFER_SIZE  = 1024 * 1024;
+        static constexpr std::size_t DEFAULT_BUFFER_COUNT = 4;
+        static constexpr unsigned MAX_ENTER_FAILURES      = 3;
+
+      public:
+        explicit IoUringFileSink(const std::string& path, FileFlushPolicy flushPolicy = {},
+                                 FileDurability durability = FileDurability::None,
+                                 std::size_t bufferSize    = DEFAULT_BUFFER_SIZE,
+                                 std::size_t bufferCount   = DEFAULT_BUFFER_COUNT);
+        ~IoUringFileSink() override;
+
+        // make it non-copyable and non-assignable
+        IoUringFileSink(const IoUringFileSink&) = delete;
+        IoUringFileSink(IoUringFileSink&&)      = delete;
+
+        auto operator=(const IoUringFileSink&) -> IoUringFileSink& = delete;
+        auto operator=(IoUringFileSink&&) -> IoUringFileSink&      = delete;
+
+      public:
+        auto getType() -> SinkType override;
+        auto write(Severity, std::string_view) -> void override;
+        auto writeBatch(const SinkRecord* records, std::size_t count) -> void override;
+
+        /*!
+         * Submits the current buffer and waits until every buffer is written and synced.
+         */
+        auto flush() -> void override;
+
+        /*!
+         * Writes the current buffer with pwrite alone and waits for the
+         * buffers in flight until the deadline without entering the ring.
+         */
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
+        auto getPath() const -> const std::string&;
+        auto isUsingIoUring() const noexcept -> bool;
+        auto getWriteErrorCount() const noexcept -> std::size_t;
+
+      private:
+        struct Ring;
+
+        struct Buffer
+        {
+            std::unique_ptr<char[]> data;
+            std::size_t size     = 0;
+            std::uint64_t offset = 0;
+            // completions still expected for the submitted content
+            unsigned pendingCompletions = 0;
+        };
+
+      private:
+        auto append(Severity, std::string_view message) -> void;
+        auto submitBuffer() -> void;
+        auto submitToRing(Buffer& buffer, std::uint64_t bufferIndex) -> void;
+        auto writeSynchronously(const char* data, std::size_t size, std::uint64_t offset) -> void;
+        auto syncSynchronously() -> void;
+        auto reapCompletions() -> void;
+
+        /*!
+         * Waits for at least one completion and reaps it. Gives the ring up
+         * after MAX_ENTER_FAILURES failed waits in a row.
+         */
+        auto waitForCompletions() -> void;
+
+        /*!
+         * Writes the entries the kernel did not take synchronously, waits for
+         * the ones it took and continues without the ring.
+         */
+        auto abandonRing() -> void;
+        auto nextFreeBuffer() -> std::size_t;
+        auto flushIfDue() -> void override;
+
+      private:
+        std::string path_;
+        FileFlushPolicy flushPolicy_;
+        FileDurability durability_;
+        int fileDescriptor_ = -1;
+        std::uint64_t fileOffset_ = 0;
+        std::unique_ptr<Ring> ring_;
+        // failed waits for a completion in a row
+        unsigned enterFailures_ = 0;
+        std::atomic<bool> usingIoUring_{false};
+        std::vector<Buffer> buffers_;
+        std::size_t bufferCapacity_;
+        std::size_t currentBuffer_ = 0;
+        std::chrono::steady_clock::time_point oldestBufferedAt_{};
+        // set while the FileFlushTimer has a deadline of this sink
+        bool flushScheduled_ = false;
+        std::atomic<std::size_t> writeErrorCount_{0};
+    };
+
+} // namespace nealog
+
+#endif // __linux__
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/IoUringFileSinkImpl.h"
+#endif // NEALOG_HEADERONLY
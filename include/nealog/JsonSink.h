@@ -0,0 +1,112 @@
+#pragma once
+
+#include "nealog/Record.h"
+#include "nealog/Severity.h"
+#include "nealog/Sink.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fmt/format.h>
+#include <string_view>
+
+namespace nealog
+{
+
+    /*!
+     * Instruction set the JSON string escaping runs on.
+     */
+    enum class JsonEscapeKernel : std::uint8_t
+    {
+        // one byte at a time, works everywhere
+        Scalar,
+        // 16 bytes at a time, part of every x86-64 CPU
+        Sse2,
+        // 32 bytes at a time, chosen at runtime if the CPU has it
+        Avx2,
+    };
+
+
+
+    /*!
+     * True if the kernel is compiled in and the CPU runs it.
+     */
+    auto isJsonEscapeKernelSupported(JsonEscapeKernel kernel) -> bool;
+
+    /*!
+     * Fastest supported kernel, detected once.
+     */
+    auto getJsonEscapeKernel() -> JsonEscapeKernel;
+
+    /*!
+     * Appends text to out with quotation marks, backslashes and control
+     * characters escaped as JSON requires. Every other byte is copied, so
+     * text is expected to be UTF-8 already. The overload with a kernel is
+     * for tests and benchmarks, the kernel has to be supported.
+     */
+    auto appendJsonEscaped(fmt::memory_buffer& out, std::string_view text) -> void;
+    auto appendJsonEscaped(fmt::memory_buffer& out, std::string_view text, JsonEscapeKernel kernel) -> void;
+
+    /*!
+     * Appends text as quoted and escaped JSON string.
+     */
+    auto appendJsonString(fmt::memory_buffer& out, std::string_view text) -> void;
+
+    /*!
+     * Appends a captured value as JSON. Numbers are written independent of
+     * the locale, doubles which are not finite as null. Chars and pointers
+     * become strings.
+     */
+    auto appendJsonValue(fmt::memory_buffer& out, const ArgumentValue& value) -> void;
+
+    /*!
+     * Appends the time as UTC in ISO 8601 with microseconds, like 2024-05-01T12:00:00.250000Z.
+     */
+    auto appendIsoTimestamp(fmt::memory_buffer& out, std::chrono::system_clock::time_point timestamp) -> void;
+
+
+
+    /*!
+     * Sink encoding every log call as one line of JSON (NDJSON) and writing
+     * it to another sink, e.g. a FileSink.
+     *
+     * The object has the keys time, severity, logger, thread, message and,
+     * if the call site is known, file, line and function. kv() fields follow
+     * with their keys and typed values. Keys repeating one of the fixed keys
+     * are written as they are, the last one wins in most JSON parsers. The
+     * sink takes records, so loggers hand over the captured calls and the
+     * fields stay typed values. Encoding runs on the thread calling the
+     * sink, i.e. the worker of an AsyncLogger.
+     */
+    class JsonSink : public Sink
+    {
+      public:
+        explicit JsonSink(Sink::SPtr target);
+
+        // make it non-copyable and non-assignable
+        JsonSink(const JsonSink&) = delete;
+        JsonSink(JsonSink&&)      = delete;
+
+        auto operator=(const JsonSink&) -> JsonSink& = delete;
+        auto operator=(JsonSink&&) -> JsonSink&      = delete;
+
+      public:
+        auto getType() -> SinkType override;
+
+        /*!
+         * Writes an already formatted message as object without logger and call site.
+         */
+        auto write(Severity, std::string_view) -> void override;
+        auto writeRecord(const Record& record, std::string_view loggerName) -> void override;
+        auto flush() -> void override;
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
+        auto getTarget() const -> const Sink::SPtr&;
+
+      private:
+        Sink::SPtr target_;
+    };
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/JsonSinkImpl.h"
+#endif // NEALOG_HEADERONLY
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "nealog/EpochReclaimer.h"
 #include "nealog/LoggerBase.h"
 #include "nealog/Mutex.h"
 #include "nealog/Severity.h"
 #include "nealog/Sink.h"
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -27,9 +30,29 @@ namespace nealog
         Logger(const std::string& name) noexcept;
 
       public:
+        using LoggerBase::debug;
+        using LoggerBase::error;
+        using LoggerBase::fatal;
+        using LoggerBase::info;
+        using LoggerBase::log;
+        using LoggerBase::trace;
+        using LoggerBase::warn;
+
+        /*!
+         * Adds or removes a sink without blocking threads which are logging.
+         * Both copy the current sink list, change the copy and publish it.
+         * The replaced list is freed by the EpochReclaimer once no thread
+         * writes to it anymore, which releases the sinks removed.
+         */
         auto addSink(const Sink::SPtr&) -> void override;
-        auto log(Severity, const std::string_view& message) -> void override;
-        auto getSinks() -> const std::vector<Sink::SPtr> override;
+        auto removeSink(const Sink::SPtr&) -> bool override;
+        auto log(Severity, const std::string_view& message, const SourceLocation* location = nullptr)
+            -> void override;
+
+        /*!
+         * Returns the current snapshot of the sinks. It stays valid until the next addSink() or removeSink().
+         */
+        auto getSinks() -> const SinkList& override;
         auto setFormatter(const PatternFormatter&) -> void override;
         auto getFormatter() const -> const PatternFormatter& override;
         auto trace(const std::string_view& message) -> void override;
@@ -38,23 +61,100 @@ namespace nealog
         auto warn(const std::string_view& message) -> void override;
         auto error(const std::string_view& message) -> void override;
         auto fatal(const std::string_view& message) -> void override;
+        auto setSeverity(Severity) -> void override;
+        auto vlog(Severity, fmt::string_view format, fmt::format_args args,
+                  const SourceLocation* location = nullptr) -> void override;
+        auto logRecord(Record& record) -> void override;
+        auto flush() -> void override;
+
+        /*!
+         * Flushes the sinks added to this logger, the crash handler visits its ancestors on their own.
+         */
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
 
       protected:
         auto writeToSinks(Severity, const std::string_view& message) -> void override;
+
+        /*!
+         * Hands count already formatted records to every sink at once.
+         */
+        auto writeBatchToSinks(const SinkRecord* records, std::size_t count) -> void;
+
+        /*!
+         * Hands the record to the sinks taking records. Returns whether other
+         * sinks are left which need the formatted message.
+         */
+        auto writeRecordToSinks(const Record& record) -> bool;
+
+        /*!
+         * What the pattern shows of a record besides its message.
+         */
+        auto getPatternContext(const Record& record) const noexcept -> PatternContext;
         auto setParent(LoggerBase::SPtr parent) -> void override;
+        auto refreshCache(std::uint64_t generation) -> void override;
 
       private:
         auto setParent() -> void;
 
+        /*!
+         * Lets render(buffer) fill a thread local buffer and writes it to the sinks.
+         */
+        template <typename TRender>
+        auto renderAndWriteToSinks(Severity, TRender&& render) -> void;
+
+        auto publishSinks(std::unique_ptr<const SinkList> sinks) -> void;
+
       protected:
-        std::vector<Sink::SPtr> sinks_{};
+        // Immutable snapshot of the sinks, replaced as a whole by addSink() and removeSink().
+        std::atomic<const SinkList*> sinks_{nullptr};
         SPtr parent_ = nullptr;
         std::string name_{};
         PatternFormatter formatter_{""};
+
+      private:
+        std::mutex cacheMutex_;
+        std::mutex sinksMutex_;
+        // The published snapshot. A replaced one is retired to the
+        // EpochReclaimer, as other threads may still iterate it.
+        std::unique_ptr<const SinkList> sinksSnapshot_{};
     };
 
 
 
+    template <typename TRender>
+    auto Logger::renderAndWriteToSinks(Severity messageSeverity, TRender&& render) -> void
+    {
+        // The message is rendered into a buffer owned by the calling thread
+        // which keeps its capacity, so a warmed up thread does not allocate.
+        // A sink logging from inside write() gets a buffer of its own.
+        thread_local fmt::memory_buffer buffer;
+        thread_local bool bufferInUse = false;
+
+        if (bufferInUse)
+        {
+            fmt::memory_buffer nestedBuffer;
+            render(nestedBuffer);
+            writeToSinks(messageSeverity, {nestedBuffer.data(), nestedBuffer.size()});
+            return;
+        }
+
+        bufferInUse = true;
+        try
+        {
+            buffer.clear();
+            render(buffer);
+            writeToSinks(messageSeverity, {buffer.data(), buffer.size()});
+        }
+        catch (...)
+        {
+            bufferInUse = false;
+            throw;
+        }
+        bufferInUse = false;
+    }
+
+
+
     class LoggerRegistryException : public std::runtime_error
     {
         using std::runtime_error::runtime_error;
@@ -82,6 +182,7 @@ namespace nealog
     {
       protected:
         auto setParentForLogger(LoggerBase::SPtr parent, LoggerBase::SPtr child) -> void;
+        auto setGenerationForLogger(std::shared_ptr<GenerationCounter> generation, LoggerBase::SPtr logger) -> void;
     };
 
 
@@ -106,6 +207,7 @@ namespace nealog
       private:
         TMutex mutex_;
         std::unordered_map<std::string, LoggerBase::SPtr> registrees_{};
+        std::shared_ptr<GenerationCounter> generation_ = std::make_shared<GenerationCounter>(0);
     };
 
 
@@ -140,6 +242,8 @@ namespace nealog
     auto LoggerRegistry<TMutex>::createLogger(const std::string& name) -> LoggerBase::SPtr
     {
         auto logger = std::make_shared<Logger>(name);
+        setGenerationForLogger(generation_, logger);
+
         if (name != ROOT_LOGGER_NAME)
         {
             auto& parentName = getParentName(name);
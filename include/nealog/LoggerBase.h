@@ -1,15 +1,92 @@
 #pragma once
 
+#include "nealog/EpochReclaimer.h"
+#include "nealog/FlightRecorder.h"
 #include "nealog/Formatter.h"
+#include "nealog/Record.h"
 #include "nealog/Severity.h"
 #include "nealog/Sink.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fmt/compile.h>
+#include <fmt/core.h>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace nealog
 {
 
+    /*!
+     * Buffer the templated log calls format the message into before handing it on.
+     */
+    inline auto getThreadMessageBuffer() -> fmt::memory_buffer&
+    {
+        thread_local fmt::memory_buffer buffer;
+        return buffer;
+    }
+
+
+
+    using GenerationCounter = std::atomic<std::uint64_t>;
+    using SinkList          = std::vector<Sink::SPtr>;
+
+
+
+    template <typename T>
+    using EnableIfCompiledString = std::enable_if_t<fmt::detail::is_compiled_string<T>::value, int>;
+
+
+
+    /*!
+     * Number of kv() fields at the end of the arguments of a log call.
+     */
+    template <typename... TArgs>
+    constexpr auto countTrailingFields() -> std::size_t
+    {
+        constexpr std::array<bool, sizeof...(TArgs)> isField{IS_FIELD<TArgs>...};
+
+        std::size_t count = 0;
+        while (count < isField.size() && isField[isField.size() - 1 - count])
+            count++;
+        return count;
+    }
+
+
+
+    /*!
+     * Captures the leading arguments for the format and the trailing ones as fields.
+     */
+    template <std::size_t... TArgument, std::size_t... TField, typename... TArgs>
+    auto captureStructured(Record& record, Severity severity, fmt::string_view format,
+                           std::index_sequence<TArgument...>, std::index_sequence<TField...>,
+                           const std::tuple<const TArgs&...>& arguments) -> void
+    {
+        record.capture(severity, {format.data(), format.size()}, std::get<TArgument>(arguments)...);
+        record.captureFields(std::get<sizeof...(TArgument) + TField>(arguments)...);
+    }
+
+
+
+    /*!
+     * A logger with sinks writes to them, a logger without sinks writes to the
+     * sinks of its nearest ancestor with sinks using that ancestor's severity
+     * and formatter. Instead of walking the parents on every call each logger
+     * caches the resolved severity, sinks and formatter. All loggers of a tree
+     * share a generation counter which is incremented by every change to a
+     * severity, the sinks or the parent, so a cache is refreshed once its
+     * generation is outdated.
+     */
     class LoggerBase : public WithSeverity
     {
         friend class ParentHolder;
+        friend class Logger;
 
       public:
         using SPtr = std::shared_ptr<LoggerBase>;
@@ -27,8 +104,8 @@ namespace nealog
 
       public:
         virtual auto addSink(const Sink::SPtr&) -> void                     = 0;
-        virtual auto log(Severity, const std::string_view& message) -> void = 0;
-        virtual auto getSinks() -> const std::vector<Sink::SPtr>            = 0;
+        virtual auto removeSink(const Sink::SPtr&) -> bool                  = 0;
+        virtual auto getSinks() -> const SinkList&                          = 0;
         virtual auto setFormatter(const PatternFormatter&) -> void          = 0;
         virtual auto getFormatter() const -> const PatternFormatter&        = 0;
         virtual auto trace(const std::string_view& message) -> void         = 0;
@@ -38,8 +115,357 @@ namespace nealog
         virtual auto error(const std::string_view& message) -> void         = 0;
         virtual auto fatal(const std::string_view& message) -> void         = 0;
 
+        /*!
+         * Writes the message as it is. The location, if given, must have
+         * static storage duration, like the ones of the logging macros.
+         */
+        virtual auto log(Severity, const std::string_view& message, const SourceLocation* location = nullptr)
+            -> void = 0;
+
+        /*!
+         * True if a message of the given severity would reach a sink or the
+         * flight recorder. Costs a compare of the generation and the severity
+         * as long as nothing changed.
+         */
+        auto isEnabled(Severity severity) -> bool
+        {
+            refreshCacheIfOutdated();
+            const int severityValue = static_cast<int>(severity);
+            return severityValue >= effectiveThreshold_.load(std::memory_order_relaxed) ||
+                   severityValue >= flightRecorderThreshold_.load(std::memory_order_relaxed);
+        }
+
+        /*!
+         * Replaces the flight recorder of this logger, a capacity of 0 removes
+         * it. Calls below the severity of the logger but at or above keepFrom
+         * are captured into the ring instead of being dropped. A call at or
+         * above the trigger which reaches the sinks first writes the kept
+         * calls, with their own time and thread, and empties the ring. The
+         * recorder belongs to this logger alone, its children keep their calls
+         * only with a recorder of their own. The calls kept in a replaced
+         * recorder are dropped, the EpochReclaimer frees it once no thread
+         * keeps a call in it anymore.
+         */
+        auto setFlightRecorder(const FlightRecorderPolicy& policy) -> void;
+
+        /*!
+         * Writes the kept calls to the sinks now and empties the ring, e.g. before the process exits.
+         */
+        auto writeFlightRecorder() -> void;
+
+        /*!
+         * Formats format with args into the pattern and writes it to the sinks.
+         */
+        virtual auto vlog(Severity, fmt::string_view format, fmt::format_args args,
+                          const SourceLocation* location = nullptr) -> void = 0;
+
+        /*!
+         * Writes a captured but not yet formatted call.
+         */
+        virtual auto logRecord(Record& record) -> void = 0;
+
+        /*!
+         * Flushes the sinks the calls of this logger go to. Fatal calls
+         * flush before they return, every other call leaves it to the
+         * buffering of the sinks.
+         */
+        virtual auto flush() -> void = 0;
+
+        /*!
+         * Flush of the crash handler inside a signal handler, see
+         * installCrashHandler(). Waits for nothing past the deadline.
+         */
+        virtual auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void = 0;
+
+      public:
+        /*!
+         * The variadic overloads check the severity first and only format
+         * afterwards. The format string is checked against the arguments by
+         * fmt. A message without arguments goes to the plain string_view
+         * overloads and is never parsed as format string.
+         *
+         * Arguments created with kv() after the ones of the format are
+         * structured fields. They travel as typed values to the sinks taking
+         * records, e.g. JsonSink, and text sinks show them as " key=value"
+         * behind the message:
+         *
+         *     logger.info("request done", kv("user", id), kv("ms", elapsed));
+         */
+        template <typename TArg, typename... TArgs>
+        auto log(Severity, fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void;
+        template <typename TArg, typename... TArgs>
+        auto trace(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void;
+        template <typename TArg, typename... TArgs>
+        auto debug(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void;
+        template <typename TArg, typename... TArgs>
+        auto info(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void;
+        template <typename TArg, typename... TArgs>
+        auto warn(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void;
+        template <typename TArg, typename... TArgs>
+        auto error(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void;
+        template <typename TArg, typename... TArgs>
+        auto fatal(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void;
+
+        /*!
+         * Severity given at compile time. Calls below NEALOG_ACTIVE_LEVEL compile to nothing,
+         * all other calls keep the runtime check.
+         */
+        template <Severity TSeverity>
+        auto logAt(const std::string_view& message) -> void;
+        template <Severity TSeverity, typename TArg, typename... TArgs>
+        auto logAt(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void;
+
+        /*!
+         * Like above for the logging macros, which hand over their call site
+         * for the %(file), %(line) and %(function) placeholders.
+         */
+        template <Severity TSeverity>
+        auto logAt(const SourceLocation& location, const std::string_view& message) -> void;
+        template <Severity TSeverity, typename TArg, typename... TArgs>
+        auto logAt(const SourceLocation& location, fmt::format_string<TArg, TArgs...> format, TArg&& arg,
+                   TArgs&&... args) -> void;
+
+        /*!
+         * Overload for format strings wrapped in FMT_COMPILE, which fmt parses at compile time.
+         */
+        template <typename TCompiled, typename... TArgs, EnableIfCompiledString<TCompiled> = 0>
+        auto log(Severity, const TCompiled& format, TArgs&&... args) -> void;
+
       protected:
+        /*!
+         * Formats or captures an enabled call of the variadic overloads.
+         */
+        template <typename... TArgs>
+        auto logFormatted(Severity, const SourceLocation* location, fmt::string_view format, const TArgs&... args)
+            -> void;
+
         virtual auto writeToSinks(Severity, const std::string_view& message) -> void = 0;
         virtual auto setParent(LoggerBase::SPtr parent) -> void                      = 0;
+
+        /*!
+         * True for an enabled call which only the flight recorder gets.
+         */
+        auto isOnlyRecorded(Severity severity) const noexcept -> bool
+        {
+            return static_cast<int>(severity) < effectiveThreshold_.load(std::memory_order_relaxed);
+        }
+
+        auto keepInFlightRecorder(Record& record) -> void
+        {
+            const EpochReclaimer::ReadGuard guard;
+            if (FlightRecorder* recorder = flightRecorder_.load(std::memory_order_acquire))
+                recorder->keep(record);
+        }
+
+        /*!
+         * Writes the kept calls if a call of the severity triggers the recorder.
+         */
+        auto writeFlightRecorderIfTriggered(Severity severity) -> void
+        {
+            if (static_cast<int>(severity) >= flightRecorderTrigger_.load(std::memory_order_relaxed))
+                writeFlightRecorder();
+        }
+
+        /*!
+         * Keeps a plain message the sinks do not get in the flight recorder and
+         * returns true. Otherwise writes the kept calls if the message triggers
+         * the recorder and returns false.
+         */
+        auto recordMessage(Severity, const std::string_view& message, const SourceLocation* location) -> bool;
+
+        /*!
+         * Resolves the effective severity, sinks and formatter and stores them with the given generation.
+         */
+        virtual auto refreshCache(std::uint64_t generation) -> void = 0;
+
+        auto refreshCacheIfOutdated() -> void
+        {
+            const std::uint64_t generation = generation_->load(std::memory_order_acquire);
+            if (cachedGeneration_.load(std::memory_order_acquire) != generation)
+                refreshCache(generation);
+        }
+
+        auto invalidateCaches() -> void
+        {
+            generation_->fetch_add(1, std::memory_order_acq_rel);
+        }
+
+      protected:
+        static constexpr int DISABLED_THRESHOLD      = static_cast<int>(Severity::Fatal) + 1;
+        static constexpr std::uint64_t NO_GENERATION = ~std::uint64_t{0};
+
+        // set by loggers that want the variadic calls captured as Record
+        // instead of formatted on the calling thread
+        bool defersFormatting_ = false;
+
+        std::shared_ptr<GenerationCounter> generation_ = std::make_shared<GenerationCounter>(0);
+        std::atomic<std::uint64_t> cachedGeneration_{NO_GENERATION};
+        std::atomic<int> effectiveThreshold_{DISABLED_THRESHOLD};
+        std::atomic<const SinkList*> effectiveSinks_{nullptr};
+        std::atomic<const PatternFormatter*> effectiveFormatter_{nullptr};
+        // set if one of the effective sinks takes records, the calls are then
+        // captured like on a deferring logger instead of being formatted
+        std::atomic<bool> effectiveTakesRecords_{false};
+
+        std::atomic<int> flightRecorderThreshold_{DISABLED_THRESHOLD};
+        std::atomic<int> flightRecorderTrigger_{DISABLED_THRESHOLD};
+        std::atomic<FlightRecorder*> flightRecorder_{nullptr};
+
+      private:
+        std::mutex flightRecordersMutex_;
+        // The recorder set. A replaced one is retired to the EpochReclaimer,
+        // as threads may still keep a call in it.
+        std::unique_ptr<FlightRecorder> ownedFlightRecorder_{};
     };
+
+
+
+    template <typename TArg, typename... TArgs>
+    auto LoggerBase::log(Severity severity, fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args)
+        -> void
+    {
+        if (isEnabled(severity))
+            logFormatted(severity, nullptr, format, arg, args...);
+    }
+
+
+
+    template <typename... TArgs>
+    auto LoggerBase::logFormatted(Severity severity, const SourceLocation* location, fmt::string_view format,
+                                  const TArgs&... args) -> void
+    {
+        constexpr std::size_t fieldCount = countTrailingFields<TArgs...>();
+        static_assert((std::size_t{IS_FIELD<TArgs>} + ... + 0) == fieldCount,
+                      "kv() fields must follow the arguments of the format string");
+
+        const bool onlyRecorded = isOnlyRecorded(severity);
+        if (!onlyRecorded)
+            writeFlightRecorderIfTriggered(severity);
+
+        if constexpr (fieldCount > 0)
+        {
+            // fields are typed values, so the call is captured like for a sink taking records
+            Record record;
+            captureStructured(record, severity, format, std::make_index_sequence<sizeof...(TArgs) - fieldCount>{},
+                              std::make_index_sequence<fieldCount>{}, std::tuple<const TArgs&...>{args...});
+            record.setLocation(location);
+            onlyRecorded ? keepInFlightRecorder(record) : logRecord(record);
+        }
+        else if (onlyRecorded || defersFormatting_ || effectiveTakesRecords_.load(std::memory_order_relaxed))
+        {
+            Record record;
+            record.capture(severity, {format.data(), format.size()}, args...);
+            record.setLocation(location);
+            onlyRecorded ? keepInFlightRecorder(record) : logRecord(record);
+        }
+        else
+        {
+            vlog(severity, format, fmt::make_format_args(args...), location);
+        }
+
+        if (severity == Severity::Fatal && !onlyRecorded)
+            flush();
+    }
+
+
+
+    template <typename TCompiled, typename... TArgs, EnableIfCompiledString<TCompiled>>
+    auto LoggerBase::log(Severity severity, const TCompiled& format, TArgs&&... args) -> void
+    {
+        if (!isEnabled(severity))
+            return;
+
+        fmt::memory_buffer& buffer = getThreadMessageBuffer();
+        buffer.clear();
+        fmt::format_to(std::back_inserter(buffer), format, std::forward<TArgs>(args)...);
+        log(severity, std::string_view{buffer.data(), buffer.size()});
+    }
+
+
+
+    template <Severity TSeverity>
+    auto LoggerBase::logAt(const std::string_view& message) -> void
+    {
+        if constexpr (isActiveAtCompileTime(TSeverity))
+            log(TSeverity, message);
+    }
+
+
+
+    template <Severity TSeverity, typename TArg, typename... TArgs>
+    auto LoggerBase::logAt(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void
+    {
+        if constexpr (isActiveAtCompileTime(TSeverity))
+            log(TSeverity, format, std::forward<TArg>(arg), std::forward<TArgs>(args)...);
+    }
+
+
+
+    template <Severity TSeverity>
+    auto LoggerBase::logAt(const SourceLocation& location, const std::string_view& message) -> void
+    {
+        if constexpr (isActiveAtCompileTime(TSeverity))
+            log(TSeverity, message, &location);
+    }
+
+
+
+    template <Severity TSeverity, typename TArg, typename... TArgs>
+    auto LoggerBase::logAt(const SourceLocation& location, fmt::format_string<TArg, TArgs...> format, TArg&& arg,
+                           TArgs&&... args) -> void
+    {
+        if constexpr (isActiveAtCompileTime(TSeverity))
+        {
+            if (isEnabled(TSeverity))
+                logFormatted(TSeverity, &location, format, arg, args...);
+        }
+    }
+
+
+
+    template <typename TArg, typename... TArgs>
+    auto LoggerBase::trace(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void
+    {
+        logAt<Severity::Trace>(format, std::forward<TArg>(arg), std::forward<TArgs>(args)...);
+    }
+
+
+
+    template <typename TArg, typename... TArgs>
+    auto LoggerBase::debug(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void
+    {
+        logAt<Severity::Debug>(format, std::forward<TArg>(arg), std::forward<TArgs>(args)...);
+    }
+
+
+
+    template <typename TArg, typename... TArgs>
+    auto LoggerBase::info(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void
+    {
+        logAt<Severity::Info>(format, std::forward<TArg>(arg), std::forward<TArgs>(args)...);
+    }
+
+
+
+    template <typename TArg, typename... TArgs>
+    auto LoggerBase::warn(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void
+    {
+        logAt<Severity::Warn>(format, std::forward<TArg>(arg), std::forward<TArgs>(args)...);
+    }
+
+
+
+    template <typename TArg, typename... TArgs>
+    auto LoggerBase::error(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void
+    {
+        logAt<Severity::Error>(format, std::forward<TArg>(arg), std::forward<TArgs>(args)...);
+    }
+
+
+
+    template <typename TArg, typename... TArgs>
+    auto LoggerBase::fatal(fmt::format_string<TArg, TArgs...> format, TArg&& arg, TArgs&&... args) -> void
+    {
+        logAt<Severity::Fatal>(format, std::forward<TArg>(arg), std::forward<TArgs>(args)...);
+    }
 } // namespace nealog
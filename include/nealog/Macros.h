@@ -0,0 +1,155 @@
+#pragma once
+
+#include "nealog/ConcurrentLoggerRegistry.h"
+#include "nealog/LoggerBase.h"
+#include "nealog/RateLimit.h"
+#include "nealog/Severity.h"
+#include "nealog/SourceLocation.h"
+
+#include <cstdint>
+#include <memory>
+
+/*!
+ * Logging macros which take a logger (reference, pointer or shared_ptr)
+ * followed by a message or a format string and its arguments:
+ *
+ *     NEALOG_DEBUG(logger, "x={}", expensive());
+ *
+ * Calls below NEALOG_ACTIVE_LEVEL expand to nothing, so neither the call nor
+ * its arguments remain in the binary. The remaining calls only evaluate their
+ * arguments after the runtime severity check passed. Each call site hands
+ * its file, line and function to the pattern as a constant.
+ *
+ * NEALOG_LOGGER(name) resolves a logger of the default registry once per
+ * call site and yields a plain reference afterwards, so loops fetching their
+ * logger on every iteration do neither a lookup nor reference counting:
+ *
+ *     NEALOG_INFO(NEALOG_LOGGER("svc.db"), "connected to {}", host);
+ *
+ * The name is evaluated only on the first pass through the call site and
+ * must not refer to local variables, i.e. it is usually a string literal.
+ *
+ * NEALOG_<LEVEL>_LIMITED takes a call site limit after the logger, a
+ * RateLimit, EveryN or Sampled. Enabled calls the limit suppresses evaluate
+ * no arguments, the count of them is written with the next passing call:
+ *
+ *     NEALOG_WARN_LIMITED(logger, nealog::RateLimit(10, 100), "retrying {}", id);
+ *
+ * The limit needs parentheses instead of braces to stay one macro argument.
+ * It is constructed on the first pass through the call site, like the name
+ * of NEALOG_LOGGER, at compile time if its arguments are constants.
+ */
+
+namespace nealog
+{
+
+    inline auto asLoggerReference(LoggerBase& logger) -> LoggerBase&
+    {
+        return logger;
+    }
+
+    inline auto asLoggerReference(LoggerBase* logger) -> LoggerBase&
+    {
+        return *logger;
+    }
+
+    template <typename TLogger>
+    inline auto asLoggerReference(const std::shared_ptr<TLogger>& logger) -> LoggerBase&
+    {
+        return *logger;
+    }
+
+} // namespace nealog
+
+
+#define NEALOG_LOG_AT(logger, severity, ...)                                                                        \
+    do                                                                                                              \
+    {                                                                                                               \
+        ::nealog::LoggerBase& nealogLogger_ = ::nealog::asLoggerReference(logger);                                  \
+        if (nealogLogger_.isEnabled(severity))                                                                      \
+        {                                                                                                           \
+            static constexpr ::nealog::SourceLocation nealogLocation_ = NEALOG_SOURCE_LOCATION;                     \
+            nealogLogger_.logAt<severity>(nealogLocation_, __VA_ARGS__);                                            \
+        }                                                                                                           \
+    } while (false)
+
+#define NEALOG_LOG_LIMITED_AT(logger, severity, limit, ...)                                                         \
+    do                                                                                                              \
+    {                                                                                                               \
+        ::nealog::LoggerBase& nealogLogger_ = ::nealog::asLoggerReference(logger);                                  \
+        if (nealogLogger_.isEnabled(severity))                                                                      \
+        {                                                                                                           \
+            static auto nealogLimit_ = limit;                                                                       \
+            if (nealogLimit_.tryPass())                                                                             \
+            {                                                                                                       \
+                static constexpr ::nealog::SourceLocation nealogLocation_ = NEALOG_SOURCE_LOCATION;                 \
+                if (const std::uint64_t nealogSuppressed_ = nealogLimit_.takeSuppressed())                          \
+                    nealogLogger_.logAt<severity>(nealogLocation_, "suppressed {} messages", nealogSuppressed_);    \
+                nealogLogger_.logAt<severity>(nealogLocation_, __VA_ARGS__);                                        \
+            }                                                                                                       \
+        }                                                                                                           \
+    } while (false)
+
+#define NEALOG_STRIPPED(logger, ...) static_cast<void>(0)
+
+#define NEALOG_LOGGER(name)                                                                                         \
+    ([]() -> ::nealog::LoggerBase& {                                                                                \
+        static ::nealog::LoggerBase& nealogCallSiteLogger_ =                                                        \
+            ::nealog::getDefaultRegistry().getOrCreateReference(name);                                              \
+        return nealogCallSiteLogger_;                                                                               \
+    }())
+
+
+#if NEALOG_ACTIVE_LEVEL <= NEALOG_LEVEL_TRACE
+#define NEALOG_TRACE(logger, ...) NEALOG_LOG_AT(logger, ::nealog::Severity::Trace, __VA_ARGS__)
+#define NEALOG_TRACE_LIMITED(logger, limit, ...)                                                                    \
+    NEALOG_LOG_LIMITED_AT(logger, ::nealog::Severity::Trace, limit, __VA_ARGS__)
+#else
+#define NEALOG_TRACE(logger, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#define NEALOG_TRACE_LIMITED(logger, limit, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#endif
+
+#if NEALOG_ACTIVE_LEVEL <= NEALOG_LEVEL_DEBUG
+#define NEALOG_DEBUG(logger, ...) NEALOG_LOG_AT(logger, ::nealog::Severity::Debug, __VA_ARGS__)
+#define NEALOG_DEBUG_LIMITED(logger, limit, ...)                                                                    \
+    NEALOG_LOG_LIMITED_AT(logger, ::nealog::Severity::Debug, limit, __VA_ARGS__)
+#else
+#define NEALOG_DEBUG(logger, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#define NEALOG_DEBUG_LIMITED(logger, limit, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#endif
+
+#if NEALOG_ACTIVE_LEVEL <= NEALOG_LEVEL_INFO
+#define NEALOG_INFO(logger, ...) NEALOG_LOG_AT(logger, ::nealog::Severity::Info, __VA_ARGS__)
+#define NEALOG_INFO_LIMITED(logger, limit, ...)                                                                     \
+    NEALOG_LOG_LIMITED_AT(logger, ::nealog::Severity::Info, limit, __VA_ARGS__)
+#else
+#define NEALOG_INFO(logger, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#define NEALOG_INFO_LIMITED(logger, limit, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#endif
+
+#if NEALOG_ACTIVE_LEVEL <= NEALOG_LEVEL_WARN
+#define NEALOG_WARN(logger, ...) NEALOG_LOG_AT(logger, ::nealog::Severity::Warn, __VA_ARGS__)
+#define NEALOG_WARN_LIMITED(logger, limit, ...)                                                                     \
+    NEALOG_LOG_LIMITED_AT(logger, ::nealog::Severity::Warn, limit, __VA_ARGS__)
+#else
+#define NEALOG_WARN(logger, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#define NEALOG_WARN_LIMITED(logger, limit, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#endif
+
+#if NEALOG_ACTIVE_LEVEL <= NEALOG_LEVEL_ERROR
+#define NEALOG_ERROR(logger, ...) NEALOG_LOG_AT(logger, ::nealog::Severity::Error, __VA_ARGS__)
+#define NEALOG_ERROR_LIMITED(logger, limit, ...)                                                                    \
+    NEALOG_LOG_LIMITED_AT(logger, ::nealog::Severity::Error, limit, __VA_ARGS__)
+#else
+#define NEALOG_ERROR(logger, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#define NEALOG_ERROR_LIMITED(logger, limit, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#endif
+
+#if NEALOG_ACTIVE_LEVEL <= NEALOG_LEVEL_FATAL
+#define NEALOG_FATAL(logger, ...) NEALOG_LOG_AT(logger, ::nealog::Severity::Fatal, __VA_ARGS__)
+#define NEALOG_FATAL_LIMITED(logger, limit, ...)                                                                    \
+    NEALOG_LOG_LIMITED_AT(logger, ::nealog::Severity::Fatal, limit, __VA_ARGS__)
+#else
+#define NEALOG_FATAL(logger, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#define NEALOG_FATAL_LIMITED(logger, limit, ...) NEALOG_STRIPPED(logger, __VA_ARGS__)
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "nealog/RingBuffer.h"
+#include "nealog/Severity.h"
+#include "nealog/Sink.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+
+namespace nealog
+{
+
+    enum class MsyncMode
+    {
+        Async, // schedule the write back and return
+        Sync,  // wait until the pages are on disk
+    };
+
+
+
+    /*!
+     * Decides when a MmapSink calls msync besides flush().
+     */
+    struct MmapSyncPolicy
+    {
+        // Sync whenever this many more bytes were written. Zero disables it.
+        std::size_t interval = 0;
+        // Sync a segment before it is unmapped.
+        bool onRoll    = true;
+        MsyncMode mode = MsyncMode::Async;
+    };
+
+
+
+    /*!
+     * Sink appending to preallocated and memory mapped file segments.
+     *
+     * A writer reserves its range in the current segment with an atomic
+     * fetch_add and copies the message into the mapping, so a write takes no
+     * lock and makes no syscall. The writer whose message does not fit
+     * anymore maps the next segment, waits for the writers still copying into
+     * the old one and truncates it to the written size.
+     *
+     * Segments are numbered like the ones of RotatingFileSink (app.log.1,
+     * app.log.2, ...) and the active one ends in preallocated zeros until it
+     * is closed. Messages larger than a segment are dropped and counted, as
+     * are messages written while no new segment could be created.
+     */
+    class MmapSink : public Sink
+    {
+      public:
+        static constexpr std::size_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+      public:
+        explicit MmapSink(const std::string& path, std::size_t segmentSize = DEFAULT_SEGMENT_SIZE,
+                          MmapSyncPolicy syncPolicy = {});
+        ~MmapSink() override;
+
+        // make it non-copyable and non-assignable
+        MmapSink(const MmapSink&) = delete;
+        MmapSink(MmapSink&&)      = delete;
+
+        auto operator=(const MmapSink&) -> MmapSink& = delete;
+        auto operator=(MmapSink&&) -> MmapSink&      = delete;
+
+      public:
+        auto getType() -> SinkType override;
+        auto write(Severity, std::string_view) -> void override;
+
+        /*!
+         * Syncs the written part of the current segment with the mode of the sync policy.
+         * The crash flush does nothing, the page cache keeps what is in the mapping.
+         */
+        auto flush() -> void override;
+        auto getPath() const -> const std::string&;
+        auto getSegmentPath(std::uint64_t segment) const -> std::string;
+        auto getCurrentSegment() const -> std::uint64_t;
+        auto getDroppedCount() const noexcept -> std::size_t;
+
+      private:
+        struct Segment
+        {
+            std::uint64_t number = 0;
+            int fileDescriptor   = -1;
+            char* data           = nullptr;
+            std::size_t capacity = 0;
+            alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> reserved{0};
+            alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> committed{0};
+        };
+
+      private:
+        auto openSegment() -> Segment*;
+        auto reopenSegment() -> bool;
+        auto roll(Segment& full, std::size_t usedSize) -> void;
+        auto closeSegment(Segment& segment, std::size_t usedSize) -> void;
+        auto sync(const Segment& segment, std::size_t begin, std::size_t end, MsyncMode mode) const -> void;
+
+      private:
+        std::string path_;
+        std::size_t segmentSize_;
+        MmapSyncPolicy syncPolicy_;
+        std::size_t pageSize_;
+        std::uint64_t lastSegment_;
+        std::atomic<Segment*> current_{nullptr};
+        // Closed segments only release their mapping. A writer may still hold
+        // a pointer to one and its counters tell the writer to move on.
+        std::vector<std::unique_ptr<Segment>> segments_{};
+        std::atomic<std::size_t> droppedCount_{0};
+    };
+
+} // namespace nealog
+
+#endif // !_WIN32
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/MmapSinkImpl.h"
+#endif // NEALOG_HEADERONLY
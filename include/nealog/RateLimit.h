@@ -0,0 +1,203 @@
+#pragma once
+
+#include "nealog/RingBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace nealog
+{
+
+    // suppressed calls of a call site are reported at most this often
+    constexpr std::chrono::seconds SUPPRESSED_REPORT_INTERVAL{1};
+
+
+
+    /*!
+     * Nanoseconds of a monotonic clock which may only advance once per
+     * kernel tick (CLOCK_MONOTONIC_COARSE of Linux), cheap enough to be read
+     * on every call of a rate limited call site.
+     */
+    auto readCoarseSteadyNanoseconds() noexcept -> std::int64_t;
+
+    /*!
+     * Uniformly distributed random number from a generator per thread.
+     */
+    auto nextSampleRandom() noexcept -> std::uint32_t;
+
+
+
+    /*!
+     * Counts the calls a call site limit suppressed. The logging macros with
+     * a limit keep one limit per call site in static storage, a call passing
+     * it is written after a line "suppressed <n> messages" if calls were
+     * suppressed since the last report, but at most once per
+     * SUPPRESSED_REPORT_INTERVAL. Calls suppressed after the last passing
+     * one are not reported.
+     *
+     * Every check is lock-free and happens before the arguments of the call
+     * are evaluated. A suppressed call is counted with one relaxed atomic
+     * increment, so the counts stay exact under concurrent calls.
+     */
+    class alignas(CACHE_LINE_SIZE) CallSiteLimit
+    {
+      protected:
+        constexpr CallSiteLimit() noexcept = default;
+        ~CallSiteLimit()                   = default;
+
+      public:
+        // make it non-copyable and non-assignable
+        CallSiteLimit(const CallSiteLimit&) = delete;
+        CallSiteLimit(CallSiteLimit&&)      = delete;
+
+        auto operator=(const CallSiteLimit&) -> CallSiteLimit& = delete;
+        auto operator=(CallSiteLimit&&) -> CallSiteLimit&      = delete;
+
+      public:
+        /*!
+         * The calls suppressed since the last report if it is time for the
+         * next one, else 0. Reporting resets the count.
+         */
+        auto takeSuppressed() noexcept -> std::uint64_t
+        {
+            if (suppressed_.load(std::memory_order_relaxed) == 0)
+                return 0;
+
+            const std::int64_t now = readCoarseSteadyNanoseconds();
+            std::int64_t reportAt  = nextReport_.load(std::memory_order_relaxed);
+            if (now < reportAt || !nextReport_.compare_exchange_strong(reportAt, now + REPORT_INTERVAL_NS,
+                                                                       std::memory_order_relaxed))
+                return 0;
+            return suppressed_.exchange(0, std::memory_order_relaxed);
+        }
+
+        auto getSuppressed() const noexcept -> std::uint64_t
+        {
+            return suppressed_.load(std::memory_order_relaxed);
+        }
+
+      protected:
+        auto suppress() noexcept -> void
+        {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+      protected:
+        static constexpr std::int64_t NANOSECONDS_PER_SECOND = 1'000'000'000;
+        static constexpr std::int64_t REPORT_INTERVAL_NS =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(SUPPRESSED_REPORT_INTERVAL).count();
+
+      private:
+        std::atomic<std::uint64_t> suppressed_{0};
+        std::atomic<std::int64_t> nextReport_{0};
+    };
+
+
+
+    /*!
+     * Token bucket passing perSecond calls per second on average and bursts
+     * of up to burst calls, burst defaults to perSecond. It keeps the time
+     * the bucket is full again in one atomic (GCRA), so a check reads the
+     * coarse clock, compares and, for a passing call, swaps the time.
+     */
+    class RateLimit : public CallSiteLimit
+    {
+      public:
+        constexpr explicit RateLimit(std::uint32_t perSecond, std::uint32_t burst = 0) noexcept
+            : interval_{NANOSECONDS_PER_SECOND / std::max<std::int64_t>(perSecond, 1)},
+              tolerance_{interval_ * std::max<std::int64_t>(burst == 0 ? perSecond : burst, 1)}
+        {
+        }
+
+      public:
+        auto tryPass() noexcept -> bool
+        {
+            const std::int64_t now = readCoarseSteadyNanoseconds();
+            std::int64_t fullAt    = fullAt_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                const std::int64_t next = std::max(fullAt, now) + interval_;
+                if (next - now > tolerance_)
+                {
+                    suppress();
+                    return false;
+                }
+                if (fullAt_.compare_exchange_weak(fullAt, next, std::memory_order_relaxed))
+                    return true;
+            }
+        }
+
+      private:
+        // nanoseconds a token takes to be refilled
+        const std::int64_t interval_;
+        // nanoseconds of tokens the bucket holds
+        const std::int64_t tolerance_;
+        std::atomic<std::int64_t> fullAt_{0};
+    };
+
+
+
+    /*!
+     * Passes the first and then every nth call.
+     */
+    class EveryN : public CallSiteLimit
+    {
+      public:
+        constexpr explicit EveryN(std::uint64_t n) noexcept : n_{std::max<std::uint64_t>(n, 1)}
+        {
+        }
+
+      public:
+        auto tryPass() noexcept -> bool
+        {
+            if (count_.fetch_add(1, std::memory_order_relaxed) % n_ == 0)
+                return true;
+            suppress();
+            return false;
+        }
+
+      private:
+        const std::uint64_t n_;
+        std::atomic<std::uint64_t> count_{0};
+    };
+
+
+
+    /*!
+     * Passes each call with the given probability, drawn from a random
+     * generator per thread, so the check shares no state between threads
+     * unless it suppresses the call.
+     */
+    class Sampled : public CallSiteLimit
+    {
+      public:
+        constexpr explicit Sampled(double probability) noexcept
+            : threshold_{probability >= 1.0  ? RANDOM_RANGE
+                         : probability > 0.0 ? static_cast<std::uint64_t>(probability * RANDOM_RANGE)
+                                             : 0}
+        {
+        }
+
+      public:
+        auto tryPass() noexcept -> bool
+        {
+            if (nextSampleRandom() < threshold_)
+                return true;
+            suppress();
+            return false;
+        }
+
+      private:
+        static constexpr std::uint64_t RANDOM_RANGE = std::uint64_t{1} << 32;
+
+        // random numbers below it pass
+        const std::uint64_t threshold_;
+    };
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/RateLimitImpl.h"
+#endif // NEALOG_HEADERONLY
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "nealog/Clock.h"
+#include "nealog/Severity.h"
+#include "nealog/SourceLocation.h"
+#include "nealog/Thread.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+namespace nealog
+{
+
+    constexpr const char* PLAIN_MESSAGE_FORMAT = "{}";
+
+
+
+    /*!
+     * Type tag written in front of every captured argument.
+     */
+    enum class ArgumentType : std::uint8_t
+    {
+        Bool,
+        Char,
+        Int,
+        UInt,
+        Double,
+        Pointer,
+        String,
+        Float,
+    };
+
+
+
+    /*!
+     * A captured argument read back, the alternatives follow ArgumentType.
+     */
+    using ArgumentValue =
+        std::variant<bool, char, std::int64_t, std::uint64_t, double, const void*, std::string_view, float>;
+
+
+
+    /*!
+     * True for the types a Record captures as they are. fmt formats all
+     * other ones through a user formatter, which a replay cannot call.
+     */
+    template <typename T>
+    constexpr bool IS_CAPTURED_RAW = std::is_arithmetic_v<T> || std::is_same_v<T, char*> ||
+                                     std::is_same_v<T, const char*> ||
+                                     std::is_convertible_v<const T&, std::string_view> || std::is_same_v<T, void*> ||
+                                     std::is_same_v<T, const void*> || std::is_null_pointer_v<T>;
+
+
+
+    /*!
+     * Hands the argument to visit as the type tag and the value it is
+     * captured as: integers widened to 64 bits, float and double as they
+     * are, strings as string_view. Types fmt can only format through a user
+     * formatter are formatted here with an empty format spec.
+     */
+    template <typename T, typename TVisit>
+    auto visitArgument(const T& argument, TVisit&& visit) -> decltype(auto)
+    {
+        using TArg = std::decay_t<T>;
+
+        if constexpr (std::is_same_v<TArg, bool>)
+            return visit(ArgumentType::Bool, argument);
+        else if constexpr (std::is_same_v<TArg, char>)
+            return visit(ArgumentType::Char, argument);
+        else if constexpr (std::is_integral_v<TArg> && std::is_signed_v<TArg>)
+            return visit(ArgumentType::Int, static_cast<std::int64_t>(argument));
+        else if constexpr (std::is_integral_v<TArg>)
+            return visit(ArgumentType::UInt, static_cast<std::uint64_t>(argument));
+        else if constexpr (std::is_same_v<TArg, float>)
+            return visit(ArgumentType::Float, argument);
+        else if constexpr (std::is_floating_point_v<TArg>)
+            return visit(ArgumentType::Double, static_cast<double>(argument));
+        else if constexpr (std::is_same_v<TArg, char*> || std::is_same_v<TArg, const char*>)
+            return visit(ArgumentType::String, std::string_view{argument});
+        else if constexpr (std::is_convertible_v<const TArg&, std::string_view>)
+            return visit(ArgumentType::String, std::string_view{argument});
+        else if constexpr (std::is_same_v<TArg, void*> || std::is_same_v<TArg, const void*>)
+            return visit(ArgumentType::Pointer, reinterpret_cast<std::uintptr_t>(argument));
+        else if constexpr (std::is_null_pointer_v<TArg>)
+            return visit(ArgumentType::Pointer, std::uintptr_t{0});
+        else
+            return visit(ArgumentType::String, std::string_view{fmt::format("{}", argument)});
+    }
+
+
+
+    /*!
+     * A named value attached to a log call, created with kv(). It refers to
+     * the value, so it must not outlive the call it is passed to.
+     */
+    template <typename T>
+    struct Field
+    {
+        std::string_view key;
+        const T& value;
+    };
+
+    template <typename T>
+    auto kv(std::string_view key, const T& value) -> Field<T>
+    {
+        return {key, value};
+    }
+
+    template <typename T>
+    struct IsField : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct IsField<Field<T>> : std::true_type
+    {
+    };
+
+    template <typename T>
+    constexpr bool IS_FIELD = IsField<std::decay_t<T>>::value;
+
+
+
+    /*!
+     * A log call captured without formatting it.
+     *
+     * The record keeps a view on the format string and copies the arguments
+     * as tagged raw bytes into an inline buffer: arithmetic values and
+     * pointers by value, strings as length and characters. The fmt work itself
+     * is done by formatMessage(), usually on another thread. If the arguments
+     * do not fit into the buffer the message is formatted eagerly instead, as
+     * is a call with an argument fmt can only format through a user
+     * formatter, whose format spec, e.g. {:%S}, would not apply to its text.
+     * The time and the thread of the capture are kept with it, as well as the
+     * call site if the caller sets it.
+     *
+     * Fields of a structured call are captured behind the arguments as pairs
+     * of the key, encoded as string argument, and the value. Fields of user
+     * formatted types are captured as their text, fields which do not fit
+     * are encoded into a string of their own.
+     *
+     * The format string must outlive the record, i.e. it should be a literal.
+     */
+    class Record
+    {
+      public:
+        static constexpr std::size_t ARGUMENT_CAPACITY = 192;
+
+      public:
+        template <typename... TArg>
+        auto capture(Severity, std::string_view format, const TArg&... args) -> void;
+
+        /*!
+         * Captures a plain message which is copied and never parsed as format string.
+         */
+        auto captureMessage(Severity, std::string_view message) -> void;
+
+        /*!
+         * Captures the fields of a structured call after capture() or captureMessage().
+         */
+        template <typename... T>
+        auto captureFields(const Field<T>&... fields) -> void;
+
+        /*!
+         * Formats the captured call and appends the result to out. The fields
+         * follow the message as " key=value", which is how text sinks show them.
+         */
+        auto formatMessage(fmt::memory_buffer& out) const -> void;
+
+        /*!
+         * Like formatMessage() for sinks which write the fields on their own.
+         */
+        auto formatMessageWithoutFields(fmt::memory_buffer& out) const -> void;
+
+        auto getSeverity() const noexcept -> Severity;
+        auto getTimestamp() const noexcept -> std::chrono::system_clock::time_point;
+        auto getThread() const noexcept -> const ThreadIdentity&;
+
+        /*!
+         * The location must have static storage duration, nullptr if the call site is unknown.
+         */
+        auto setLocation(const SourceLocation* location) noexcept -> void;
+        auto getLocation() const noexcept -> const SourceLocation*;
+        auto getFormat() const noexcept -> std::string_view;
+        auto getArguments() const noexcept -> std::string_view;
+
+        /*!
+         * The message formatted on capture because its arguments did not fit, empty otherwise.
+         */
+        auto getEagerMessage() const noexcept -> std::string_view;
+
+        /*!
+         * The captured fields, empty for a call without fields. Read them with forEachField().
+         */
+        auto getFields() const noexcept -> std::string_view;
+
+      private:
+        template <typename T>
+        auto captureArgument(const T& argument) -> bool;
+        auto captureString(std::string_view value) -> bool;
+        template <typename T>
+        auto captureValue(ArgumentType type, T value) -> bool;
+
+      private:
+        Severity severity_ = Severity::Trace;
+        std::chrono::system_clock::time_point timestamp_{};
+        ThreadIdentity thread_{};
+        const SourceLocation* location_ = nullptr;
+        std::string_view format_{};
+        std::size_t argumentsSize_ = 0;
+        // the fields follow the arguments
+        std::size_t fieldsSize_ = 0;
+        // only the first argumentsSize_ + fieldsSize_ bytes are set, clearing the rest would cost every capture
+        std::array<char, ARGUMENT_CAPACITY> arguments_;
+        std::string eagerMessage_{};
+        std::string eagerFields_{};
+    };
+
+
+
+    /*!
+     * Formats format with arguments encoded like the ones a Record captures and appends the result to out.
+     */
+    auto formatArguments(fmt::memory_buffer& out, std::string_view format, std::string_view arguments) -> void;
+
+    /*!
+     * True if arguments consists of complete arguments of known types, so formatArguments() can read it.
+     */
+    auto isWellFormedArguments(std::string_view arguments) noexcept -> bool;
+
+    /*!
+     * Appends value encoded as a captured string argument to out.
+     */
+    auto appendStringArgument(fmt::memory_buffer& out, std::string_view value) -> void;
+
+    /*!
+     * Reads the argument at position and moves position behind it. The
+     * arguments must be well formed.
+     */
+    auto readArgument(const char*& position) -> ArgumentValue;
+
+    /*!
+     * Appends value like fmt formats the captured argument to out.
+     */
+    auto appendArgumentText(fmt::memory_buffer& out, const ArgumentValue& value) -> void;
+
+
+
+    /*!
+     * Appends argument encoded like a Record captures it to out.
+     */
+    template <typename T>
+    auto appendArgument(fmt::memory_buffer& out, const T& argument) -> void
+    {
+        visitArgument(argument, [&out](ArgumentType type, auto value) {
+            if constexpr (std::is_same_v<decltype(value), std::string_view>)
+            {
+                appendStringArgument(out, value);
+            }
+            else
+            {
+                out.push_back(static_cast<char>(type));
+                const auto* bytes = reinterpret_cast<const char*>(&value);
+                out.append(bytes, bytes + sizeof(value));
+            }
+        });
+    }
+
+
+
+    /*!
+     * Calls visit with the key and the value of every field of Record::getFields().
+     */
+    template <typename TVisit>
+    auto forEachField(std::string_view fields, TVisit&& visit) -> void
+    {
+        const char* position = fields.data();
+        const char* end      = position + fields.size();
+
+        while (position < end)
+        {
+            const ArgumentValue key = readArgument(position);
+            visit(std::get<std::string_view>(key), readArgument(position));
+        }
+    }
+
+
+
+    template <typename... TArg>
+    auto Record::capture(Severity severity, std::string_view format, const TArg&... args) -> void
+    {
+        severity_      = severity;
+        timestamp_     = captureTimestamp();
+        thread_        = getCurrentThread();
+        location_      = nullptr;
+        format_        = format;
+        argumentsSize_ = 0;
+        fieldsSize_    = 0;
+        eagerMessage_.clear();
+        eagerFields_.clear();
+
+        if constexpr ((IS_CAPTURED_RAW<std::decay_t<TArg>> && ...))
+        {
+            if ((captureArgument(args) && ...))
+                return;
+
+            argumentsSize_ = 0;
+        }
+
+        // the arguments do not fit or need a user formatter, so the message is formatted right here
+        format_       = {};
+        eagerMessage_ = fmt::vformat(format, fmt::make_format_args(args...));
+    }
+
+
+
+    template <typename... T>
+    auto Record::captureFields(const Field<T>&... fields) -> void
+    {
+        const std::size_t argumentsSize = argumentsSize_;
+        const bool fits                = ((captureString(fields.key) && captureArgument(fields.value)) && ...);
+
+        fieldsSize_    = fits ? argumentsSize_ - argumentsSize : 0;
+        argumentsSize_ = argumentsSize;
+        if (fits)
+            return;
+
+        fmt::memory_buffer encoded;
+        ((appendStringArgument(encoded, fields.key), appendArgument(encoded, fields.value)), ...);
+        eagerFields_.assign(encoded.data(), encoded.size());
+    }
+
+
+
+    template <typename T>
+    auto Record::captureArgument(const T& argument) -> bool
+    {
+        return visitArgument(argument, [this](ArgumentType type, auto value) {
+            if constexpr (std::is_same_v<decltype(value), std::string_view>)
+                return captureString(value);
+            else
+                return captureValue(type, value);
+        });
+    }
+
+
+
+    template <typename T>
+    auto Record::captureValue(ArgumentType type, T value) -> bool
+    {
+        if (argumentsSize_ + 1 + sizeof(T) > ARGUMENT_CAPACITY)
+            return false;
+
+        arguments_[argumentsSize_] = static_cast<char>(type);
+        std::memcpy(arguments_.data() + argumentsSize_ + 1, &value, sizeof(T));
+        argumentsSize_ += 1 + sizeof(T);
+        return true;
+    }
+
+} // namespace nealog
+
+template <typename T>
+struct fmt::formatter<nealog::Field<T>> : fmt::formatter<fmt::string_view>
+{
+    // checking format strings needs it, fields are written as key=value
+    template <typename TContext>
+    auto format(const nealog::Field<T>& field, TContext& context) const -> decltype(context.out())
+    {
+        return fmt::format_to(context.out(), "{}={}", field.key, field.value);
+    }
+};
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/RecordImpl.h"
+#endif // NEALOG_HEADERONLY
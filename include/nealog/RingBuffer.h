@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace nealog
+{
+
+    constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+
+
+    /*!
+     * Bounded lock-free multi-producer/single-consumer queue.
+     *
+     * Every cell carries a sequence number telling producers and the consumer
+     * whether the cell is free or holds a published value, so neither side
+     * ever takes a lock. The capacity is rounded up to the next power of two.
+     * Only one thread may call tryPop()/tryConsume() at a time.
+     */
+    template <typename T>
+    class MpscRingBuffer
+    {
+      public:
+        explicit MpscRingBuffer(std::size_t capacity);
+
+        // make it non-copyable and non-assignable
+        MpscRingBuffer(const MpscRingBuffer&) = delete;
+        MpscRingBuffer(MpscRingBuffer&&)      = delete;
+
+        auto operator=(const MpscRingBuffer&) -> MpscRingBuffer& = delete;
+        auto operator=(MpscRingBuffer&&) -> MpscRingBuffer&      = delete;
+
+      public:
+        /*!
+         * Claims a free cell and lets fill(T&) write into it in place.
+         * Returns false without calling fill if the queue is full.
+         */
+        template <typename TFill>
+        auto tryEmplace(TFill&& fill) -> bool;
+        auto tryPush(T&& value) -> bool;
+
+        /*!
+         * Hands the oldest value to consume(T&) and releases its cell afterwards.
+         * Returns false if the queue is empty.
+         */
+        template <typename TConsume>
+        auto tryConsume(TConsume&& consume) -> bool;
+        auto tryPop(T& value) -> bool;
+
+        auto empty() const noexcept -> bool;
+        auto capacity() const noexcept -> std::size_t;
+
+        /*!
+         * Number of cells claimed by producers since construction.
+         */
+        auto pushedCount() const noexcept -> std::size_t;
+
+      private:
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence{0};
+            T value{};
+        };
+
+      private:
+        std::size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> enqueuePosition_{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> dequeuePosition_{0};
+    };
+
+
+
+    template <typename T>
+    MpscRingBuffer<T>::MpscRingBuffer(std::size_t capacity)
+    {
+        std::size_t roundedCapacity = 2;
+        while (roundedCapacity < capacity)
+            roundedCapacity <<= 1;
+
+        mask_  = roundedCapacity - 1;
+        cells_ = std::make_unique<Cell[]>(roundedCapacity);
+
+        for (std::size_t i = 0; i < roundedCapacity; i++)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+
+
+    template <typename T>
+    template <typename TFill>
+    auto MpscRingBuffer<T>::tryEmplace(TFill&& fill) -> bool
+    {
+        std::size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true)
+        {
+            cell                 = &cells_[position & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference      = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (difference == 0)
+            {
+                if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(cell->value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+
+
+    template <typename T>
+    auto MpscRingBuffer<T>::tryPush(T&& value) -> bool
+    {
+        return tryEmplace([&value](T& cellValue) { cellValue = std::move(value); });
+    }
+
+
+
+    template <typename T>
+    template <typename TConsume>
+    auto MpscRingBuffer<T>::tryConsume(TConsume&& consume) -> bool
+    {
+        std::size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+        Cell* cell           = &cells_[position & mask_];
+
+        if (cell->sequence.load(std::memory_order_acquire) != position + 1)
+            return false;
+
+        consume(cell->value);
+        dequeuePosition_.store(position + 1, std::memory_order_relaxed);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+
+
+    template <typename T>
+    auto MpscRingBuffer<T>::tryPop(T& value) -> bool
+    {
+        return tryConsume([&value](T& cellValue) { value = std::move(cellValue); });
+    }
+
+
+
+    template <typename T>
+    auto MpscRingBuffer<T>::empty() const noexcept -> bool
+    {
+        std::size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+        return cells_[position & mask_].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+
+
+    template <typename T>
+    auto MpscRingBuffer<T>::capacity() const noexcept -> std::size_t
+    {
+        return mask_ + 1;
+    }
+
+
+
+    template <typename T>
+    auto MpscRingBuffer<T>::pushedCount() const noexcept -> std::size_t
+    {
+        return enqueuePosition_.load(std::memory_order_acquire);
+    }
+
+} // namespace nealog
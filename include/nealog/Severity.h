@@ -1,6 +1,24 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <string>
+#include <string_view>
+
+#define NEALOG_LEVEL_TRACE 0
+#define NEALOG_LEVEL_DEBUG 1
+#define NEALOG_LEVEL_INFO  2
+#define NEALOG_LEVEL_WARN  3
+#define NEALOG_LEVEL_ERROR 4
+#define NEALOG_LEVEL_FATAL 5
+#define NEALOG_LEVEL_OFF   6
+
+// Calls below this level are removed at compile time, see Macros.h.
+// Set through the CMake cache variable NEALOG_ACTIVE_LEVEL.
+#ifndef NEALOG_ACTIVE_LEVEL
+#define NEALOG_ACTIVE_LEVEL NEALOG_LEVEL_TRACE
+#endif // !NEALOG_ACTIVE_LEVEL
 
 namespace nealog
 {
@@ -17,24 +35,64 @@ namespace nealog
 
 
 
+    constexpr std::size_t SEVERITY_COUNT = 6;
+
+    constexpr std::array<std::string_view, SEVERITY_COUNT> SEVERITY_NAMES{"Trace", "Debug", "Info",
+                                                                          "Warn",  "Error", "Fatal"};
+    constexpr std::array<std::string_view, SEVERITY_COUNT> SEVERITY_UPPERCASE_NAMES{"TRACE", "DEBUG", "INFO",
+                                                                                    "WARN",  "ERROR", "FATAL"};
+
+
+
+    /*!
+     * Name of the severity without allocating, empty for a value outside of the enum.
+     */
+    constexpr auto severityName(Severity severity) noexcept -> std::string_view
+    {
+        const auto index = static_cast<std::size_t>(severity);
+        return index < SEVERITY_COUNT ? SEVERITY_NAMES[index] : std::string_view{};
+    }
+
+    constexpr auto severityUppercaseName(Severity severity) noexcept -> std::string_view
+    {
+        const auto index = static_cast<std::size_t>(severity);
+        return index < SEVERITY_COUNT ? SEVERITY_UPPERCASE_NAMES[index] : std::string_view{};
+    }
+
+
+
     auto severityToString(Severity severity) -> const std::string;
 
 
 
+    constexpr int ACTIVE_LEVEL = NEALOG_ACTIVE_LEVEL;
+
+    /*!
+     * False if calls of the given severity are stripped at compile time.
+     */
+    constexpr auto isActiveAtCompileTime(Severity severity) noexcept -> bool
+    {
+        return static_cast<int>(severity) >= ACTIVE_LEVEL;
+    }
+
+
+
     /*!
-     * The severity is defaulted to Severity::Trace
+     * The severity is defaulted to Severity::Trace. It is stored atomically so
+     * it can be changed while other threads are logging.
      */
     class WithSeverity
     {
       protected:
-        WithSeverity() = default;
+        WithSeverity()          = default;
+        virtual ~WithSeverity() = default;
 
       public:
-        auto setSeverity(Severity) -> void;
+        virtual auto setSeverity(Severity) -> void;
         auto getSeverity() noexcept -> Severity;
 
       protected:
-        Severity severity_ = Severity::Trace;
+        std::atomic<Severity> severity_{Severity::Trace};
     };
 
 } // namespace nealog
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "nealog/Severity.h"
+#include "nealog/Varint.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nealog
+{
+
+    constexpr const char* SIDECAR_INDEX_MAGIC    = "NEALOGI";
+    constexpr const char* SIDECAR_INDEX_SUFFIX   = ".idx";
+    constexpr std::uint8_t SIDECAR_INDEX_VERSION = 1;
+
+
+
+    /*!
+     * Kind of an entry in a sidecar index file, written as its first byte.
+     * Numbers are LEB128 varints.
+     */
+    enum class IndexEntryType : std::uint8_t
+    {
+        // SIDECAR_INDEX_MAGIC and version byte. Starts an empty logger name
+        // table, written whenever a sink opens the log file.
+        Session = 1,
+        // id and length of a logger name followed by its characters
+        LoggerName = 2,
+        // offset and size of the block in the log file, zigzag encoded
+        // nanoseconds between the first message of the previous block of the
+        // session and its first one, nanoseconds until its last message, a
+        // byte with bit n set for messages of severity n, the number of
+        // loggers followed by their name ids
+        Block = 3,
+    };
+
+
+
+    class SidecarIndexFormatException : public std::runtime_error
+    {
+      public:
+        SidecarIndexFormatException(const std::string& reason);
+    };
+
+
+
+    /*!
+     * Writes the sidecar index of a FileSink.
+     *
+     * The index splits the log file into blocks of whole messages and keeps
+     * per block its file range, when its messages reached the sink, their
+     * severities and the names of their loggers, so a reader can skip blocks
+     * without reading them. The clock is read once when a block starts and
+     * once when it ends, not for every message. Blocks end once the sink
+     * wrote blockSize bytes or more of them to the log file, so an entry
+     * never points past the written data. Callers serialize the calls,
+     * FileSink does it with its mutex.
+     */
+    class SidecarIndexWriter
+    {
+      public:
+        /*!
+         * Takes over the descriptor of the index file opened for appending.
+         */
+        SidecarIndexWriter(int fileDescriptor, std::size_t blockSize, std::uint64_t fileSize);
+        ~SidecarIndexWriter();
+
+        // make it non-copyable and non-assignable
+        SidecarIndexWriter(const SidecarIndexWriter&) = delete;
+        SidecarIndexWriter(SidecarIndexWriter&&)      = delete;
+
+        auto operator=(const SidecarIndexWriter&) -> SidecarIndexWriter& = delete;
+        auto operator=(SidecarIndexWriter&&) -> SidecarIndexWriter&      = delete;
+
+      public:
+        /*!
+         * Adds a message appended to the log file behind everything committed so far.
+         */
+        auto add(Severity, std::string_view loggerName) -> void;
+
+        /*!
+         * Tells that the log file holds fileSize bytes, which include every
+         * added message. Ends the current block if it reached the block size.
+         */
+        auto commit(std::uint64_t fileSize) -> void;
+
+        /*!
+         * Like commit() but ends the current block whatever its size.
+         */
+        auto close(std::uint64_t fileSize) -> void;
+        auto getWriteErrorCount() const noexcept -> std::size_t;
+
+      private:
+        auto internLoggerName(std::string_view loggerName) -> std::uint64_t;
+        auto writeBlock(std::uint64_t fileSize) -> void;
+        auto writeEntry() -> void;
+
+      private:
+        int fileDescriptor_;
+        std::atomic<std::size_t> writeErrorCount_{0};
+        std::size_t blockSize_;
+        std::uint64_t blockBegin_;
+        bool blockOpen_ = false;
+        std::chrono::system_clock::time_point blockOpenedAt_{};
+        std::int64_t lastBlockOpenedAt_ = 0;
+        std::uint8_t severityMask_      = 0;
+        std::vector<std::uint64_t> blockLoggers_{};
+
+        // owns the strings the keys of loggerIds_ point to
+        std::deque<std::string> loggerNames_{};
+        std::unordered_map<std::string_view, std::uint64_t> loggerIds_{};
+        // number of the block each logger was last added to, plus one
+        std::vector<std::uint64_t> loggerSeenInBlock_{};
+        std::uint64_t blockNumber_ = 0;
+        // consecutive messages mostly come from the same logger
+        const char* lastLoggerAddress_ = nullptr;
+        std::uint64_t lastLoggerId_    = 0;
+        fmt::memory_buffer entry_{};
+    };
+
+
+
+    /*!
+     * A block of a log file as found in its sidecar index.
+     */
+    struct IndexedBlock
+    {
+        std::uint64_t offset = 0;
+        std::uint64_t size   = 0;
+        // when the first and the last message of the block reached the sink
+        std::chrono::system_clock::time_point firstTimestamp{};
+        std::chrono::system_clock::time_point lastTimestamp{};
+        std::uint8_t severityMask = 0;
+        // positions in SidecarIndex::getLoggerNames()
+        std::vector<std::size_t> loggers{};
+    };
+
+
+
+    /*!
+     * What to look for in a log file. The defaults match every block. Times
+     * are compared with when the messages reached the sink, for an
+     * AsyncLogger that is a little after the log call.
+     */
+    struct IndexQuery
+    {
+        std::chrono::system_clock::time_point from = std::chrono::system_clock::time_point::min();
+        std::chrono::system_clock::time_point to   = std::chrono::system_clock::time_point::max();
+        // lowest severity of interest
+        Severity severity = Severity::Trace;
+        // a logger and its descendants, e.g. "svc.db" matches "svc.db.pool"
+        // but not "svc.dbx". Empty matches every logger.
+        std::string loggerSubtree{};
+    };
+
+
+
+    /*!
+     * True if the logger is the root of the subtree or one of its descendants.
+     */
+    auto isInLoggerSubtree(std::string_view loggerName, std::string_view subtree) noexcept -> bool;
+
+
+
+    /*!
+     * The blocks of a sidecar index read into memory. Logger names of all
+     * sessions go into a single table. Malformed or truncated input throws
+     * SidecarIndexFormatException.
+     */
+    class SidecarIndex
+    {
+      public:
+        explicit SidecarIndex(std::istream& input);
+
+      public:
+        auto getBlocks() const -> const std::vector<IndexedBlock>&;
+        auto getLoggerNames() const -> const std::vector<std::string>&;
+
+        /*!
+         * Blocks which may hold messages matching the query, in file order.
+         * The pointers stay valid as long as the index.
+         */
+        auto findBlocks(const IndexQuery& query) const -> std::vector<const IndexedBlock*>;
+
+      private:
+        auto readSession(std::string_view& input) -> void;
+        auto readLoggerName(std::string_view& input) -> void;
+        auto readBlock(std::string_view& input) -> void;
+
+      private:
+        std::vector<IndexedBlock> blocks_{};
+        std::vector<std::string> loggerNames_{};
+        std::unordered_map<std::string, std::size_t> loggerPositions_{};
+        // positions of the name ids of the current session
+        std::vector<std::size_t> sessionLoggers_{};
+        std::int64_t lastBlockOpenedAt_ = 0;
+        bool inSession_                 = false;
+    };
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/SidecarIndexImpl.h"
+#endif // NEALOG_HEADERONLY
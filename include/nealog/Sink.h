@@ -1,12 +1,23 @@
 #pragma once
 
+#include "nealog/Record.h"
 #include "nealog/Severity.h"
+#include "nealog/SidecarIndex.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <ostream>
 #include <stdexcept>
 #include <streambuf>
+#include <string>
 #include <string_view>
+#include <thread>
 #include <type_traits>
 
 namespace nealog
@@ -16,6 +27,14 @@ namespace nealog
     {
         Noop,
         Stream,
+        File,
+        RotatingFile,
+        Mmap,
+        IoUringFile,
+        BinaryFile,
+        Json,
+        Dedup,
+        Tcp,
     };
 
 
@@ -28,11 +47,41 @@ namespace nealog
 
 
 
+    class FileSinkException : public std::runtime_error
+    {
+      public:
+        FileSinkException(const std::string& path, int errorNumber);
+    };
+
+
+
+    class UnsupportedCompressionException : public std::runtime_error
+    {
+      public:
+        UnsupportedCompressionException();
+    };
+
+
+
+    /*!
+     * One formatted message handed to Sink::writeBatch().
+     */
+    struct SinkRecord
+    {
+        Severity severity;
+        std::string_view message;
+        std::string_view loggerName{};
+    };
+
+
+
     /*!
      * Abstract base class of a logger output
      */
     class Sink : public WithSeverity
     {
+        friend class FileFlushTimer;
+
       public:
         using SPtr = std::shared_ptr<Sink>;
 
@@ -42,8 +91,66 @@ namespace nealog
         virtual auto write(Severity, std::string_view) -> void = 0;
         virtual auto flush() -> void                           = 0;
 
+        /*!
+         * Writes count records in their order. Calls write() for each one by
+         * default, sinks override it to lock and hit the system only once per
+         * batch. Records below the sink severity are skipped either way.
+         */
+        virtual auto writeBatch(const SinkRecord* records, std::size_t count) -> void;
+
+        /*!
+         * write() with the name of the logger the message comes from, which
+         * is what loggers call. Only sinks keeping the name override it.
+         */
+        virtual auto writeFromLogger(std::string_view loggerName, Severity, std::string_view message) -> void;
+
+        /*!
+         * Writes a call captured but not formatted by the logger. Loggers only
+         * call it if takesRecords() is true and skip these sinks for the
+         * formatted messages. By default the message is formatted without the
+         * pattern and handed to write().
+         */
+        virtual auto writeRecord(const Record& record, std::string_view loggerName) -> void;
+
+        /*!
+         * True for sinks which encode the captured calls themselves, so the
+         * logging thread captures a Record instead of formatting the message.
+         */
+        auto takesRecords() const noexcept -> bool
+        {
+            return takesRecords_;
+        }
+
+        /*!
+         * flush() of the crash handler, which calls it inside a signal
+         * handler. A sink whose mutex stays locked until the deadline, e.g.
+         * by the crashed thread itself, is skipped. By default it calls
+         * flushLocked() with the mutex held and takes no other lock, sinks
+         * which need more override it.
+         */
+        virtual auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void;
+
+      protected:
+        /*!
+         * Tries to lock mutex_ until the deadline without blocking on it.
+         */
+        auto tryLockUntil(std::chrono::steady_clock::time_point deadline) -> bool;
+
+        /*!
+         * Hands what the sink buffers on while the caller holds mutex_,
+         * called by the default flushOnCrash(). Does nothing by default.
+         */
+        virtual auto flushLocked() -> void;
+
+        /*!
+         * Called by the FileFlushTimer at the deadline the sink gave it.
+         * Only sinks scheduling one override it.
+         */
+        virtual auto flushIfDue() -> void;
+
       protected:
         std::mutex mutex_;
+        bool takesRecords_ = false;
     };
 
 
@@ -71,9 +178,13 @@ namespace nealog
       public:
         auto getType() -> SinkType override;
         auto write(Severity, std::string_view) -> void override;
+        auto writeBatch(const SinkRecord* records, std::size_t count) -> void override;
         auto flush() -> void override;
         auto getUnderlyingStream() const -> std::shared_ptr<std::ostream>;
 
+      protected:
+        auto flushLocked() -> void override;
+
       private:
         std::shared_ptr<std::ostream> stream_ = nullptr;
     };
@@ -88,6 +199,301 @@ namespace nealog
 
 
 
+    /*!
+     * Decides when a FileSink hands its buffer to the operating system besides
+     * a full buffer, flush() and the destruction of the sink.
+     */
+    struct FileFlushPolicy
+    {
+        // Written once the oldest buffered message is older, by the next write
+        // or else by the FileFlushTimer. Zero disables it.
+        std::chrono::milliseconds interval{1000};
+        // Messages of this or a higher severity are written right away.
+        Severity severity = Severity::Error;
+    };
+
+
+
+    /*!
+     * Sidecar index a FileSink keeps next to its file, see SidecarIndexWriter.
+     */
+    struct FileIndexPolicy
+    {
+        // Writes the index to the path of the file plus SIDECAR_INDEX_SUFFIX.
+        bool enabled = false;
+        // A block ends once this many bytes of it are written to the file.
+        std::size_t blockSize = 4 * 1024 * 1024;
+    };
+
+
+
+    /*!
+     * Thread writing the buffer of a file sink, e.g. a FileSink, once its
+     * flush interval passed while no further message came in. One thread
+     * serves all sinks, it is started by the first buffered message of a sink
+     * with an interval and runs until the process exits. A sink has at most
+     * one deadline in it.
+     */
+    class FileFlushTimer
+    {
+      public:
+        /*!
+         * Never destroyed, so sinks destroyed at exit can still cancel their deadline.
+         */
+        static auto getInstance() -> FileFlushTimer&;
+
+        auto schedule(Sink* sink, std::chrono::steady_clock::time_point deadline) -> void;
+
+        /*!
+         * Removes the deadline of the sink, waiting while the thread writes it.
+         */
+        auto cancel(Sink* sink) -> void;
+
+      private:
+        FileFlushTimer() = default;
+        auto run() -> void;
+
+      private:
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::multimap<std::chrono::steady_clock::time_point, Sink*> deadlines_{};
+        Sink* flushing_ = nullptr;
+        bool started_   = false;
+    };
+
+
+
+    /*!
+     * Sink appending to a file through a raw file descriptor.
+     *
+     * Messages are copied into a large buffer which is handed to write(2)
+     * only when it is full or the flush policy fires, so most calls cost a
+     * memcpy under the sink mutex. flush() writes the buffer to the operating
+     * system but does not sync it to disk. Failed writes drop the buffered
+     * messages and are counted instead of throwing from a log call. The
+     * index policy adds a sidecar index, which assumes that nothing else
+     * appends to the file while the sink has it open.
+     */
+    class FileSink : public Sink
+    {
+      public:
+        static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+      public:
+        explicit FileSink(const std::string& path, FileFlushPolicy flushPolicy = {},
+                          std::size_t bufferSize = DEFAULT_BUFFER_SIZE, FileIndexPolicy indexPolicy = {});
+        ~FileSink() override;
+
+        // make it non-copyable and non-assignable
+        FileSink(const FileSink&) = delete;
+        FileSink(FileSink&&)      = delete;
+
+        auto operator=(const FileSink&) -> FileSink& = delete;
+        auto operator=(FileSink&&) -> FileSink&      = delete;
+
+      public:
+        auto getType() -> SinkType override;
+        auto write(Severity, std::string_view) -> void override;
+
+        /*!
+         * Copies the batch into the buffer if it fits. Otherwise the buffer
+         * and the messages are written with writev(2) without copying them.
+         */
+        auto writeBatch(const SinkRecord* records, std::size_t count) -> void override;
+        auto writeFromLogger(std::string_view loggerName, Severity, std::string_view message) -> void override;
+
+        /*!
+         * Also ends the current block of the sidecar index, so it covers
+         * everything written so far.
+         */
+        auto flush() -> void override;
+
+        /*!
+         * Writes the buffer with write(2) alone. The sidecar index is not
+         * updated, so it does not cover what this writes.
+         */
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
+        auto getPath() const -> const std::string&;
+
+        /*!
+         * Failed writes of the file and of its sidecar index.
+         */
+        auto getWriteErrorCount() const noexcept -> std::size_t;
+
+      private:
+        auto append(Severity, std::string_view message, std::string_view loggerName) -> void;
+        auto writeBuffer() -> void;
+        auto writeToFile(const char* data, std::size_t size) -> void;
+        auto writeVectored(const SinkRecord* records, std::size_t count, Severity threshold) -> void;
+        auto syncFileSize() -> void;
+        auto flushIfDue() -> void override;
+
+      private:
+        std::string path_;
+        FileFlushPolicy flushPolicy_;
+        int fileDescriptor_ = -1;
+        std::unique_ptr<char[]> buffer_;
+        std::size_t bufferCapacity_;
+        std::size_t bufferSize_ = 0;
+        std::chrono::steady_clock::time_point oldestBufferedAt_{};
+        // set while the FileFlushTimer has a deadline of this sink
+        bool flushScheduled_ = false;
+        std::atomic<std::size_t> writeErrorCount_{0};
+        // size of the file including every successful write
+        std::uint64_t fileSize_ = 0;
+        std::unique_ptr<SidecarIndexWriter> index_;
+    };
+
+
+
+    enum class SegmentCompression
+    {
+        None,
+        Gzip, // needs nealog to be built with zlib
+    };
+
+
+
+    /*!
+     * Highest number of the existing segments path.1, path.2, ... with or
+     * without a compression suffix, zero if there are none.
+     */
+    auto findLastSegment(const std::string& path) -> std::uint64_t;
+
+
+
+    /*!
+     * Decides when a RotatingFileSink starts a new file and what happens to the old ones.
+     */
+    struct RotationPolicy
+    {
+        // Rotate before the file would grow beyond this size. Zero disables it.
+        std::size_t maxSize = 64 * 1024 * 1024;
+        // Rotate at every multiple of this wall-clock interval since the epoch,
+        // e.g. every full hour. Zero disables it.
+        std::chrono::seconds interval{0};
+        // Number of closed segments kept besides the active file.
+        std::size_t keptSegments = 5;
+        SegmentCompression compression = SegmentCompression::None;
+        // After a failed rotation the next one is tried no sooner than this.
+        std::chrono::milliseconds retryDelay{1000};
+    };
+
+
+
+    /*!
+     * FileSink that moves its file aside when it gets too large or too old.
+     *
+     * Closed segments are named after the active file with an increasing
+     * number, e.g. app.log.7 or app.log.7.gz. A rotation holds the sink
+     * mutex only for one rename and opening the new file: the old FileSink
+     * keeps its descriptor on the renamed file and is handed to a background
+     * thread which writes its buffer, compresses the segment and deletes
+     * segments beyond keptSegments. A sidecar index moves along with its
+     * segment, e.g. to app.log.7.idx, and is deleted when the segment is
+     * compressed because its offsets do not fit the compressed file.
+     *
+     * If the rename or opening the new file fails, the messages go on into
+     * the active file, the failure is counted and the rotation is tried again
+     * after the retryDelay of the policy at the earliest.
+     */
+    class RotatingFileSink : public Sink
+    {
+      public:
+        explicit RotatingFileSink(const std::string& path, RotationPolicy rotationPolicy = {},
+                                  FileFlushPolicy flushPolicy = {},
+                                  std::size_t bufferSize = FileSink::DEFAULT_BUFFER_SIZE,
+                                  FileIndexPolicy indexPolicy = {});
+        ~RotatingFileSink() override;
+
+        // make it non-copyable and non-assignable
+        RotatingFileSink(const RotatingFileSink&) = delete;
+        RotatingFileSink(RotatingFileSink&&)      = delete;
+
+        auto operator=(const RotatingFileSink&) -> RotatingFileSink& = delete;
+        auto operator=(RotatingFileSink&&) -> RotatingFileSink&      = delete;
+
+      public:
+        auto getType() -> SinkType override;
+        auto write(Severity, std::string_view) -> void override;
+        auto writeBatch(const SinkRecord* records, std::size_t count) -> void override;
+        auto writeFromLogger(std::string_view loggerName, Severity, std::string_view message) -> void override;
+
+        /*!
+         * Flushes the active file and waits until the background thread
+         * finished every segment rotated before the call.
+         */
+        auto flush() -> void override;
+
+        /*!
+         * Writes the buffers of the active file and of the segments the
+         * background thread did not take yet with write(2) alone, without
+         * waiting for it.
+         */
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
+
+        /*!
+         * Closes the active file as a segment and starts a new one.
+         */
+        auto rotate() -> void;
+        auto getPath() const -> const std::string&;
+
+        /*!
+         * Path of the closed segment with the given number, without a compression suffix.
+         */
+        auto getSegmentPath(std::uint64_t segment) const -> std::string;
+
+        /*!
+         * Rotations which failed to rename the file or to open the new one.
+         */
+        auto getRotationErrorCount() const noexcept -> std::size_t;
+
+      private:
+        struct ClosedSegment
+        {
+            std::unique_ptr<FileSink> file;
+            std::uint64_t number;
+        };
+
+      private:
+        auto needsRotation(std::size_t messageSize) const -> bool;
+        auto rotateLocked() -> void;
+
+        /*!
+         * Counts a failed rotation and defers the next one by the retry delay.
+         */
+        auto backOffRotation() -> void;
+        auto computeNextRotation() const -> std::chrono::system_clock::time_point;
+        auto run() -> void;
+        auto finishSegment(ClosedSegment& segment) -> void;
+        auto compressSegment(const std::string& segmentPath) -> void;
+        auto removeSegment(std::uint64_t segment) -> bool;
+
+      private:
+        std::string path_;
+        RotationPolicy rotationPolicy_;
+        FileFlushPolicy flushPolicy_;
+        std::size_t bufferSize_;
+        FileIndexPolicy indexPolicy_;
+        std::unique_ptr<FileSink> file_;
+        std::size_t fileSize_ = 0;
+        std::uint64_t lastSegment_;
+        std::chrono::system_clock::time_point nextRotation_{};
+        // set after a failed rotation, the next one waits until then
+        std::chrono::steady_clock::time_point retryRotationAt_{};
+        std::atomic<std::size_t> rotationErrorCount_{0};
+
+        std::mutex segmentsMutex_;
+        std::condition_variable segmentsCondition_;
+        std::deque<ClosedSegment> closedSegments_{};
+        std::size_t rotatedCount_  = 0;
+        std::size_t finishedCount_ = 0;
+        bool running_              = true;
+        std::thread worker_;
+    };
+
+
+
     class SinkFactory
     {
       private:
@@ -96,6 +502,13 @@ namespace nealog
       public:
         static auto createStreamSink(const std::ostream&) -> std::shared_ptr<StreamSink>;
         static auto createStdOutSink() -> std::shared_ptr<StdOutSink>;
+        static auto createFileSink(const std::string& path, FileFlushPolicy flushPolicy = {},
+                                   std::size_t bufferSize = FileSink::DEFAULT_BUFFER_SIZE,
+                                   FileIndexPolicy indexPolicy = {}) -> std::shared_ptr<FileSink>;
+        static auto createRotatingFileSink(const std::string& path, RotationPolicy rotationPolicy = {},
+                                           FileFlushPolicy flushPolicy = {},
+                                           std::size_t bufferSize = FileSink::DEFAULT_BUFFER_SIZE,
+                                           FileIndexPolicy indexPolicy = {}) -> std::shared_ptr<RotatingFileSink>;
     };
 
 } // namespace nealog
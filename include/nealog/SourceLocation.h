@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace nealog
+{
+
+    /*!
+     * Where a log call is written in the source. The logging macros keep one
+     * in static storage per call site, so records may point at it.
+     */
+    struct SourceLocation
+    {
+        // the file name without its directories
+        std::string_view file{};
+        std::uint32_t line = 0;
+        std::string_view function{};
+    };
+
+
+
+    /*!
+     * The part of path behind its last directory separator.
+     */
+    constexpr auto sourceFileName(std::string_view path) noexcept -> std::string_view
+    {
+        const std::size_t separator = path.find_last_of("/\\");
+        return separator == std::string_view::npos ? path : path.substr(separator + 1);
+    }
+
+} // namespace nealog
+
+
+/*!
+ * The location of the expanding line as constant expression.
+ */
+#define NEALOG_SOURCE_LOCATION                                                                                      \
+    ::nealog::SourceLocation                                                                                        \
+    {                                                                                                               \
+        ::nealog::sourceFileName(__FILE__), static_cast<std::uint32_t>(__LINE__),                                   \
+            std::string_view{__func__, sizeof(__func__) - 1}                                                        \
+    }
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "nealog/Severity.h"
+#include "nealog/Sink.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+
+namespace nealog
+{
+
+    /*!
+     * What a TcpSink does with a message its buffer has no room for.
+     */
+    enum class TcpOverflow
+    {
+        Block, // the writing thread waits until the sender made room
+        Drop,  // the message is dropped and counted
+        Spill, // the message is appended to the spill file instead
+    };
+
+
+
+    /*!
+     * Configures the buffer and the connection of a TcpSink.
+     */
+    struct TcpSinkPolicy
+    {
+        // bytes buffered for the sender besides the batch it is sending
+        std::size_t bufferCapacity = 4 * 1024 * 1024;
+        TcpOverflow overflow       = TcpOverflow::Drop;
+        // file the messages without room go to if overflow is Spill
+        std::string spillPath{};
+        // the sender collects messages this long after the first one of a batch, zero sends right away
+        std::chrono::milliseconds batchDelay{5};
+        // the first reconnect waits this long, each further one twice as long up to the maximum
+        std::chrono::milliseconds minReconnectDelay{100};
+        std::chrono::milliseconds maxReconnectDelay{10000};
+        std::chrono::milliseconds connectTimeout{3000};
+        // a connection whose peer accepts no data for this long is dropped and opened again
+        std::chrono::milliseconds sendTimeout{10000};
+    };
+
+
+
+    /*!
+     * Sink sending the messages over TCP, e.g. to a log collector.
+     *
+     * Writing copies the message into a buffer under the sink mutex. A
+     * sender thread swaps that buffer for its own and hands the whole batch
+     * to send(2), so the writing threads never wait for the network and
+     * the number of system calls falls with the load. The sender connects
+     * on the first batch and reconnects with exponential backoff after a
+     * failed attempt or a broken connection, a message cut off by one is
+     * sent again in full on the next connection. While the connection is
+     * down the messages stay buffered up to bufferCapacity, the overflow
+     * policy decides about the ones beyond. Messages are sent as they are,
+     * so the pattern has to end them, e.g. with a newline.
+     *
+     * The destruction sends what is left if the connection is up, what
+     * cannot be sent is spilled or dropped like an overflow. Data which the
+     * kernel accepted before the connection broke is lost.
+     */
+    class TcpSink : public Sink
+    {
+      public:
+        TcpSink(const std::string& host, std::uint16_t port, TcpSinkPolicy policy = {});
+        ~TcpSink() override;
+
+        // make it non-copyable and non-assignable
+        TcpSink(const TcpSink&) = delete;
+        TcpSink(TcpSink&&)      = delete;
+
+        auto operator=(const TcpSink&) -> TcpSink& = delete;
+        auto operator=(TcpSink&&) -> TcpSink&      = delete;
+
+      public:
+        auto getType() -> SinkType override;
+        auto write(Severity, std::string_view) -> void override;
+
+        /*!
+         * Copies the batch into the buffer under one lock.
+         */
+        auto writeBatch(const SinkRecord* records, std::size_t count) -> void override;
+
+        /*!
+         * Waits until the messages written before are handed to the socket.
+         * Returns early once the connection is found to be down.
+         */
+        auto flush() -> void override;
+
+        /*!
+         * Waits until the deadline for the sender to hand the buffered
+         * messages to the socket, trying the lock instead of blocking on it.
+         */
+        auto flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void override;
+        auto getHost() const -> const std::string&;
+        auto getPort() const noexcept -> std::uint16_t;
+        auto isConnected() const noexcept -> bool;
+
+        /*!
+         * Connections established so far, i.e. one more than the reconnects.
+         */
+        auto getConnectionCount() const noexcept -> std::size_t;
+
+        /*!
+         * Messages dropped for lack of room.
+         */
+        auto getDroppedCount() const noexcept -> std::size_t;
+
+        /*!
+         * Messages appended to the spill file.
+         */
+        auto getSpilledCount() const noexcept -> std::size_t;
+
+      private:
+        auto append(Severity, std::string_view message, std::unique_lock<std::mutex>& lock) -> void;
+        auto run() -> void;
+        auto takePending(std::unique_lock<std::mutex>& lock) -> void;
+        auto connect() -> bool;
+        auto sendBatch() -> bool;
+        auto isClosedByPeer() const -> bool;
+        auto closeSocket() -> void;
+        auto discardUnsent() -> void;
+
+      private:
+        std::string host_;
+        std::uint16_t port_;
+        TcpSinkPolicy policy_;
+        std::unique_ptr<FileSink> spill_;
+
+        // written to under mutex_, with the end of each message
+        std::string pending_;
+        std::vector<std::size_t> pendingEnds_;
+        std::condition_variable pendingCondition_;
+        // notified when the sender took the pending messages or finished a batch
+        std::condition_variable sentCondition_;
+        // bytes ever appended to pending_ and sent, both guarded by mutex_
+        std::uint64_t queuedBytes_ = 0;
+        std::uint64_t sentBytes_   = 0;
+        bool flushRequested_       = false;
+        std::atomic<bool> running_{true};
+
+        // only touched by the sender thread
+        std::string batch_;
+        std::vector<std::size_t> batchEnds_;
+        std::size_t batchSent_ = 0;
+        int socket_            = -1;
+
+        std::atomic<bool> connected_{false};
+        // set after a failed attempt or a broken connection until the next connection
+        std::atomic<bool> connectionDown_{false};
+        std::atomic<std::size_t> connectionCount_{0};
+        std::atomic<std::size_t> droppedCount_{0};
+        std::atomic<std::size_t> spilledCount_{0};
+        std::thread worker_;
+    };
+
+} // namespace nealog
+
+#endif // !_WIN32
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/TcpSinkImpl.h"
+#endif // NEALOG_HEADERONLY
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace nealog
+{
+
+    /*!
+     * The thread a message was logged on. Records keep it, so a pattern
+     * shows the thread of the call even if another thread renders it.
+     */
+    struct ThreadIdentity
+    {
+        // the id of the operating system on Linux and macOS, a hash of std::thread::id elsewhere
+        std::uint64_t id = 0;
+        // empty unless setThreadName() named the thread
+        std::string_view name{};
+    };
+
+
+
+    /*!
+     * Identity of the calling thread. Its id is read from the operating
+     * system once per thread.
+     */
+    auto getCurrentThread() noexcept -> const ThreadIdentity&;
+
+    /*!
+     * The id of the calling thread in decimal, rendered once per thread.
+     */
+    auto getCurrentThreadIdText() noexcept -> std::string_view;
+
+    /*!
+     * Names the calling thread for the %(thread.name) placeholder. The name is
+     * copied and kept until the process ends, since queued records may still
+     * refer to it, so a thread should be named once and not renamed in a loop.
+     */
+    auto setThreadName(std::string_view name) -> void;
+
+} // namespace nealog
+
+#ifdef NEALOG_HEADERONLY
+#include "nealog_impl/ThreadImpl.h"
+#endif // NEALOG_HEADERONLY
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <fmt/format.h>
+
+namespace nealog
+{
+
+    /*!
+     * Appends value as LEB128 varint, seven bits per byte starting with the lowest ones.
+     */
+    inline auto appendVarint(fmt::memory_buffer& out, std::uint64_t value) -> void
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+
+
+    /*!
+     * Maps signed values close to zero onto small unsigned ones, so they make short varints.
+     */
+    inline auto encodeZigzag(std::int64_t value) -> std::uint64_t
+    {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+
+
+    inline auto decodeZigzag(std::uint64_t value) -> std::int64_t
+    {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+} // namespace nealog
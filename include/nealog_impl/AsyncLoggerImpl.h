@@ -0,0 +1,250 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/AsyncLogger.h"
+#endif // !NEALOG_HEADERONLY
+
+#include "nealog/CrashHandler.h"
+
+#include <chrono>
+#include <iterator>
+#include <utility>
+
+
+namespace nealog
+{
+
+    constexpr std::chrono::milliseconds ASYNC_WORKER_IDLE_TIMEOUT{10};
+
+
+
+    /******************************
+     * AsyncLogger
+     ******************************/
+    // {{{
+
+    NL_INLINE AsyncLogger::AsyncLogger(const std::string& name, std::size_t queueCapacity,
+                                       OverflowPolicy overflowPolicy)
+        : Logger(name), queue_{queueCapacity}, overflowPolicy_{overflowPolicy}
+    {
+        defersFormatting_ = true;
+        worker_ = std::thread(&AsyncLogger::run, this);
+        watchForCrash(*this);
+    }
+
+
+
+    NL_INLINE AsyncLogger::~AsyncLogger()
+    {
+        unwatchForCrash(*this);
+        running_.store(false, std::memory_order_release);
+        wakeWorker();
+
+        if (worker_.joinable())
+            worker_.join();
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::log(Severity messageSeverity, const std::string_view& message,
+                                    const SourceLocation* location) -> void
+    {
+        if (isEnabled(messageSeverity) && !recordMessage(messageSeverity, message, location))
+        {
+            enqueue([&](Record& record) {
+                record.captureMessage(messageSeverity, message);
+                record.setLocation(location);
+            });
+
+            if (messageSeverity == Severity::Fatal)
+                flush();
+        }
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::vlog(Severity messageSeverity, fmt::string_view format, fmt::format_args args,
+                                     const SourceLocation* location) -> void
+    {
+        fmt::memory_buffer& message = getThreadMessageBuffer();
+        message.clear();
+        fmt::vformat_to(std::back_inserter(message), format, args);
+        enqueue([&](Record& record) {
+            record.captureMessage(messageSeverity, {message.data(), message.size()});
+            record.setLocation(location);
+        });
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::logRecord(Record& record) -> void
+    {
+        enqueue([&](Record& queuedRecord) { queuedRecord = std::move(record); });
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::flush() -> void
+    {
+        const std::size_t target = queue_.pushedCount();
+
+        // the worker would wait for itself
+        while (std::this_thread::get_id() != worker_.get_id() &&
+               writtenCount_.load(std::memory_order_acquire) < target)
+        {
+            wakeWorker();
+            std::this_thread::yield();
+        }
+
+        Logger::flush();
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        const std::size_t target = queue_.pushedCount();
+
+        while (std::this_thread::get_id() != worker_.get_id() &&
+               writtenCount_.load(std::memory_order_acquire) < target &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+
+        // an outdated cache may point to a sink list the EpochReclaimer freed,
+        // the sinks of this logger and its ancestors are then flushed on their own
+        if (cachedGeneration_.load(std::memory_order_acquire) != generation_->load(std::memory_order_acquire))
+        {
+            Logger::flushOnCrash(deadline);
+            return;
+        }
+
+        if (const SinkList* sinks = effectiveSinks_.load(std::memory_order_acquire))
+        {
+            for (const Sink::SPtr& sink : *sinks)
+                sink->flushOnCrash(deadline);
+        }
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::getDroppedCount() const noexcept -> std::size_t
+    {
+        return droppedCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::getFailedCount() const noexcept -> std::size_t
+    {
+        return failedCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::getOverflowPolicy() const noexcept -> OverflowPolicy
+    {
+        return overflowPolicy_;
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::wakeWorker() -> void
+    {
+        std::lock_guard<std::mutex> lock{wakeMutex_};
+        wakeCondition_.notify_one();
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::run() -> void
+    {
+        batch_.reserve(WRITE_BATCH_SIZE);
+        batchEnds_.reserve(WRITE_BATCH_SIZE);
+
+        const PatternFormatter* formatter = nullptr;
+        auto render = [this, &formatter](Record& record) {
+            const std::size_t outputSize = outputBuffer_.size();
+            try
+            {
+                if (effectiveTakesRecords_.load(std::memory_order_relaxed) && !writeRecordToSinks(record))
+                    return;
+
+                messageBuffer_.clear();
+                record.formatMessage(messageBuffer_);
+
+                formatter->render(outputBuffer_, {messageBuffer_.data(), messageBuffer_.size()},
+                                  getPatternContext(record));
+                batch_.push_back({record.getSeverity(), {}, name_});
+                batchEnds_.push_back(outputBuffer_.size());
+            }
+            catch (...)
+            {
+                // the record is consumed anyway, an exception leaving the worker would terminate the process
+                outputBuffer_.resize(outputSize);
+                failedCount_.fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+
+        while (true)
+        {
+            outputBuffer_.clear();
+            batch_.clear();
+            batchEnds_.clear();
+
+            refreshCacheIfOutdated();
+            formatter = effectiveFormatter_.load(std::memory_order_acquire);
+            std::size_t consumedCount = 0;
+            while (consumedCount < WRITE_BATCH_SIZE && queue_.tryConsume(render))
+                consumedCount++;
+
+            if (consumedCount > 0)
+            {
+                // the views are only taken now, outputBuffer_ may have grown in between
+                std::size_t begin = 0;
+                for (std::size_t i = 0; i < batch_.size(); i++)
+                {
+                    batch_[i].message = {outputBuffer_.data() + begin, batchEnds_[i] - begin};
+                    begin             = batchEnds_[i];
+                }
+
+                try
+                {
+                    if (!batch_.empty())
+                        writeBatchToSinks(batch_.data(), batch_.size());
+                }
+                catch (...)
+                {
+                    failedCount_.fetch_add(batch_.size(), std::memory_order_relaxed);
+                }
+
+                // counted either way, flush() waits for it
+                writtenCount_.fetch_add(consumedCount, std::memory_order_release);
+                continue;
+            }
+
+            // everything enqueued before the shutdown is drained at this point
+            if (!running_.load(std::memory_order_acquire) && queue_.empty())
+                break;
+
+            waitForRecords();
+        }
+    }
+
+
+
+    NL_INLINE auto AsyncLogger::waitForRecords() -> void
+    {
+        std::unique_lock<std::mutex> lock{wakeMutex_};
+        workerSleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (queue_.empty() && running_.load(std::memory_order_acquire))
+            wakeCondition_.wait_for(lock, ASYNC_WORKER_IDLE_TIMEOUT);
+
+        workerSleeping_.store(false, std::memory_order_relaxed);
+    }
+    // }}}
+
+} // namespace nealog
@@ -0,0 +1,350 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/BinaryFileSink.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace nealog
+{
+
+    constexpr std::size_t BINARY_LOG_MAGIC_SIZE = 7;
+    constexpr std::size_t BINARY_LOG_READ_CHUNK = 64 * 1024;
+
+
+
+    NL_INLINE BinaryLogFormatException::BinaryLogFormatException(const std::string& reason)
+        : std::runtime_error("Malformed binary log: " + reason)
+    {
+    }
+
+
+
+    /******************************
+     * BinaryFileSink
+     ******************************/
+    // {{{
+
+    NL_INLINE BinaryFileSink::BinaryFileSink(const std::string& path, FileFlushPolicy flushPolicy,
+                                             std::size_t bufferSize)
+        : file_(path, flushPolicy, bufferSize)
+    {
+        takesRecords_ = true;
+
+        const std::uint32_t byteOrder = BINARY_LOG_BYTE_ORDER;
+        entries_.push_back(static_cast<char>(BinaryEntryType::Session));
+        entries_.append(BINARY_LOG_MAGIC, BINARY_LOG_MAGIC + BINARY_LOG_MAGIC_SIZE);
+        entries_.push_back(static_cast<char>(BINARY_LOG_VERSION));
+        entries_.append(reinterpret_cast<const char*>(&byteOrder),
+                        reinterpret_cast<const char*>(&byteOrder) + sizeof(byteOrder));
+        file_.write(Severity::Trace, {entries_.data(), entries_.size()});
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::getType() -> SinkType
+    {
+        return SinkType::BinaryFile;
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::write(Severity messageSeverity, std::string_view message) -> void
+    {
+        if (messageSeverity < severity_.load(std::memory_order_relaxed))
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        plainArguments_.clear();
+        appendStringArgument(plainArguments_, message);
+        writeEntry(messageSeverity, captureTimestamp(), PLAIN_MESSAGE_FORMAT, {},
+                   {plainArguments_.data(), plainArguments_.size()});
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::writeRecord(const Record& record, std::string_view loggerName) -> void
+    {
+        if (record.getSeverity() < severity_.load(std::memory_order_relaxed))
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (record.getFormat().data() != nullptr && record.getFields().empty())
+        {
+            writeEntry(record.getSeverity(), record.getTimestamp(), record.getFormat(), loggerName,
+                       record.getArguments());
+            return;
+        }
+
+        // formatted on capture or with fields the format does not know, it is stored like a plain message
+        plainMessage_.clear();
+        record.formatMessage(plainMessage_);
+        plainArguments_.clear();
+        appendStringArgument(plainArguments_, {plainMessage_.data(), plainMessage_.size()});
+        writeEntry(record.getSeverity(), record.getTimestamp(), PLAIN_MESSAGE_FORMAT, loggerName,
+                   {plainArguments_.data(), plainArguments_.size()});
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::flush() -> void
+    {
+        file_.flush();
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        // the entries go to the file as a whole, so a locked sink may be in the middle of one
+        if (!tryLockUntil(deadline))
+            return;
+
+        file_.flushOnCrash(deadline);
+        mutex_.unlock();
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::getPath() const -> const std::string&
+    {
+        return file_.getPath();
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::getWriteErrorCount() const noexcept -> std::size_t
+    {
+        return file_.getWriteErrorCount();
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::writeEntry(Severity messageSeverity, std::chrono::system_clock::time_point timestamp,
+                                              std::string_view format, std::string_view loggerName,
+                                              std::string_view arguments) -> void
+    {
+        entries_.clear();
+
+        // new strings are written in front of the record which uses them
+        const std::uint64_t formatId     = internString(format);
+        const std::uint64_t loggerNameId = internString(loggerName);
+
+        const std::int64_t nanoseconds =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+
+        entries_.push_back(static_cast<char>(BinaryEntryType::Record));
+        appendVarint(entries_, encodeZigzag(nanoseconds - lastTimestamp_));
+        entries_.push_back(static_cast<char>(messageSeverity));
+        appendVarint(entries_, formatId);
+        appendVarint(entries_, loggerNameId);
+        appendVarint(entries_, arguments.size());
+        entries_.append(arguments.data(), arguments.data() + arguments.size());
+        lastTimestamp_ = nanoseconds;
+
+        file_.write(messageSeverity, {entries_.data(), entries_.size()});
+    }
+
+
+
+    NL_INLINE auto BinaryFileSink::internString(std::string_view value) -> std::uint64_t
+    {
+        const auto addressBits  = reinterpret_cast<std::uintptr_t>(value.data());
+        KnownAddress& known     = knownAddresses_[(addressBits >> 3) % knownAddresses_.size()];
+        if (known.address == value.data() && value.data() != nullptr && strings_[known.id] == value)
+            return known.id;
+
+        auto position = stringIds_.find(value);
+        if (position != stringIds_.end())
+        {
+            known = {value.data(), position->second};
+            return position->second;
+        }
+
+        const std::uint64_t id = strings_.size();
+        const std::string& key = strings_.emplace_back(value);
+        stringIds_.emplace(key, id);
+        known = {value.data(), id};
+
+        entries_.push_back(static_cast<char>(BinaryEntryType::String));
+        appendVarint(entries_, id);
+        appendVarint(entries_, value.size());
+        entries_.append(value.data(), value.data() + value.size());
+        return id;
+    }
+    // }}}
+
+
+
+    NL_INLINE auto BinaryLogEntry::formatMessage(fmt::memory_buffer& out) const -> void
+    {
+        formatArguments(out, format, arguments);
+    }
+
+
+
+    /******************************
+     * BinaryLogReader
+     ******************************/
+    // {{{
+
+    NL_INLINE BinaryLogReader::BinaryLogReader(std::istream& input) : input_(input)
+    {
+    }
+
+
+
+    NL_INLINE auto BinaryLogReader::next(BinaryLogEntry& entry) -> bool
+    {
+        while (true)
+        {
+            const auto type = input_.get();
+            if (type == std::istream::traits_type::eof())
+                return false;
+
+            if (static_cast<BinaryEntryType>(type) == BinaryEntryType::Session)
+            {
+                readSession();
+                continue;
+            }
+
+            if (!inSession_)
+                throw BinaryLogFormatException("missing session header");
+
+            switch (static_cast<BinaryEntryType>(type))
+            {
+            case BinaryEntryType::String:
+                readString();
+                break;
+            case BinaryEntryType::Record:
+                readRecord(entry);
+                return true;
+            default:
+                throw BinaryLogFormatException("unknown entry type " + std::to_string(type));
+            }
+        }
+    }
+
+
+
+    NL_INLINE auto BinaryLogReader::readSession() -> void
+    {
+        std::string magic;
+        readBytes(magic, BINARY_LOG_MAGIC_SIZE);
+        if (magic != BINARY_LOG_MAGIC)
+            throw BinaryLogFormatException("not a nealog binary log");
+
+        if (readByte() != BINARY_LOG_VERSION)
+            throw BinaryLogFormatException("unsupported version");
+
+        std::string byteOrderBytes;
+        readBytes(byteOrderBytes, sizeof(std::uint32_t));
+
+        std::uint32_t byteOrder = 0;
+        std::memcpy(&byteOrder, byteOrderBytes.data(), sizeof(byteOrder));
+        if (byteOrder != BINARY_LOG_BYTE_ORDER)
+            throw BinaryLogFormatException("written with a different byte order");
+
+        strings_.clear();
+        lastTimestamp_ = 0;
+        inSession_     = true;
+    }
+
+
+
+    NL_INLINE auto BinaryLogReader::readString() -> void
+    {
+        if (readVarint() != strings_.size())
+            throw BinaryLogFormatException("string ids out of order");
+
+        const std::uint64_t size = readVarint();
+        readBytes(strings_.emplace_back(), size);
+    }
+
+
+
+    NL_INLINE auto BinaryLogReader::readRecord(BinaryLogEntry& entry) -> void
+    {
+        lastTimestamp_ += decodeZigzag(readVarint());
+
+        const std::uint8_t severity = readByte();
+        if (severity > static_cast<std::uint8_t>(Severity::Fatal))
+            throw BinaryLogFormatException("unknown severity " + std::to_string(severity));
+
+        const std::string_view format     = lookUpString(readVarint());
+        const std::string_view loggerName = lookUpString(readVarint());
+
+        readBytes(arguments_, readVarint());
+        if (!isWellFormedArguments(arguments_))
+            throw BinaryLogFormatException("malformed arguments");
+
+        entry.timestamp  = std::chrono::system_clock::time_point{
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{lastTimestamp_})};
+        entry.severity   = static_cast<Severity>(severity);
+        entry.loggerName = loggerName;
+        entry.format     = format;
+        entry.arguments  = arguments_;
+    }
+
+
+
+    NL_INLINE auto BinaryLogReader::readByte() -> std::uint8_t
+    {
+        const auto value = input_.get();
+        if (value == std::istream::traits_type::eof())
+            throw BinaryLogFormatException("unexpected end of input");
+
+        return static_cast<std::uint8_t>(value);
+    }
+
+
+
+    NL_INLINE auto BinaryLogReader::readVarint() -> std::uint64_t
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            const std::uint8_t byte = readByte();
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+
+        throw BinaryLogFormatException("number too large");
+    }
+
+
+
+    NL_INLINE auto BinaryLogReader::readBytes(std::string& target, std::uint64_t size) -> void
+    {
+        // grown chunk by chunk, a corrupt size must not allocate more than the input holds
+        target.clear();
+        while (target.size() < size)
+        {
+            const std::size_t offset = target.size();
+            const auto chunk =
+                static_cast<std::size_t>(std::min<std::uint64_t>(size - offset, BINARY_LOG_READ_CHUNK));
+
+            target.resize(offset + chunk);
+            if (!input_.read(target.data() + offset, static_cast<std::streamsize>(chunk)))
+                throw BinaryLogFormatException("unexpected end of input");
+        }
+    }
+
+
+
+    NL_INLINE auto BinaryLogReader::lookUpString(std::uint64_t id) const -> std::string_view
+    {
+        if (id >= strings_.size())
+            throw BinaryLogFormatException("unknown string id " + std::to_string(id));
+
+        return strings_[static_cast<std::size_t>(id)];
+    }
+    // }}}
+
+} // namespace nealog
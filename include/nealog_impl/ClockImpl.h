@@ -0,0 +1,227 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/Clock.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <atomic>
+#include <ctime>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define NEALOG_HAS_TSC
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define NEALOG_HAS_TSC
+#endif
+
+
+namespace nealog
+{
+
+    constexpr std::chrono::milliseconds TSC_CALIBRATION_TIME{10};
+    // a thread's own measurement of the TSC rate replaces the calibrated one only if it is this close
+    constexpr double TSC_RATE_TOLERANCE = 0.01;
+
+
+
+    NL_INLINE auto selectedClockSource() noexcept -> std::atomic<ClockSource>&
+    {
+        static std::atomic<ClockSource> source{ClockSource::Standard};
+        return source;
+    }
+
+
+
+    NL_INLINE auto systemNanoseconds() noexcept -> std::int64_t
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+
+
+    NL_INLINE auto fromNanoseconds(std::int64_t nanoseconds) noexcept -> std::chrono::system_clock::time_point
+    {
+        using namespace std::chrono;
+        return system_clock::time_point{duration_cast<system_clock::duration>(std::chrono::nanoseconds{nanoseconds})};
+    }
+
+
+
+    NL_INLINE auto readCoarseClock() noexcept -> std::chrono::system_clock::time_point
+    {
+#ifdef CLOCK_REALTIME_COARSE
+        timespec now{};
+        ::clock_gettime(CLOCK_REALTIME_COARSE, &now);
+        return fromNanoseconds(static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec);
+#else
+        return std::chrono::system_clock::now();
+#endif
+    }
+
+
+
+#ifdef NEALOG_HAS_TSC
+    NL_INLINE auto calibratedNanosecondsPerTick() noexcept -> std::atomic<double>&
+    {
+        static std::atomic<double> nanosecondsPerTick{0};
+        return nanosecondsPerTick;
+    }
+
+
+
+    NL_INLINE auto hasInvariantTsc() -> bool
+    {
+#ifdef _MSC_VER
+        int registers[4] = {};
+        __cpuid(registers, 0x80000000);
+        if (static_cast<unsigned>(registers[0]) < 0x80000007)
+            return false;
+
+        __cpuid(registers, 0x80000007);
+        return (registers[3] & (1 << 8)) != 0;
+#else
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0)
+            return false;
+
+        return (edx & (1u << 8)) != 0;
+#endif
+    }
+
+
+
+    /*!
+     * Measures the TSC rate against the system clock.
+     */
+    NL_INLINE auto calibrateTsc() -> double
+    {
+        // the counter is read around the clock, its middle is when the clock was read
+        auto readPair = [](std::uint64_t& ticks, std::int64_t& nanoseconds) {
+            const std::uint64_t before = __rdtsc();
+            nanoseconds                = systemNanoseconds();
+            ticks                      = before + (__rdtsc() - before) / 2;
+        };
+
+        std::uint64_t startTicks = 0, endTicks = 0;
+        std::int64_t start = 0, end = 0;
+        readPair(startTicks, start);
+        std::this_thread::sleep_for(TSC_CALIBRATION_TIME);
+        readPair(endTicks, end);
+
+        return static_cast<double>(end - start) / static_cast<double>(endTicks - startTicks);
+    }
+
+
+
+    NL_INLINE auto readTscClock() noexcept -> std::chrono::system_clock::time_point
+    {
+        struct Anchor
+        {
+            std::uint64_t ticks              = 0;
+            std::int64_t nanoseconds         = 0;
+            double nanosecondsPerTick        = 0;
+            std::uint64_t ticksUntilReanchor = 0;
+        };
+        thread_local Anchor anchor;
+
+        const std::uint64_t ticks   = __rdtsc();
+        const std::uint64_t elapsed = ticks - anchor.ticks;
+        if (elapsed < anchor.ticksUntilReanchor)
+            return fromNanoseconds(anchor.nanoseconds +
+                                   static_cast<std::int64_t>(static_cast<double>(elapsed) * anchor.nanosecondsPerTick));
+
+        // once per second the thread reads the system clock, which keeps
+        // the drift small and follows adjustments of the system time
+        const std::int64_t nanoseconds = systemNanoseconds();
+        const double calibrated        = calibratedNanosecondsPerTick().load(std::memory_order_relaxed);
+
+        double nanosecondsPerTick = calibrated;
+        if (anchor.ticksUntilReanchor > 0 && elapsed > 0)
+        {
+            // a whole second measures the rate far better than the calibration
+            const double measured =
+                static_cast<double>(nanoseconds - anchor.nanoseconds) / static_cast<double>(elapsed);
+            if (measured > calibrated * (1 - TSC_RATE_TOLERANCE) && measured < calibrated * (1 + TSC_RATE_TOLERANCE))
+                nanosecondsPerTick = measured;
+        }
+
+        anchor = {ticks, nanoseconds, nanosecondsPerTick, static_cast<std::uint64_t>(1e9 / nanosecondsPerTick)};
+        return fromNanoseconds(nanoseconds);
+    }
+#endif // NEALOG_HAS_TSC
+
+
+
+    NL_INLINE auto isClockSourceSupported(ClockSource source) -> bool
+    {
+        switch (source)
+        {
+        case ClockSource::Standard:
+            return true;
+        case ClockSource::RealtimeCoarse:
+#ifdef CLOCK_REALTIME_COARSE
+            return true;
+#else
+            return false;
+#endif
+        case ClockSource::Tsc:
+#ifdef NEALOG_HAS_TSC
+            return hasInvariantTsc();
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+
+
+    NL_INLINE auto setClockSource(ClockSource source) -> bool
+    {
+        if (!isClockSourceSupported(source))
+        {
+            selectedClockSource().store(ClockSource::Standard, std::memory_order_release);
+            return false;
+        }
+
+#ifdef NEALOG_HAS_TSC
+        if (source == ClockSource::Tsc)
+        {
+            static const double nanosecondsPerTick = calibrateTsc();
+            calibratedNanosecondsPerTick().store(nanosecondsPerTick, std::memory_order_relaxed);
+        }
+#endif
+
+        selectedClockSource().store(source, std::memory_order_release);
+        return true;
+    }
+
+
+
+    NL_INLINE auto getClockSource() noexcept -> ClockSource
+    {
+        return selectedClockSource().load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto captureTimestamp() noexcept -> std::chrono::system_clock::time_point
+    {
+        switch (selectedClockSource().load(std::memory_order_acquire))
+        {
+        case ClockSource::RealtimeCoarse:
+            return readCoarseClock();
+#ifdef NEALOG_HAS_TSC
+        case ClockSource::Tsc:
+            return readTscClock();
+#endif
+        default:
+            return std::chrono::system_clock::now();
+        }
+    }
+
+} // namespace nealog
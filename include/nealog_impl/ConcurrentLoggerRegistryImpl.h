@@ -0,0 +1,168 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/ConcurrentLoggerRegistry.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <string>
+
+
+namespace nealog
+{
+
+    /******************************
+     * ConcurrentLoggerRegistry
+     ******************************/
+    // {{{
+
+    NL_INLINE ConcurrentLoggerRegistry::ConcurrentLoggerRegistry()
+    {
+        auto root    = std::make_unique<Node>();
+        root->logger = std::make_shared<Logger>(ROOT_LOGGER_NAME);
+        setGenerationForLogger(generation_, root->logger);
+
+        root_ = root.get();
+        nodes_.push_back(std::move(root));
+    }
+
+
+
+    NL_INLINE auto ConcurrentLoggerRegistry::getOrCreate(std::string_view name) -> LoggerBase::SPtr
+    {
+        return getOrCreateNode(name)->logger;
+    }
+
+
+
+    NL_INLINE auto ConcurrentLoggerRegistry::getOrCreateReference(std::string_view name) -> LoggerBase&
+    {
+        return *getOrCreateNode(name)->logger;
+    }
+
+
+
+    NL_INLINE auto ConcurrentLoggerRegistry::getOrCreateNode(std::string_view name) -> Node*
+    {
+        if (Node* node = find(name))
+            return node;
+
+        std::lock_guard<std::mutex> lock{creationMutex_};
+        return create(name);
+    }
+
+
+
+    NL_INLINE auto ConcurrentLoggerRegistry::find(std::string_view name) const -> Node*
+    {
+        Node* node = root_;
+        if (name.empty())
+            return node;
+
+        std::size_t segmentStart = 0;
+        while (node != nullptr)
+        {
+            std::size_t segmentEnd = name.find(LOGGER_TREE_SEPARATOR, segmentStart);
+            if (segmentEnd == std::string_view::npos)
+                return findChild(*node, name.substr(segmentStart));
+
+            node         = findChild(*node, name.substr(segmentStart, segmentEnd - segmentStart));
+            segmentStart = segmentEnd + 1;
+        }
+
+        return nullptr;
+    }
+
+
+
+    NL_INLINE auto ConcurrentLoggerRegistry::findChild(const Node& parent, std::string_view segment) -> Node*
+    {
+        // a logger has few children, so a scan comparing the lengths first
+        // beats a binary search with full string comparisons
+        for (const ChildChunk* chunk = parent.children.load(std::memory_order_acquire); chunk != nullptr;
+             chunk                   = chunk->next.load(std::memory_order_acquire))
+        {
+            const std::size_t size = chunk->size.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < size; i++)
+            {
+                Node* child = chunk->children[i];
+                if (child->segment.size() == segment.size() &&
+                    std::char_traits<char>::compare(child->segment.data(), segment.data(), segment.size()) == 0)
+                    return child;
+            }
+        }
+
+        return nullptr;
+    }
+
+
+
+    NL_INLINE auto ConcurrentLoggerRegistry::create(std::string_view name) -> Node*
+    {
+        Node* node = root_;
+        if (name.empty())
+            return node;
+
+        std::size_t segmentStart = 0;
+        while (true)
+        {
+            std::size_t segmentEnd = name.find(LOGGER_TREE_SEPARATOR, segmentStart);
+            const bool isLast      = segmentEnd == std::string_view::npos;
+            std::string_view segment =
+                isLast ? name.substr(segmentStart) : name.substr(segmentStart, segmentEnd - segmentStart);
+
+            Node* child = findChild(*node, segment);
+            if (child == nullptr)
+                child = createChild(*node, segment, isLast ? name : name.substr(0, segmentEnd));
+
+            if (isLast)
+                return child;
+
+            node         = child;
+            segmentStart = segmentEnd + 1;
+        }
+    }
+
+
+
+    NL_INLINE auto ConcurrentLoggerRegistry::createChild(Node& parent, std::string_view segment, std::string_view name)
+        -> Node*
+    {
+        auto child     = std::make_unique<Node>();
+        child->segment = std::string{segment};
+        child->logger  = std::make_shared<Logger>(std::string{name});
+        setGenerationForLogger(generation_, child->logger);
+        setParentForLogger(parent.logger, child->logger);
+
+        ChildChunk* chunk = parent.lastChunk;
+        if (chunk == nullptr || chunk->size.load(std::memory_order_relaxed) == chunk->capacity)
+        {
+            const std::size_t capacity = chunk != nullptr ? 2 * chunk->capacity : FIRST_CHILD_CHUNK_CAPACITY;
+            childChunks_.push_back(std::make_unique<ChildChunk>(capacity));
+            ChildChunk* newChunk = childChunks_.back().get();
+
+            // an empty chunk is harmless to readers, its size publishes the children
+            (chunk != nullptr ? chunk->next : parent.children).store(newChunk, std::memory_order_release);
+            parent.lastChunk = newChunk;
+            chunk            = newChunk;
+        }
+
+        // the logger is fully set up before it becomes reachable for readers
+        const std::size_t size = chunk->size.load(std::memory_order_relaxed);
+        chunk->children[size]  = child.get();
+        chunk->size.store(size + 1, std::memory_order_release);
+
+        Node* createdChild = child.get();
+        nodes_.push_back(std::move(child));
+        return createdChild;
+    }
+    // }}}
+
+
+
+    NL_INLINE auto getDefaultRegistry() -> ConcurrentLoggerRegistry&
+    {
+        static ConcurrentLoggerRegistry registry;
+        return registry;
+    }
+
+} // namespace nealog
@@ -0,0 +1,176 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/CrashHandler.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <array>
+#include <atomic>
+#include <csignal>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+
+namespace nealog
+{
+
+#ifdef _WIN32
+    constexpr int CRASH_SIGNALS[] = {SIGSEGV, SIGABRT, SIGFPE, SIGILL};
+    using PreviousSignalHandler   = void (*)(int);
+#else
+    constexpr int CRASH_SIGNALS[] = {SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS};
+    using PreviousSignalHandler   = struct sigaction;
+#endif
+    constexpr std::size_t CRASH_SIGNAL_COUNT = sizeof(CRASH_SIGNALS) / sizeof(CRASH_SIGNALS[0]);
+
+
+
+    /*!
+     * What the signal handler reads. Nothing in it needs a destructor, so
+     * loggers destroyed after it at exit can still unwatch themselves.
+     */
+    struct CrashHandlerState
+    {
+        std::atomic<ConcurrentLoggerRegistry*> registry{nullptr};
+        std::array<std::atomic<LoggerBase*>, CRASH_WATCHED_LOGGER_SLOTS> watched{};
+        std::atomic<bool> flushing{false};
+        bool installed = false;
+        PreviousSignalHandler previous[CRASH_SIGNAL_COUNT]{};
+        alignas(16) char signalStack[CRASH_SIGNAL_STACK_SIZE]{};
+    };
+
+
+
+    NL_INLINE auto getCrashHandlerState() -> CrashHandlerState&
+    {
+        static CrashHandlerState state;
+        return state;
+    }
+
+
+
+    NL_INLINE auto restorePreviousSignalHandler(std::size_t index) -> void
+    {
+        CrashHandlerState& state = getCrashHandlerState();
+#ifdef _WIN32
+        std::signal(CRASH_SIGNALS[index], state.previous[index]);
+#else
+        ::sigaction(CRASH_SIGNALS[index], &state.previous[index], nullptr);
+#endif
+    }
+
+
+
+    NL_INLINE auto handleCrashSignal(int signalNumber) -> void
+    {
+        // a crash while flushing goes on to the previous handler right away
+        if (!getCrashHandlerState().flushing.exchange(true))
+            flushForCrash();
+
+        for (std::size_t i = 0; i < CRASH_SIGNAL_COUNT; i++)
+        {
+            if (CRASH_SIGNALS[i] == signalNumber)
+                restorePreviousSignalHandler(i);
+        }
+
+        // delivered once the handler returns, a fault would also repeat on its own
+        std::raise(signalNumber);
+    }
+
+
+
+    NL_INLINE auto installCrashHandler(ConcurrentLoggerRegistry& registry) -> void
+    {
+        CrashHandlerState& state = getCrashHandlerState();
+        state.registry.store(&registry, std::memory_order_release);
+        if (state.installed)
+            return;
+
+#ifdef _WIN32
+        for (std::size_t i = 0; i < CRASH_SIGNAL_COUNT; i++)
+            state.previous[i] = std::signal(CRASH_SIGNALS[i], handleCrashSignal);
+#else
+        // a stack set up before, e.g. by a sanitizer, is kept
+        stack_t currentStack{};
+        if (::sigaltstack(nullptr, &currentStack) == 0 && (currentStack.ss_flags & SS_DISABLE) != 0)
+        {
+            stack_t stack{};
+            stack.ss_sp   = state.signalStack;
+            stack.ss_size = sizeof(state.signalStack);
+            ::sigaltstack(&stack, nullptr);
+        }
+
+        struct sigaction action
+        {
+        };
+        action.sa_handler = handleCrashSignal;
+        action.sa_flags   = SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+
+        for (std::size_t i = 0; i < CRASH_SIGNAL_COUNT; i++)
+            ::sigaction(CRASH_SIGNALS[i], &action, &state.previous[i]);
+#endif
+
+        state.installed = true;
+    }
+
+
+
+    NL_INLINE auto uninstallCrashHandler() -> void
+    {
+        CrashHandlerState& state = getCrashHandlerState();
+        if (!state.installed)
+            return;
+
+        for (std::size_t i = 0; i < CRASH_SIGNAL_COUNT; i++)
+            restorePreviousSignalHandler(i);
+
+        state.registry.store(nullptr, std::memory_order_release);
+        state.installed = false;
+    }
+
+
+
+    NL_INLINE auto watchForCrash(LoggerBase& logger) -> bool
+    {
+        for (std::atomic<LoggerBase*>& slot : getCrashHandlerState().watched)
+        {
+            LoggerBase* expected = nullptr;
+            if (slot.compare_exchange_strong(expected, &logger, std::memory_order_acq_rel))
+                return true;
+        }
+        return false;
+    }
+
+
+
+    NL_INLINE auto unwatchForCrash(LoggerBase& logger) -> void
+    {
+        for (std::atomic<LoggerBase*>& slot : getCrashHandlerState().watched)
+        {
+            LoggerBase* expected = &logger;
+            if (slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel))
+                return;
+        }
+    }
+
+
+
+    NL_INLINE auto flushForCrash() -> void
+    {
+        CrashHandlerState& state = getCrashHandlerState();
+        const auto deadline      = std::chrono::steady_clock::now() + CRASH_FLUSH_TIMEOUT;
+
+        for (std::atomic<LoggerBase*>& slot : state.watched)
+        {
+            if (LoggerBase* logger = slot.load(std::memory_order_acquire))
+                logger->flushOnCrash(deadline);
+        }
+
+        if (ConcurrentLoggerRegistry* registry = state.registry.load(std::memory_order_acquire))
+            registry->forEachLogger([deadline](LoggerBase& logger) { logger.flushOnCrash(deadline); });
+    }
+
+} // namespace nealog
@@ -0,0 +1,323 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/DedupSink.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <functional>
+#include <iterator>
+#include <mutex>
+
+
+namespace nealog
+{
+
+    constexpr const char* DEDUP_NEEDS_PATTERN =
+        "a DedupSink in front of a sink not taking records needs the pattern to render its lines with";
+
+
+
+    NL_INLINE DedupPatternException::DedupPatternException() : std::runtime_error(DEDUP_NEEDS_PATTERN)
+    {
+    }
+
+
+
+    NL_INLINE auto hashDedupKey(Severity severity, std::string_view loggerName, std::string_view message) noexcept
+        -> std::uint64_t
+    {
+        const std::uint64_t messageHash = std::hash<std::string_view>{}(message);
+        const std::uint64_t loggerHash  = std::hash<std::string_view>{}(loggerName);
+        return messageHash ^ (loggerHash * 0x9E3779B97F4A7C15ULL) ^ static_cast<std::uint64_t>(severity);
+    }
+
+
+
+    NL_INLINE auto getThreadDedupBuffer() -> fmt::memory_buffer&
+    {
+        // the message of a call, formatted before the sink is locked
+        thread_local fmt::memory_buffer buffer;
+        return buffer;
+    }
+
+
+
+    /******************************
+     * DedupSink
+     ******************************/
+    // {{{
+
+    NL_INLINE DedupSink::DedupSink(Sink::SPtr target, DedupPolicy policy, const PatternFormatter& formatter)
+        : target_(std::move(target)), policy_{policy}, formatter_{formatter}, entries_(policy.capacity)
+    {
+        takesRecords_ = true;
+
+        std::size_t tableSize = 1;
+        while (tableSize < 2 * policy_.capacity)
+            tableSize *= 2;
+        slotByHash_.assign(tableSize, 0);
+        hashMask_ = tableSize - 1;
+
+        if (policy_.capacity > 0)
+            worker_ = std::thread(&DedupSink::run, this);
+    }
+
+
+
+    NL_INLINE DedupSink::DedupSink(Sink::SPtr target, DedupPolicy policy)
+        : DedupSink(std::move(target), policy, PatternFormatter{""})
+    {
+        if (!target_->takesRecords())
+            throw DedupPatternException();
+    }
+
+
+
+    NL_INLINE DedupSink::~DedupSink()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            running_ = false;
+        }
+        windowCondition_.notify_all();
+
+        if (worker_.joinable())
+            worker_.join();
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        while (size_ > 0)
+            closeOldestWindow();
+    }
+
+
+
+    NL_INLINE auto DedupSink::getType() -> SinkType
+    {
+        return SinkType::Dedup;
+    }
+
+
+
+    NL_INLINE auto DedupSink::write(Severity messageSeverity, std::string_view message) -> void
+    {
+        Record record;
+        record.captureMessage(messageSeverity, message);
+        writeRecord(record, {});
+    }
+
+
+
+    NL_INLINE auto DedupSink::writeRecord(const Record& record, std::string_view loggerName) -> void
+    {
+        if (record.getSeverity() < severity_.load(std::memory_order_relaxed))
+            return;
+
+        fmt::memory_buffer& message = getThreadDedupBuffer();
+        message.clear();
+        record.formatMessage(message);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (!isRepeat(record, loggerName, {message.data(), message.size()}))
+            forward(record, loggerName, {message.data(), message.size()});
+    }
+
+
+
+    NL_INLINE auto DedupSink::flush() -> void
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            while (size_ > 0)
+                closeOldestWindow();
+        }
+        target_->flush();
+    }
+
+
+
+    NL_INLINE auto DedupSink::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        if (tryLockUntil(deadline))
+        {
+            while (size_ > 0)
+                closeOldestWindow();
+            mutex_.unlock();
+        }
+        target_->flushOnCrash(deadline);
+    }
+
+
+
+    NL_INLINE auto DedupSink::getTarget() const -> const Sink::SPtr&
+    {
+        return target_;
+    }
+
+
+
+    NL_INLINE auto DedupSink::getPolicy() const noexcept -> const DedupPolicy&
+    {
+        return policy_;
+    }
+
+
+
+    NL_INLINE auto DedupSink::getCollapsedCount() const noexcept -> std::size_t
+    {
+        return collapsedCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto DedupSink::isRepeat(const Record& record, std::string_view loggerName, std::string_view message)
+        -> bool
+    {
+        if (policy_.capacity == 0)
+            return false;
+
+        closeWindowsUntil(record.getTimestamp());
+
+        const std::uint64_t hash = hashDedupKey(record.getSeverity(), loggerName, message);
+        if (const std::size_t found = findSlot(hash); found != policy_.capacity)
+        {
+            Entry& entry = entries_[found];
+            if (entry.severity != record.getSeverity() || entry.loggerName != loggerName || entry.message != message)
+                return false; // same hash as a tracked message, written without being tracked
+
+            entry.repeats++;
+            collapsedCount_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        if (size_ == policy_.capacity)
+            closeOldestWindow();
+
+        const std::size_t slot = (oldest_ + size_) % policy_.capacity;
+        Entry& entry           = entries_[slot];
+        entry.hash             = hash;
+        entry.severity         = record.getSeverity();
+        entry.loggerName.assign(loggerName.data(), loggerName.size());
+        entry.message.assign(message.data(), message.size());
+        entry.location  = record.getLocation();
+        entry.windowEnd = record.getTimestamp() + policy_.window;
+        entry.repeats   = 0;
+
+        std::size_t position = hash & hashMask_;
+        while (slotByHash_[position] != 0)
+            position = (position + 1) & hashMask_;
+        slotByHash_[position] = static_cast<std::uint32_t>(slot + 1);
+        // the thread waits for the end of the oldest window, which this one is now
+        if (size_++ == 0)
+            windowCondition_.notify_all();
+        return false;
+    }
+
+
+
+    NL_INLINE auto DedupSink::closeWindowsUntil(std::chrono::system_clock::time_point timestamp) -> void
+    {
+        while (size_ > 0 && entries_[oldest_].windowEnd <= timestamp)
+            closeOldestWindow();
+    }
+
+
+
+    NL_INLINE auto DedupSink::run() -> void
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+
+        while (running_)
+        {
+            if (size_ == 0)
+            {
+                windowCondition_.wait(lock);
+                continue;
+            }
+
+            // later windows end later, so waking at the end of the oldest one is enough
+            windowCondition_.wait_until(lock, entries_[oldest_].windowEnd);
+            if (running_)
+                closeWindowsUntil(std::chrono::system_clock::now());
+        }
+    }
+
+
+
+    NL_INLINE auto DedupSink::closeOldestWindow() -> void
+    {
+        const Entry& entry = entries_[oldest_];
+        eraseSlot(entry.hash, oldest_);
+        oldest_ = (oldest_ + 1) % policy_.capacity;
+        size_--;
+
+        // the slot is only reused by the next tracked message
+        if (entry.repeats == 0)
+            return;
+
+        repeatsMessage_.clear();
+        fmt::format_to(std::back_inserter(repeatsMessage_), "repeated {} times: {}", entry.repeats, entry.message);
+
+        const std::string_view message{repeatsMessage_.data(), repeatsMessage_.size()};
+        repeatsRecord_.captureMessage(entry.severity, message);
+        repeatsRecord_.setLocation(entry.location);
+        forward(repeatsRecord_, entry.loggerName, message);
+    }
+
+
+
+    NL_INLINE auto DedupSink::findSlot(std::uint64_t hash) const -> std::size_t
+    {
+        std::size_t position = hash & hashMask_;
+        while (slotByHash_[position] != 0)
+        {
+            const std::size_t slot = slotByHash_[position] - 1;
+            if (entries_[slot].hash == hash)
+                return slot;
+            position = (position + 1) & hashMask_;
+        }
+        return policy_.capacity;
+    }
+
+
+
+    NL_INLINE auto DedupSink::eraseSlot(std::uint64_t hash, std::size_t slot) -> void
+    {
+        std::size_t hole = hash & hashMask_;
+        while (slotByHash_[hole] != slot + 1)
+            hole = (hole + 1) & hashMask_;
+
+        // moves later entries of the probe sequence into the hole, so lookups need no tombstones
+        std::size_t position = (hole + 1) & hashMask_;
+        while (slotByHash_[position] != 0)
+        {
+            const std::size_t home = entries_[slotByHash_[position] - 1].hash & hashMask_;
+            if (((position - home) & hashMask_) >= ((position - hole) & hashMask_))
+            {
+                slotByHash_[hole] = slotByHash_[position];
+                hole              = position;
+            }
+            position = (position + 1) & hashMask_;
+        }
+        slotByHash_[hole] = 0;
+    }
+
+
+
+    NL_INLINE auto DedupSink::forward(const Record& record, std::string_view loggerName, std::string_view message)
+        -> void
+    {
+        if (target_->takesRecords())
+        {
+            target_->writeRecord(record, loggerName);
+            return;
+        }
+
+        line_.clear();
+        formatter_.render(line_, message,
+                          {record.getTimestamp(), record.getSeverity(), loggerName, &record.getThread(),
+                           record.getLocation()});
+        target_->writeFromLogger(loggerName, record.getSeverity(), {line_.data(), line_.size()});
+    }
+    // }}}
+
+} // namespace nealog
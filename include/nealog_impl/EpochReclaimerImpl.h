@@ -0,0 +1,115 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/EpochReclaimer.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <algorithm>
+#include <iterator>
+
+
+namespace nealog
+{
+
+    NL_INLINE EpochReclaimer::ThreadSlotOwner::~ThreadSlotOwner()
+    {
+        slot->epoch.store(IDLE, std::memory_order_release);
+        slot->inUse.store(false, std::memory_order_release);
+    }
+
+
+
+    NL_INLINE auto EpochReclaimer::getInstance() -> EpochReclaimer&
+    {
+        static EpochReclaimer* reclaimer = new EpochReclaimer;
+        return *reclaimer;
+    }
+
+
+
+    NL_INLINE auto EpochReclaimer::retire(std::shared_ptr<const void> snapshot) -> void
+    {
+        // destroyed without the lock, a sink may flush or log while it is destroyed
+        std::vector<std::shared_ptr<const void>> freed;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            retired_.emplace_back(epoch_.load(std::memory_order_relaxed), std::move(snapshot));
+            collect(freed);
+        }
+    }
+
+
+
+    NL_INLINE auto EpochReclaimer::reclaim() -> void
+    {
+        std::vector<std::shared_ptr<const void>> freed;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            collect(freed);
+        }
+    }
+
+
+
+    NL_INLINE auto EpochReclaimer::getRetiredCount() -> std::size_t
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return retired_.size();
+    }
+
+
+
+    NL_INLINE auto EpochReclaimer::acquireSlot() -> ThreadSlot*
+    {
+        for (ThreadSlot* slot = slots_.load(std::memory_order_acquire); slot != nullptr; slot = slot->next)
+        {
+            bool inUse = false;
+            if (slot->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+                return slot;
+        }
+
+        auto* slot = new ThreadSlot;
+        slot->next = slots_.load(std::memory_order_relaxed);
+        while (!slots_.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        return slot;
+    }
+
+
+
+    NL_INLINE auto EpochReclaimer::tryAdvance() -> bool
+    {
+        // pairs with the fence in enter()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+        for (ThreadSlot* slot = slots_.load(std::memory_order_acquire); slot != nullptr; slot = slot->next)
+        {
+            const std::uint64_t announced = slot->epoch.load(std::memory_order_acquire);
+            if (announced != IDLE && announced != epoch)
+                return false;
+        }
+
+        epoch_.store(epoch + 1, std::memory_order_release);
+        return true;
+    }
+
+
+
+    NL_INLINE auto EpochReclaimer::collect(std::vector<std::shared_ptr<const void>>& freed) -> void
+    {
+        // two advances at most, a snapshot retired in the current epoch is freed after the second
+        for (int i = 0; i < 2 && tryAdvance(); i++)
+        {
+        }
+
+        const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+        auto kept = std::stable_partition(retired_.begin(), retired_.end(),
+                                          [epoch](const auto& retired) { return retired.first + 2 > epoch; });
+        for (auto it = kept; it != retired_.end(); ++it)
+            freed.push_back(std::move(it->second));
+        retired_.erase(kept, retired_.end());
+    }
+
+} // namespace nealog
@@ -0,0 +1,71 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/FlightRecorder.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <utility>
+
+
+namespace nealog
+{
+
+    NL_INLINE FlightRecorder::FlightRecorder(const FlightRecorderPolicy& policy)
+        : policy_(policy), records_(policy.capacity)
+    {
+    }
+
+
+
+    NL_INLINE auto FlightRecorder::keep(Record& record) -> void
+    {
+        if (records_.empty())
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        records_[next_] = std::move(record);
+        next_           = (next_ + 1) % records_.size();
+        if (size_ < records_.size())
+            size_++;
+    }
+
+
+
+    NL_INLINE auto FlightRecorder::takeAll(std::vector<Record>& records) -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        records.clear();
+        if (size_ == 0)
+            return;
+
+        // the oldest record is size_ slots behind the next one
+        records.reserve(size_);
+        std::size_t position = (next_ + records_.size() - size_) % records_.size();
+        for (std::size_t i = 0; i < size_; i++)
+        {
+            records.push_back(std::move(records_[position]));
+            position = (position + 1) % records_.size();
+        }
+
+        next_ = 0;
+        size_ = 0;
+    }
+
+
+
+    NL_INLINE auto FlightRecorder::getSize() -> std::size_t
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return size_;
+    }
+
+
+
+    NL_INLINE auto FlightRecorder::getPolicy() const noexcept -> const FlightRecorderPolicy&
+    {
+        return policy_;
+    }
+
+} // namespace nealog
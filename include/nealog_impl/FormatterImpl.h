@@ -4,28 +4,153 @@
 #include "nealog/Formatter.h"
 #endif // !NEALOG_HEADERONLY
 
+#include <ctime>
+#include <iterator>
+#include <limits>
 #include <string>
 
 namespace nealog
 {
-    NL_INLINE PatternFormatter::PatternFormatter(const std::string_view& pattern) : pattern_{pattern}
+    constexpr const char* TIMESTAMP_SECONDS_FORMAT = "%Y-%m-%d %H:%M:%S.";
+    constexpr std::int64_t NANOSECONDS_PER_SECOND  = 1000000000;
+    constexpr unsigned MAX_FRACTION_DIGITS         = 9;
+
+
+
+    NL_INLINE auto appendTimestamp(fmt::memory_buffer& out, std::chrono::system_clock::time_point timestamp,
+                                   unsigned fractionDigits) -> void
     {
+        struct Cache
+        {
+            std::int64_t second = std::numeric_limits<std::int64_t>::min();
+            std::array<char, 64> text{};
+            // up to and including the decimal point
+            std::size_t secondsSize = 0;
+        };
+        thread_local Cache cache;
+
+        const std::int64_t nanoseconds =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+        std::int64_t second   = nanoseconds / NANOSECONDS_PER_SECOND;
+        std::int64_t fraction = nanoseconds % NANOSECONDS_PER_SECOND;
+        if (fraction < 0)
+        {
+            second--;
+            fraction += NANOSECONDS_PER_SECOND;
+        }
+
+        if (second != cache.second)
+        {
+            const auto seconds = static_cast<std::time_t>(second);
+            std::tm localTime{};
+#ifdef _WIN32
+            ::localtime_s(&localTime, &seconds);
+#else
+            ::localtime_r(&seconds, &localTime);
+#endif
+            cache.secondsSize = std::strftime(cache.text.data(), cache.text.size() - MAX_FRACTION_DIGITS,
+                                              TIMESTAMP_SECONDS_FORMAT, &localTime);
+            cache.second      = second;
+        }
+
+        fractionDigits = std::min(fractionDigits, MAX_FRACTION_DIGITS);
+        for (unsigned i = fractionDigits; i < MAX_FRACTION_DIGITS; i++)
+            fraction /= 10;
+
+        char* digits = cache.text.data() + cache.secondsSize;
+        for (unsigned i = fractionDigits; i > 0; i--)
+        {
+            digits[i - 1] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+
+        out.append(cache.text.data(), digits + fractionDigits);
     }
 
 
 
-    NL_INLINE auto PatternFormatter::wrapMessageWithPattern(const std::string_view& msg) -> std::string
+    NL_INLINE auto appendContext(fmt::memory_buffer& out, PatternTokenType type, const PatternContext& context)
+        -> void
     {
-        std::string copiedPattern{pattern_};
-        size_t position = copiedPattern.find(MESSAGE_SUBSTITUTOR);
+        auto append         = [&out](std::string_view text) { out.append(text.data(), text.data() + text.size()); };
+        auto appendThreadId = [&]() {
+            if (context.thread == nullptr)
+            {
+                append(getCurrentThreadIdText());
+                return;
+            }
+
+            const fmt::format_int id{context.thread->id};
+            out.append(id.data(), id.data() + id.size());
+        };
 
-        while (position != std::string::npos)
+        switch (type)
         {
-            copiedPattern.replace(position, strlen(MESSAGE_SUBSTITUTOR), msg);
-            position = copiedPattern.find(MESSAGE_SUBSTITUTOR);
+        case PatternTokenType::Severity:
+            append(severityName(context.severity));
+            break;
+        case PatternTokenType::SeverityUppercase:
+            append(severityUppercaseName(context.severity));
+            break;
+        case PatternTokenType::Logger:
+            append(context.loggerName);
+            break;
+        case PatternTokenType::Thread:
+            appendThreadId();
+            break;
+        case PatternTokenType::ThreadName: {
+            const ThreadIdentity& thread = context.thread != nullptr ? *context.thread : getCurrentThread();
+            if (thread.name.empty())
+                appendThreadId();
+            else
+                append(thread.name);
+            break;
         }
+        case PatternTokenType::File:
+            if (context.location != nullptr)
+                append(context.location->file);
+            break;
+        case PatternTokenType::Line:
+            if (context.location != nullptr)
+            {
+                const fmt::format_int line{context.location->line};
+                out.append(line.data(), line.data() + line.size());
+            }
+            break;
+        case PatternTokenType::Function:
+            if (context.location != nullptr)
+                append(context.location->function);
+            break;
+        default:
+            break;
+        }
+    }
+
+
+
+    NL_INLINE PatternFormatter::PatternFormatter(const std::string_view& pattern) : pattern_{pattern}
+    {
+        tokenizePattern(pattern_, [this](PatternToken token) { tokens_.push_back(token); });
+    }
 
-        return copiedPattern;
+
+
+    NL_INLINE auto PatternFormatter::vformatTo(fmt::memory_buffer& out, fmt::string_view msg, fmt::format_args args,
+                                               const PatternContext& context) const -> void
+    {
+        renderPattern(out, pattern_, tokens_.data(), tokens_.data() + tokens_.size(), context,
+                      [&](fmt::memory_buffer& buffer) { fmt::vformat_to(std::back_inserter(buffer), msg, args); });
+    }
+
+
+
+    NL_INLINE auto PatternFormatter::render(fmt::memory_buffer& out, std::string_view message,
+                                            const PatternContext& context) const -> void
+    {
+        renderPattern(out, pattern_, tokens_.data(), tokens_.data() + tokens_.size(), context,
+                      [&](fmt::memory_buffer& buffer) {
+                          buffer.append(message.data(), message.data() + message.size());
+                      });
     }
 
     NL_INLINE auto PatternFormatter::getPattern() const -> const std::string&
@@ -0,0 +1,586 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/IoUringFileSink.h"
+#endif // !NEALOG_HEADERONLY
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <linux/io_uring.h>
+#define NEALOG_HAS_IO_URING 1
+#endif
+
+
+namespace nealog
+{
+
+#ifdef NEALOG_HAS_IO_URING
+
+    // marks the completion of a sync entry, the lower bits hold the buffer index
+    constexpr std::uint64_t SYNC_COMPLETION_FLAG = std::uint64_t{1} << 63;
+
+
+
+    /******************************
+     * IoUringFileSink::Ring
+     ******************************/
+    // {{{
+
+    /*!
+     * Minimal io_uring submission and completion queue driven through the raw
+     * syscalls. Only the thread holding the sink mutex touches it.
+     */
+    struct IoUringFileSink::Ring
+    {
+        int fileDescriptor             = -1;
+        void* submissionRing           = MAP_FAILED;
+        std::size_t submissionRingSize = 0;
+        void* completionRing           = MAP_FAILED;
+        std::size_t completionRingSize = 0;
+        io_uring_sqe* entries          = static_cast<io_uring_sqe*>(MAP_FAILED);
+        std::size_t entriesSize        = 0;
+
+        unsigned* submissionHead  = nullptr;
+        unsigned* submissionTail  = nullptr;
+        unsigned* submissionArray = nullptr;
+        unsigned submissionMask   = 0;
+        unsigned localTail        = 0;
+        unsigned unsubmitted      = 0;
+
+        unsigned* completionHead  = nullptr;
+        unsigned* completionTail  = nullptr;
+        io_uring_cqe* completions = nullptr;
+        unsigned completionMask   = 0;
+
+        ~Ring();
+        auto setup(unsigned entryCount) -> bool;
+        auto nextEntry() -> io_uring_sqe*;
+        auto enter(unsigned minimumCompletions) -> int;
+    };
+
+
+
+    NL_INLINE IoUringFileSink::Ring::~Ring()
+    {
+        if (entries != MAP_FAILED)
+            ::munmap(entries, entriesSize);
+        if (completionRing != MAP_FAILED && completionRing != submissionRing)
+            ::munmap(completionRing, completionRingSize);
+        if (submissionRing != MAP_FAILED)
+            ::munmap(submissionRing, submissionRingSize);
+        if (fileDescriptor >= 0)
+            ::close(fileDescriptor);
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::Ring::setup(unsigned entryCount) -> bool
+    {
+        io_uring_params parameters{};
+        fileDescriptor = static_cast<int>(::syscall(__NR_io_uring_setup, entryCount, &parameters));
+        if (fileDescriptor < 0)
+            return false;
+
+        // IORING_OP_WRITE came with the same kernel as this feature
+        if ((parameters.features & IORING_FEAT_RW_CUR_POS) == 0)
+            return false;
+
+        submissionRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+        completionRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+
+        const bool singleMapping = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMapping)
+            submissionRingSize = completionRingSize = std::max(submissionRingSize, completionRingSize);
+
+        submissionRing = ::mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                fileDescriptor, IORING_OFF_SQ_RING);
+        if (submissionRing == MAP_FAILED)
+            return false;
+
+        completionRing = singleMapping ? submissionRing
+                                       : ::mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE,
+                                                MAP_SHARED | MAP_POPULATE, fileDescriptor, IORING_OFF_CQ_RING);
+        if (completionRing == MAP_FAILED)
+            return false;
+
+        entriesSize = parameters.sq_entries * sizeof(io_uring_sqe);
+        entries     = static_cast<io_uring_sqe*>(::mmap(nullptr, entriesSize, PROT_READ | PROT_WRITE,
+                                                        MAP_SHARED | MAP_POPULATE, fileDescriptor, IORING_OFF_SQES));
+        if (entries == MAP_FAILED)
+            return false;
+
+        auto* submission = static_cast<char*>(submissionRing);
+        submissionHead   = reinterpret_cast<unsigned*>(submission + parameters.sq_off.head);
+        submissionTail   = reinterpret_cast<unsigned*>(submission + parameters.sq_off.tail);
+        submissionArray  = reinterpret_cast<unsigned*>(submission + parameters.sq_off.array);
+        submissionMask   = *reinterpret_cast<unsigned*>(submission + parameters.sq_off.ring_mask);
+        localTail        = *submissionTail;
+
+        auto* completion = static_cast<char*>(completionRing);
+        completionHead   = reinterpret_cast<unsigned*>(completion + parameters.cq_off.head);
+        completionTail   = reinterpret_cast<unsigned*>(completion + parameters.cq_off.tail);
+        completions      = reinterpret_cast<io_uring_cqe*>(completion + parameters.cq_off.cqes);
+        completionMask   = *reinterpret_cast<unsigned*>(completion + parameters.cq_off.ring_mask);
+        return true;
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::Ring::nextEntry() -> io_uring_sqe*
+    {
+        const unsigned index = localTail & submissionMask;
+        io_uring_sqe* entry  = &entries[index];
+        std::memset(entry, 0, sizeof(io_uring_sqe));
+
+        submissionArray[index] = index;
+        localTail++;
+        unsubmitted++;
+        return entry;
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::Ring::enter(unsigned minimumCompletions) -> int
+    {
+        // the kernel only reads the entries once the tail is published
+        __atomic_store_n(submissionTail, localTail, __ATOMIC_RELEASE);
+
+        const unsigned flags = minimumCompletions > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int result;
+        do
+        {
+            result = static_cast<int>(
+                ::syscall(__NR_io_uring_enter, fileDescriptor, unsubmitted, minimumCompletions, flags, nullptr, 0));
+        } while (result < 0 && errno == EINTR);
+
+        if (result > 0)
+            unsubmitted -= std::min(static_cast<unsigned>(result), unsubmitted);
+        return result;
+    }
+    // }}}
+
+#else
+
+    struct IoUringFileSink::Ring
+    {
+    };
+
+#endif // NEALOG_HAS_IO_URING
+
+
+
+    /******************************
+     * IoUringFileSink
+     ******************************/
+    // {{{
+
+    NL_INLINE IoUringFileSink::IoUringFileSink(const std::string& path, FileFlushPolicy flushPolicy,
+                                               FileDurability durability, std::size_t bufferSize,
+                                               std::size_t bufferCount)
+        : path_(path), flushPolicy_(flushPolicy), durability_(durability),
+          buffers_(std::max<std::size_t>(bufferCount, 1)), bufferCapacity_(bufferSize)
+    {
+        for (Buffer& buffer : buffers_)
+            buffer.data.reset(new char[bufferSize]);
+
+        fileDescriptor_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (fileDescriptor_ < 0)
+            throw FileSinkException(path, errno);
+
+        fileOffset_ = static_cast<std::uint64_t>(::lseek(fileDescriptor_, 0, SEEK_END));
+
+#ifdef NEALOG_HAS_IO_URING
+        // every buffer needs a write and possibly a sync entry
+        auto ring = std::make_unique<Ring>();
+        if (ring->setup(static_cast<unsigned>(2 * buffers_.size())))
+        {
+            ring_ = std::move(ring);
+            usingIoUring_.store(true, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+
+
+    NL_INLINE IoUringFileSink::~IoUringFileSink()
+    {
+        if (flushPolicy_.interval.count() > 0)
+            FileFlushTimer::getInstance().cancel(this);
+
+        flush();
+        ring_.reset();
+        ::close(fileDescriptor_);
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::getType() -> SinkType
+    {
+        return SinkType::IoUringFile;
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::write(Severity messageSeverity, std::string_view message) -> void
+    {
+        if (messageSeverity < severity_.load(std::memory_order_relaxed))
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        append(messageSeverity, message);
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::writeBatch(const SinkRecord* records, std::size_t count) -> void
+    {
+        const Severity threshold = severity_.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (records[i].severity >= threshold)
+                append(records[i].severity, records[i].message);
+        }
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::append(Severity messageSeverity, std::string_view message) -> void
+    {
+        if (buffers_[currentBuffer_].size + message.size() > bufferCapacity_)
+        {
+            submitBuffer();
+
+            // too large for a buffer at all, so it bypasses them
+            if (message.size() > bufferCapacity_)
+            {
+                writeSynchronously(message.data(), message.size(), fileOffset_);
+                fileOffset_ += message.size();
+                return;
+            }
+        }
+
+        Buffer& buffer           = buffers_[currentBuffer_];
+        const bool checkInterval = flushPolicy_.interval.count() > 0;
+        if (buffer.size == 0 && checkInterval)
+        {
+            oldestBufferedAt_ = std::chrono::steady_clock::now();
+
+            // a deadline still scheduled is earlier, the timer moves it on if the buffer is not due yet
+            if (!flushScheduled_)
+            {
+                flushScheduled_ = true;
+                FileFlushTimer::getInstance().schedule(this, oldestBufferedAt_ + flushPolicy_.interval);
+            }
+        }
+
+        std::memcpy(buffer.data.get() + buffer.size, message.data(), message.size());
+        buffer.size += message.size();
+
+        if (messageSeverity >= flushPolicy_.severity ||
+            (checkInterval && std::chrono::steady_clock::now() - oldestBufferedAt_ >= flushPolicy_.interval))
+        {
+            submitBuffer();
+        }
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::flush() -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        submitBuffer();
+
+        auto isPending = [](const Buffer& buffer) { return buffer.pendingCompletions > 0; };
+        while (std::any_of(buffers_.begin(), buffers_.end(), isPending))
+            waitForCompletions();
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        if (!tryLockUntil(deadline))
+            return;
+
+        Buffer& buffer = buffers_[currentBuffer_];
+        writeSynchronously(buffer.data.get(), buffer.size, fileOffset_);
+        fileOffset_ += buffer.size;
+        buffer.size = 0;
+
+        // the kernel completes the submitted writes on its own, a short one is finished with pwrite
+        auto isPending = [](const Buffer& pending) { return pending.pendingCompletions > 0; };
+        reapCompletions();
+        while (std::any_of(buffers_.begin(), buffers_.end(), isPending) && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+            reapCompletions();
+        }
+        mutex_.unlock();
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::getPath() const -> const std::string&
+    {
+        return path_;
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::isUsingIoUring() const noexcept -> bool
+    {
+        return usingIoUring_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::getWriteErrorCount() const noexcept -> std::size_t
+    {
+        return writeErrorCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::submitBuffer() -> void
+    {
+        Buffer& buffer = buffers_[currentBuffer_];
+        if (buffer.size == 0)
+            return;
+
+        if (ring_ != nullptr)
+        {
+            submitToRing(buffer, currentBuffer_);
+        }
+        else
+        {
+            writeSynchronously(buffer.data.get(), buffer.size, fileOffset_);
+            if (durability_ != FileDurability::None)
+                syncSynchronously();
+        }
+
+        fileOffset_ += buffer.size;
+        currentBuffer_ = nextFreeBuffer();
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::submitToRing(Buffer& buffer, std::uint64_t bufferIndex) -> void
+    {
+#ifdef NEALOG_HAS_IO_URING
+        buffer.offset             = fileOffset_;
+        buffer.pendingCompletions = 1;
+
+        io_uring_sqe* writeEntry = ring_->nextEntry();
+        writeEntry->opcode       = IORING_OP_WRITE;
+        writeEntry->fd           = fileDescriptor_;
+        writeEntry->addr         = reinterpret_cast<std::uintptr_t>(buffer.data.get());
+        writeEntry->len          = static_cast<std::uint32_t>(buffer.size);
+        writeEntry->off          = buffer.offset;
+        writeEntry->user_data    = bufferIndex;
+
+        if (durability_ != FileDurability::None)
+        {
+            // the sync only starts once the write completed
+            writeEntry->flags = IOSQE_IO_LINK;
+
+            io_uring_sqe* syncEntry = ring_->nextEntry();
+            syncEntry->opcode       = IORING_OP_FSYNC;
+            syncEntry->fd           = fileDescriptor_;
+            syncEntry->fsync_flags  = durability_ == FileDurability::Fdatasync ? IORING_FSYNC_DATASYNC : 0;
+            syncEntry->user_data    = bufferIndex | SYNC_COMPLETION_FLAG;
+            buffer.pendingCompletions++;
+        }
+
+        if (ring_->enter(0) < 0)
+            writeErrorCount_.fetch_add(1, std::memory_order_relaxed);
+#else
+        static_cast<void>(buffer);
+        static_cast<void>(bufferIndex);
+#endif
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::reapCompletions() -> void
+    {
+#ifdef NEALOG_HAS_IO_URING
+        if (ring_ == nullptr)
+            return;
+
+        unsigned head       = *ring_->completionHead;
+        const unsigned tail = __atomic_load_n(ring_->completionTail, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; head++)
+        {
+            const io_uring_cqe& completion = ring_->completions[head & ring_->completionMask];
+            const bool isSync              = (completion.user_data & SYNC_COMPLETION_FLAG) != 0;
+            Buffer& buffer                 = buffers_[completion.user_data & ~SYNC_COMPLETION_FLAG];
+
+            if (completion.res < 0)
+            {
+                // a sync cancelled because its write failed was counted already
+                if (completion.res != -ECANCELED)
+                    writeErrorCount_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (!isSync && static_cast<std::size_t>(completion.res) < buffer.size)
+            {
+                const auto written = static_cast<std::size_t>(completion.res);
+                writeSynchronously(buffer.data.get() + written, buffer.size - written, buffer.offset + written);
+            }
+
+            buffer.pendingCompletions--;
+        }
+
+        __atomic_store_n(ring_->completionHead, head, __ATOMIC_RELEASE);
+#endif
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::waitForCompletions() -> void
+    {
+#ifdef NEALOG_HAS_IO_URING
+        if (ring_->enter(1) >= 0)
+        {
+            enterFailures_ = 0;
+            reapCompletions();
+            return;
+        }
+
+        writeErrorCount_.fetch_add(1, std::memory_order_relaxed);
+        // completions may have arrived anyway, e.g. if only the submission failed
+        reapCompletions();
+        if (++enterFailures_ >= MAX_ENTER_FAILURES)
+            abandonRing();
+#endif
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::abandonRing() -> void
+    {
+#ifdef NEALOG_HAS_IO_URING
+        // the kernel takes entries only while it is entered, so the ones
+        // behind its head stay untouched and are done here in their order
+        const unsigned head = __atomic_load_n(ring_->submissionHead, __ATOMIC_ACQUIRE);
+        for (unsigned i = head; i != ring_->localTail; i++)
+        {
+            const io_uring_sqe& entry = ring_->entries[ring_->submissionArray[i & ring_->submissionMask]];
+            Buffer& buffer            = buffers_[entry.user_data & ~SYNC_COMPLETION_FLAG];
+
+            if ((entry.user_data & SYNC_COMPLETION_FLAG) != 0)
+                syncSynchronously();
+            else
+                writeSynchronously(buffer.data.get(), buffer.size, buffer.offset);
+            buffer.pendingCompletions--;
+        }
+        ring_->localTail   = head;
+        ring_->unsubmitted = 0;
+        __atomic_store_n(ring_->submissionTail, head, __ATOMIC_RELEASE);
+
+        // the entries the kernel took complete without entering it again
+        auto isPending = [](const Buffer& buffer) { return buffer.pendingCompletions > 0; };
+        reapCompletions();
+        while (std::any_of(buffers_.begin(), buffers_.end(), isPending))
+        {
+            std::this_thread::yield();
+            reapCompletions();
+        }
+
+        ring_.reset();
+        usingIoUring_.store(false, std::memory_order_relaxed);
+#endif
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::nextFreeBuffer() -> std::size_t
+    {
+        reapCompletions();
+
+        while (true)
+        {
+            for (std::size_t i = 1; i <= buffers_.size(); i++)
+            {
+                const std::size_t index = (currentBuffer_ + i) % buffers_.size();
+                if (buffers_[index].pendingCompletions == 0)
+                {
+                    buffers_[index].size = 0;
+                    return index;
+                }
+            }
+
+            // every buffer is in flight, so the disk is the bottleneck now
+            waitForCompletions();
+        }
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::flushIfDue() -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        flushScheduled_ = false;
+        if (buffers_[currentBuffer_].size == 0)
+            return;
+
+        const auto deadline = oldestBufferedAt_ + flushPolicy_.interval;
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            submitBuffer();
+            return;
+        }
+
+        flushScheduled_ = true;
+        FileFlushTimer::getInstance().schedule(this, deadline);
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::writeSynchronously(const char* data, std::size_t size, std::uint64_t offset)
+        -> void
+    {
+        while (size > 0)
+        {
+            auto written = ::pwrite(fileDescriptor_, data, size, static_cast<off_t>(offset));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                writeErrorCount_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            data += written;
+            offset += static_cast<std::uint64_t>(written);
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+
+
+
+    NL_INLINE auto IoUringFileSink::syncSynchronously() -> void
+    {
+        const int result =
+            durability_ == FileDurability::Fdatasync ? ::fdatasync(fileDescriptor_) : ::fsync(fileDescriptor_);
+        if (result < 0)
+            writeErrorCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // }}}
+
+} // namespace nealog
+
+#endif // __linux__
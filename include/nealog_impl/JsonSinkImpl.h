@@ -0,0 +1,517 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/JsonSink.h"
+#endif // !NEALOG_HEADERONLY
+
+#include "nealog/Clock.h"
+
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <variant>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NEALOG_JSON_SSE2
+#endif
+
+// GCC and Clang compile the AVX2 kernel for its function only and pick it at runtime
+#if defined(NEALOG_JSON_SSE2) && (defined(__GNUC__) || defined(__AVX2__))
+#include <immintrin.h>
+#define NEALOG_JSON_AVX2
+#if defined(__AVX2__)
+#define NEALOG_JSON_AVX2_TARGET
+#else
+#define NEALOG_JSON_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(_MSC_VER) && defined(NEALOG_JSON_SSE2)
+#include <intrin.h>
+#endif
+
+
+namespace nealog
+{
+
+    constexpr const char* JSON_HEX_DIGITS = "0123456789abcdef";
+
+
+
+    NL_INLINE auto appendJsonText(fmt::memory_buffer& out, std::string_view text) -> void
+    {
+        out.append(text.data(), text.data() + text.size());
+    }
+
+
+
+    NL_INLINE auto needsJsonEscape(char character) noexcept -> bool
+    {
+        return character == '"' || character == '\\' || static_cast<unsigned char>(character) < 0x20;
+    }
+
+
+
+    NL_INLINE auto appendJsonEscapedByte(fmt::memory_buffer& out, char character) -> void
+    {
+        const auto byte  = static_cast<unsigned char>(character);
+        char escaped[6]  = {'\\', 'u', '0', '0', JSON_HEX_DIGITS[byte >> 4], JSON_HEX_DIGITS[byte & 0xF]};
+        std::size_t size = 2;
+
+        switch (character)
+        {
+        case '"':
+        case '\\':
+            escaped[1] = character;
+            break;
+        case '\b':
+            escaped[1] = 'b';
+            break;
+        case '\f':
+            escaped[1] = 'f';
+            break;
+        case '\n':
+            escaped[1] = 'n';
+            break;
+        case '\r':
+            escaped[1] = 'r';
+            break;
+        case '\t':
+            escaped[1] = 't';
+            break;
+        default:
+            size = sizeof(escaped);
+            break;
+        }
+
+        out.append(escaped, escaped + size);
+    }
+
+
+
+    /*!
+     * Escapes from position to end, the bytes from run to position are known not to need it.
+     */
+    NL_INLINE auto escapeJsonTail(fmt::memory_buffer& out, const char* run, const char* position, const char* end)
+        -> void
+    {
+        for (; position < end; position++)
+        {
+            if (!needsJsonEscape(*position))
+                continue;
+
+            out.append(run, position);
+            appendJsonEscapedByte(out, *position);
+            run = position + 1;
+        }
+        out.append(run, end);
+    }
+
+
+
+#ifdef NEALOG_JSON_SSE2
+    NL_INLINE auto countTrailingZeros(std::uint32_t mask) noexcept -> unsigned
+    {
+#ifdef _MSC_VER
+        unsigned long index = 0;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+
+
+    /*!
+     * Escapes the bytes of a block whose bits are set in mask, mask must
+     * not be empty. Moves run behind the last escaped byte.
+     */
+    NL_INLINE auto escapeJsonBlock(fmt::memory_buffer& out, const char*& run, const char* block, std::uint32_t mask)
+        -> void
+    {
+        do
+        {
+            const char* found = block + countTrailingZeros(mask);
+            out.append(run, found);
+            appendJsonEscapedByte(out, *found);
+            run = found + 1;
+            mask &= mask - 1;
+        } while (mask != 0);
+    }
+
+
+
+    NL_INLINE auto escapeJsonSse2(fmt::memory_buffer& out, const char* begin, const char* end) -> void
+    {
+        const __m128i quote       = _mm_set1_epi8('"');
+        const __m128i backslash   = _mm_set1_epi8('\\');
+        const __m128i lastControl = _mm_set1_epi8(0x1F);
+
+        const char* run      = begin;
+        const char* position = begin;
+        for (; end - position >= 16; position += 16)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+            // the unsigned minimum with 0x1F leaves exactly the control characters unchanged
+            const __m128i special =
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                             _mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk));
+
+            const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(special));
+            if (mask != 0)
+                escapeJsonBlock(out, run, position, mask);
+        }
+
+        escapeJsonTail(out, run, position, end);
+    }
+#endif // NEALOG_JSON_SSE2
+
+
+
+#ifdef NEALOG_JSON_AVX2
+    NEALOG_JSON_AVX2_TARGET NL_INLINE auto escapeJsonAvx2(fmt::memory_buffer& out, const char* begin, const char* end)
+        -> void
+    {
+        const __m256i quote       = _mm256_set1_epi8('"');
+        const __m256i backslash   = _mm256_set1_epi8('\\');
+        const __m256i lastControl = _mm256_set1_epi8(0x1F);
+
+        const char* run      = begin;
+        const char* position = begin;
+        for (; end - position >= 32; position += 32)
+        {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position));
+            const __m256i special =
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                                _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, lastControl), chunk));
+
+            const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(special));
+            if (mask != 0)
+                escapeJsonBlock(out, run, position, mask);
+        }
+
+        escapeJsonTail(out, run, position, end);
+    }
+#endif // NEALOG_JSON_AVX2
+
+
+
+    NL_INLINE auto isJsonEscapeKernelSupported(JsonEscapeKernel kernel) -> bool
+    {
+        switch (kernel)
+        {
+        case JsonEscapeKernel::Scalar:
+            return true;
+        case JsonEscapeKernel::Sse2:
+#ifdef NEALOG_JSON_SSE2
+            return true;
+#else
+            return false;
+#endif
+        case JsonEscapeKernel::Avx2:
+#if defined(NEALOG_JSON_AVX2) && defined(__AVX2__)
+            return true;
+#elif defined(NEALOG_JSON_AVX2)
+            return __builtin_cpu_supports("avx2") != 0;
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+
+
+    NL_INLINE auto getJsonEscapeKernel() -> JsonEscapeKernel
+    {
+        static const JsonEscapeKernel kernel = []() {
+            for (JsonEscapeKernel candidate : {JsonEscapeKernel::Avx2, JsonEscapeKernel::Sse2})
+            {
+                if (isJsonEscapeKernelSupported(candidate))
+                    return candidate;
+            }
+            return JsonEscapeKernel::Scalar;
+        }();
+        return kernel;
+    }
+
+
+
+    NL_INLINE auto appendJsonEscaped(fmt::memory_buffer& out, std::string_view text) -> void
+    {
+        appendJsonEscaped(out, text, getJsonEscapeKernel());
+    }
+
+
+
+    NL_INLINE auto appendJsonEscaped(fmt::memory_buffer& out, std::string_view text, JsonEscapeKernel kernel) -> void
+    {
+        const char* begin = text.data();
+        const char* end   = begin + text.size();
+
+        switch (kernel)
+        {
+#ifdef NEALOG_JSON_AVX2
+        case JsonEscapeKernel::Avx2:
+            escapeJsonAvx2(out, begin, end);
+            return;
+#endif
+#ifdef NEALOG_JSON_SSE2
+        case JsonEscapeKernel::Sse2:
+            escapeJsonSse2(out, begin, end);
+            return;
+#endif
+        default:
+            escapeJsonTail(out, begin, begin, end);
+            return;
+        }
+    }
+
+
+
+    NL_INLINE auto appendJsonString(fmt::memory_buffer& out, std::string_view text) -> void
+    {
+        out.push_back('"');
+        appendJsonEscaped(out, text);
+        out.push_back('"');
+    }
+
+
+
+    NL_INLINE auto appendJsonValue(fmt::memory_buffer& out, const ArgumentValue& value) -> void
+    {
+        std::visit(
+            [&out](auto argument) {
+                using T = decltype(argument);
+
+                if constexpr (std::is_same_v<T, bool>)
+                {
+                    appendJsonText(out, argument ? "true" : "false");
+                }
+                else if constexpr (std::is_same_v<T, char>)
+                {
+                    appendJsonString(out, {&argument, 1});
+                }
+                else if constexpr (std::is_integral_v<T>)
+                {
+                    const fmt::format_int digits{argument};
+                    out.append(digits.data(), digits.data() + digits.size());
+                }
+                else if constexpr (std::is_floating_point_v<T>)
+                {
+                    // JSON has no NaN and no infinity. fmt writes numbers without the locale.
+                    if (std::isfinite(argument))
+                        fmt::format_to(std::back_inserter(out), "{}", argument);
+                    else
+                        appendJsonText(out, "null");
+                }
+                else if constexpr (std::is_same_v<T, const void*>)
+                {
+                    fmt::format_to(std::back_inserter(out), "\"{}\"", argument);
+                }
+                else
+                {
+                    appendJsonString(out, argument);
+                }
+            },
+            value);
+    }
+
+
+
+    /*!
+     * Year, month and day of the days since 1970-01-01 in the proleptic Gregorian calendar.
+     */
+    NL_INLINE auto civilFromDays(std::int64_t days, std::int64_t& year, unsigned& month, unsigned& day) noexcept
+        -> void
+    {
+        days += 719468;
+        const std::int64_t era   = (days >= 0 ? days : days - 146096) / 146097;
+        const auto dayOfEra      = static_cast<unsigned>(days - era * 146097);
+        const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const unsigned shifted   = (5 * dayOfYear + 2) / 153;
+
+        day   = dayOfYear - (153 * shifted + 2) / 5 + 1;
+        month = shifted < 10 ? shifted + 3 : shifted - 9;
+        year  = static_cast<std::int64_t>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0);
+    }
+
+
+
+    NL_INLINE auto appendIsoTimestamp(fmt::memory_buffer& out, std::chrono::system_clock::time_point timestamp)
+        -> void
+    {
+        struct CachedSecond
+        {
+            std::int64_t second = std::numeric_limits<std::int64_t>::min();
+            char prefix[32]{};
+            std::size_t prefixSize = 0;
+        };
+        thread_local CachedSecond cached;
+
+        const std::int64_t microseconds =
+            std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count();
+        const std::int64_t second = (microseconds >= 0 ? microseconds : microseconds - 999999) / 1000000;
+        std::int64_t fraction     = microseconds - second * 1000000;
+
+        // the date and the time of day only change once per second
+        if (second != cached.second)
+        {
+            const std::int64_t days = (second >= 0 ? second : second - 86399) / 86400;
+            const std::int64_t time = second - days * 86400;
+
+            std::int64_t year = 0;
+            unsigned month = 0, day = 0;
+            civilFromDays(days, year, month, day);
+
+            cached.prefixSize = fmt::format_to_n(cached.prefix, sizeof(cached.prefix),
+                                                 "{:04}-{:02}-{:02}T{:02}:{:02}:{:02}.", year, month, day, time / 3600,
+                                                 time / 60 % 60, time % 60)
+                                    .size;
+            cached.second = second;
+        }
+
+        char digits[7];
+        for (std::size_t i = 6; i-- > 0; fraction /= 10)
+            digits[i] = static_cast<char>('0' + fraction % 10);
+        digits[6] = 'Z';
+
+        out.append(cached.prefix, cached.prefix + cached.prefixSize);
+        out.append(digits, digits + sizeof(digits));
+    }
+
+
+
+    /******************************
+     * JsonSink
+     ******************************/
+    // {{{
+
+    /*!
+     * Appends the members every object starts with, without the closing brace.
+     */
+    NL_INLINE auto appendJsonHead(fmt::memory_buffer& out, std::chrono::system_clock::time_point timestamp,
+                                  Severity severity) -> void
+    {
+        appendJsonText(out, "{\"time\":\"");
+        appendIsoTimestamp(out, timestamp);
+        appendJsonText(out, "\",\"severity\":\"");
+        appendJsonText(out, severityName(severity));
+        out.push_back('"');
+    }
+
+
+
+    NL_INLINE auto getThreadJsonBuffers() -> std::pair<fmt::memory_buffer, fmt::memory_buffer>&
+    {
+        // the line and the message formatted into it
+        thread_local std::pair<fmt::memory_buffer, fmt::memory_buffer> buffers;
+        return buffers;
+    }
+
+
+
+    NL_INLINE JsonSink::JsonSink(Sink::SPtr target) : target_(std::move(target))
+    {
+        takesRecords_ = true;
+    }
+
+
+
+    NL_INLINE auto JsonSink::getType() -> SinkType
+    {
+        return SinkType::Json;
+    }
+
+
+
+    NL_INLINE auto JsonSink::write(Severity messageSeverity, std::string_view message) -> void
+    {
+        if (messageSeverity < severity_.load(std::memory_order_relaxed))
+            return;
+
+        fmt::memory_buffer& line = getThreadJsonBuffers().first;
+        line.clear();
+
+        appendJsonHead(line, captureTimestamp(), messageSeverity);
+        appendJsonText(line, ",\"message\":");
+        appendJsonString(line, message);
+        appendJsonText(line, "}\n");
+
+        target_->write(messageSeverity, {line.data(), line.size()});
+    }
+
+
+
+    NL_INLINE auto JsonSink::writeRecord(const Record& record, std::string_view loggerName) -> void
+    {
+        if (record.getSeverity() < severity_.load(std::memory_order_relaxed))
+            return;
+
+        auto& [line, message] = getThreadJsonBuffers();
+        line.clear();
+        message.clear();
+
+        const ThreadIdentity& thread = record.getThread();
+
+        appendJsonHead(line, record.getTimestamp(), record.getSeverity());
+        appendJsonText(line, ",\"logger\":");
+        appendJsonString(line, loggerName);
+        fmt::format_to(std::back_inserter(line), ",\"thread\":{}", thread.id);
+        if (!thread.name.empty())
+        {
+            appendJsonText(line, ",\"thread_name\":");
+            appendJsonString(line, thread.name);
+        }
+
+        record.formatMessageWithoutFields(message);
+        appendJsonText(line, ",\"message\":");
+        appendJsonString(line, {message.data(), message.size()});
+
+        if (const SourceLocation* location = record.getLocation())
+        {
+            appendJsonText(line, ",\"file\":");
+            appendJsonString(line, location->file);
+            fmt::format_to(std::back_inserter(line), ",\"line\":{}", location->line);
+            appendJsonText(line, ",\"function\":");
+            appendJsonString(line, location->function);
+        }
+
+        forEachField(record.getFields(), [&line](std::string_view key, const ArgumentValue& value) {
+            line.push_back(',');
+            appendJsonString(line, key);
+            line.push_back(':');
+            appendJsonValue(line, value);
+        });
+        appendJsonText(line, "}\n");
+
+        target_->writeFromLogger(loggerName, record.getSeverity(), {line.data(), line.size()});
+    }
+
+
+
+    NL_INLINE auto JsonSink::flush() -> void
+    {
+        target_->flush();
+    }
+
+
+
+    NL_INLINE auto JsonSink::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        target_->flushOnCrash(deadline);
+    }
+
+
+
+    NL_INLINE auto JsonSink::getTarget() const -> const Sink::SPtr&
+    {
+        return target_;
+    }
+    // }}}
+
+} // namespace nealog
@@ -4,9 +4,11 @@
 #include "nealog/Logger.h"
 #endif // !NEALOG_HEADERONLY
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdlib>
+#include <iterator>
 #include <memory>
 #include <type_traits>
 
@@ -26,32 +28,161 @@ namespace nealog
     }
 
 
-    NL_INLINE auto Logger::getSinks() -> const std::vector<Sink::SPtr>
+    NL_INLINE auto Logger::getSinks() -> const SinkList&
     {
-        return sinks_;
+        static const SinkList noSinks{};
+
+        const SinkList* sinks = sinks_.load(std::memory_order_acquire);
+        return sinks != nullptr ? *sinks : noSinks;
     }
 
 
 
     NL_INLINE auto Logger::addSink(const Sink::SPtr& sink) -> void
     {
-        sinks_.emplace_back(sink);
+        std::lock_guard<std::mutex> lock{sinksMutex_};
+
+        auto sinks = std::make_unique<SinkList>(getSinks());
+        sinks->emplace_back(sink);
+        publishSinks(std::move(sinks));
+    }
+
+
+
+    NL_INLINE auto Logger::removeSink(const Sink::SPtr& sink) -> bool
+    {
+        std::lock_guard<std::mutex> lock{sinksMutex_};
+
+        const SinkList& currentSinks = getSinks();
+        auto position                = std::find(currentSinks.begin(), currentSinks.end(), sink);
+        if (position == currentSinks.end())
+            return false;
+
+        auto sinks = std::make_unique<SinkList>(currentSinks.begin(), position);
+        sinks->insert(sinks->end(), std::next(position), currentSinks.end());
+        publishSinks(std::move(sinks));
+        return true;
+    }
+
+
+
+    NL_INLINE auto Logger::publishSinks(std::unique_ptr<const SinkList> sinks) -> void
+    {
+        std::shared_ptr<const SinkList> replaced = std::move(sinksSnapshot_);
+        sinksSnapshot_                           = std::move(sinks);
+        sinks_.store(sinksSnapshot_.get(), std::memory_order_release);
+        invalidateCaches();
+
+        // child loggers drop their cached pointer to it on their next refresh
+        if (replaced != nullptr)
+            EpochReclaimer::getInstance().retire(std::move(replaced));
+    }
+
+
+
+    NL_INLINE auto Logger::setSeverity(Severity severity) -> void
+    {
+        WithSeverity::setSeverity(severity);
+        invalidateCaches();
     }
 
 
 
-    NL_INLINE auto Logger::log(Severity messageSeverity, const std::string_view& message) -> void
+    NL_INLINE auto Logger::log(Severity messageSeverity, const std::string_view& message,
+                               const SourceLocation* location) -> void
     {
-        if (sinks_.empty())
+        if (!isEnabled(messageSeverity) || recordMessage(messageSeverity, message, location))
+            return;
+
+        if (effectiveTakesRecords_.load(std::memory_order_relaxed))
         {
-            parent_->log(messageSeverity, message);
+            Record record;
+            record.captureMessage(messageSeverity, message);
+            record.setLocation(location);
+            logRecord(record);
+        }
+        else
+        {
+            const PatternFormatter* formatter = effectiveFormatter_.load(std::memory_order_acquire);
+            const PatternContext context{{}, messageSeverity, name_, nullptr, location};
+            renderAndWriteToSinks(messageSeverity,
+                                  [&](fmt::memory_buffer& buffer) { formatter->render(buffer, message, context); });
+        }
+
+        if (messageSeverity == Severity::Fatal)
+            flush();
+    }
+
+
+
+    NL_INLINE auto Logger::vlog(Severity messageSeverity, fmt::string_view format, fmt::format_args args,
+                                const SourceLocation* location) -> void
+    {
+        refreshCacheIfOutdated();
+
+        if (effectiveTakesRecords_.load(std::memory_order_relaxed))
+        {
+            fmt::memory_buffer& message = getThreadMessageBuffer();
+            message.clear();
+            fmt::vformat_to(std::back_inserter(message), format, args);
+
+            Record record;
+            record.captureMessage(messageSeverity, {message.data(), message.size()});
+            record.setLocation(location);
+            logRecord(record);
+            return;
+        }
+
+        const PatternFormatter* formatter = effectiveFormatter_.load(std::memory_order_acquire);
+        const PatternContext context{{}, messageSeverity, name_, nullptr, location};
+        renderAndWriteToSinks(messageSeverity, [&](fmt::memory_buffer& buffer) {
+            formatter->vformatTo(buffer, format, args, context);
+        });
+    }
+
+
+
+    NL_INLINE auto Logger::logRecord(Record& record) -> void
+    {
+        refreshCacheIfOutdated();
+
+        if (effectiveTakesRecords_.load(std::memory_order_relaxed) && !writeRecordToSinks(record))
             return;
+
+        fmt::memory_buffer& message = getThreadMessageBuffer();
+        message.clear();
+        record.formatMessage(message);
+
+        const PatternFormatter* formatter = effectiveFormatter_.load(std::memory_order_acquire);
+        renderAndWriteToSinks(record.getSeverity(), [&](fmt::memory_buffer& buffer) {
+            formatter->render(buffer, {message.data(), message.size()}, getPatternContext(record));
+        });
+    }
+
+
+
+    NL_INLINE auto Logger::flush() -> void
+    {
+        const EpochReclaimer::ReadGuard guard;
+        refreshCacheIfOutdated();
+
+        if (const SinkList* sinks = effectiveSinks_.load(std::memory_order_acquire))
+        {
+            for (const Sink::SPtr& sink : *sinks)
+                sink->flush();
         }
+    }
 
-        if (messageSeverity >= severity_)
+
+
+    NL_INLINE auto Logger::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        // no refresh of the cache, it takes a lock, and no guard, which may
+        // allocate, since the current snapshot is only freed after a change
+        if (const SinkList* sinks = sinks_.load(std::memory_order_acquire))
         {
-            std::string formattedMessage = formatter_.format(message);
-            writeToSinks(messageSeverity, formattedMessage);
+            for (const Sink::SPtr& sink : *sinks)
+                sink->flushOnCrash(deadline);
         }
     }
 
@@ -59,14 +190,109 @@ namespace nealog
 
     NL_INLINE auto Logger::writeToSinks(Severity severity, const std::string_view& message) -> void
     {
-        for (Sink::SPtr& sink : sinks_)
+        const EpochReclaimer::ReadGuard guard;
+        refreshCacheIfOutdated();
+
+        const SinkList* sinks = effectiveSinks_.load(std::memory_order_acquire);
+        if (sinks == nullptr)
+            return;
+
+        for (const Sink::SPtr& sink : *sinks)
         {
-            sink->write(severity, message);
+            if (!sink->takesRecords())
+                sink->writeFromLogger(name_, severity, message);
         }
     }
 
 
 
+    NL_INLINE auto Logger::writeBatchToSinks(const SinkRecord* records, std::size_t count) -> void
+    {
+        const EpochReclaimer::ReadGuard guard;
+        refreshCacheIfOutdated();
+
+        const SinkList* sinks = effectiveSinks_.load(std::memory_order_acquire);
+        if (sinks == nullptr)
+            return;
+
+        for (const Sink::SPtr& sink : *sinks)
+        {
+            if (!sink->takesRecords())
+                sink->writeBatch(records, count);
+        }
+    }
+
+
+
+    NL_INLINE auto Logger::writeRecordToSinks(const Record& record) -> bool
+    {
+        const EpochReclaimer::ReadGuard guard;
+        refreshCacheIfOutdated();
+
+        const SinkList* sinks = effectiveSinks_.load(std::memory_order_acquire);
+        if (sinks == nullptr)
+            return false;
+
+        bool needsMessage = false;
+        for (const Sink::SPtr& sink : *sinks)
+        {
+            if (sink->takesRecords())
+                sink->writeRecord(record, name_);
+            else
+                needsMessage = true;
+        }
+
+        return needsMessage;
+    }
+
+
+
+    NL_INLINE auto Logger::getPatternContext(const Record& record) const noexcept -> PatternContext
+    {
+        return {record.getTimestamp(), record.getSeverity(), name_, &record.getThread(), record.getLocation()};
+    }
+
+
+
+    NL_INLINE auto Logger::refreshCache(std::uint64_t generation) -> void
+    {
+        std::lock_guard<std::mutex> lock{cacheMutex_};
+        const EpochReclaimer::ReadGuard guard;
+
+        if (cachedGeneration_.load(std::memory_order_acquire) == generation)
+            return;
+
+        int threshold                     = DISABLED_THRESHOLD;
+        const SinkList* sinks             = nullptr;
+        const PatternFormatter* formatter = &formatter_;
+
+        const SinkList* ownSinks = sinks_.load(std::memory_order_acquire);
+        if (ownSinks != nullptr && !ownSinks->empty())
+        {
+            threshold = static_cast<int>(severity_.load(std::memory_order_relaxed));
+            sinks     = ownSinks;
+        }
+        else if (parent_ != nullptr)
+        {
+            parent_->refreshCacheIfOutdated();
+            threshold = parent_->effectiveThreshold_.load(std::memory_order_relaxed);
+            sinks     = parent_->effectiveSinks_.load(std::memory_order_acquire);
+            formatter = parent_->effectiveFormatter_.load(std::memory_order_acquire);
+        }
+
+        effectiveThreshold_.store(threshold, std::memory_order_relaxed);
+        effectiveSinks_.store(sinks, std::memory_order_release);
+        effectiveFormatter_.store(formatter, std::memory_order_release);
+
+        const bool takesRecords =
+            sinks != nullptr &&
+            std::any_of(sinks->begin(), sinks->end(), [](const Sink::SPtr& sink) { return sink->takesRecords(); });
+        effectiveTakesRecords_.store(takesRecords, std::memory_order_relaxed);
+        cachedGeneration_.store(generation, std::memory_order_release);
+    }
+
+
+
     NL_INLINE auto Logger::setFormatter(const PatternFormatter& formatter) -> void
     {
         formatter_ = formatter;
@@ -126,6 +352,75 @@ namespace nealog
     NL_INLINE auto Logger::setParent(LoggerBase::SPtr parent) -> void
     {
         parent_ = parent;
+        invalidateCaches();
+    }
+    // }}}
+
+
+
+    /******************************
+     * LoggerBase
+     ******************************/
+    // {{{
+
+    NL_INLINE auto LoggerBase::setFlightRecorder(const FlightRecorderPolicy& policy) -> void
+    {
+        std::lock_guard<std::mutex> lock{flightRecordersMutex_};
+
+        std::shared_ptr<FlightRecorder> replaced = std::move(ownedFlightRecorder_);
+        if (policy.capacity == 0)
+        {
+            flightRecorderThreshold_.store(DISABLED_THRESHOLD, std::memory_order_relaxed);
+            flightRecorderTrigger_.store(DISABLED_THRESHOLD, std::memory_order_relaxed);
+            flightRecorder_.store(nullptr, std::memory_order_release);
+        }
+        else
+        {
+            ownedFlightRecorder_ = std::make_unique<FlightRecorder>(policy);
+            flightRecorder_.store(ownedFlightRecorder_.get(), std::memory_order_release);
+            flightRecorderThreshold_.store(static_cast<int>(policy.keepFrom), std::memory_order_relaxed);
+            flightRecorderTrigger_.store(static_cast<int>(policy.trigger), std::memory_order_relaxed);
+        }
+
+        if (replaced != nullptr)
+            EpochReclaimer::getInstance().retire(std::move(replaced));
+    }
+
+
+
+    NL_INLINE auto LoggerBase::writeFlightRecorder() -> void
+    {
+        // a sink logging an error from inside logRecord() must not reuse the records
+        std::vector<Record> records;
+        {
+            const EpochReclaimer::ReadGuard guard;
+            FlightRecorder* recorder = flightRecorder_.load(std::memory_order_acquire);
+            if (recorder == nullptr)
+                return;
+
+            recorder->takeAll(records);
+        }
+
+        for (Record& record : records)
+            logRecord(record);
+    }
+
+
+
+    NL_INLINE auto LoggerBase::recordMessage(Severity messageSeverity, const std::string_view& message,
+                                             const SourceLocation* location) -> bool
+    {
+        if (!isOnlyRecorded(messageSeverity))
+        {
+            writeFlightRecorderIfTriggered(messageSeverity);
+            return false;
+        }
+
+        Record record;
+        record.captureMessage(messageSeverity, message);
+        record.setLocation(location);
+        keepInFlightRecorder(record);
+        return true;
     }
     // }}}
 
@@ -138,6 +433,15 @@ namespace nealog
 
 
 
+    NL_INLINE auto ParentHolder::setGenerationForLogger(std::shared_ptr<GenerationCounter> generation,
+                                                        LoggerBase::SPtr logger) -> void
+    {
+        logger->generation_ = std::move(generation);
+        logger->invalidateCaches();
+    }
+
+
+
     /******************************
      * Exceptions
      ******************************/
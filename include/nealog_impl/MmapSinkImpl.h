@@ -0,0 +1,239 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/MmapSink.h"
+#endif // !NEALOG_HEADERONLY
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+
+namespace nealog
+{
+
+    /******************************
+     * MmapSink
+     ******************************/
+    // {{{
+
+    NL_INLINE MmapSink::MmapSink(const std::string& path, std::size_t segmentSize, MmapSyncPolicy syncPolicy)
+        : path_(path), segmentSize_(segmentSize), syncPolicy_(syncPolicy),
+          pageSize_(static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))), lastSegment_(findLastSegment(path))
+    {
+        current_.store(openSegment(), std::memory_order_release);
+    }
+
+
+
+    NL_INLINE MmapSink::~MmapSink()
+    {
+        if (Segment* segment = current_.load(std::memory_order_acquire))
+            closeSegment(*segment, segment->committed.load(std::memory_order_acquire));
+    }
+
+
+
+    NL_INLINE auto MmapSink::getType() -> SinkType
+    {
+        return SinkType::Mmap;
+    }
+
+
+
+    NL_INLINE auto MmapSink::write(Severity messageSeverity, std::string_view message) -> void
+    {
+        if (messageSeverity < severity_.load(std::memory_order_relaxed) || message.empty())
+            return;
+
+        if (message.size() > segmentSize_)
+        {
+            droppedCount_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        while (true)
+        {
+            Segment* segment = current_.load(std::memory_order_acquire);
+            if (segment == nullptr)
+            {
+                if (reopenSegment())
+                    continue;
+
+                droppedCount_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            const std::size_t offset = segment->reserved.fetch_add(message.size(), std::memory_order_relaxed);
+            const std::size_t end    = offset + message.size();
+
+            if (end <= segment->capacity)
+            {
+                std::memcpy(segment->data + offset, message.data(), message.size());
+
+                // synced before the commit, the segment cannot be unmapped yet
+                if (syncPolicy_.interval > 0 && offset / syncPolicy_.interval != end / syncPolicy_.interval)
+                    sync(*segment, offset - offset % syncPolicy_.interval, end, syncPolicy_.mode);
+
+                segment->committed.fetch_add(message.size(), std::memory_order_release);
+                return;
+            }
+
+            // exactly one writer crosses the end of the segment, it rolls over
+            // while every writer behind it waits for the next segment
+            if (offset <= segment->capacity)
+                roll(*segment, offset);
+
+            while (current_.load(std::memory_order_acquire) == segment)
+                std::this_thread::yield();
+        }
+    }
+
+
+
+    NL_INLINE auto MmapSink::flush() -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (const Segment* segment = current_.load(std::memory_order_acquire))
+            sync(*segment, 0, segment->committed.load(std::memory_order_acquire), syncPolicy_.mode);
+    }
+
+
+
+    NL_INLINE auto MmapSink::getPath() const -> const std::string&
+    {
+        return path_;
+    }
+
+
+
+    NL_INLINE auto MmapSink::getSegmentPath(std::uint64_t segment) const -> std::string
+    {
+        return path_ + "." + std::to_string(segment);
+    }
+
+
+
+    NL_INLINE auto MmapSink::getCurrentSegment() const -> std::uint64_t
+    {
+        const Segment* segment = current_.load(std::memory_order_acquire);
+        return segment != nullptr ? segment->number : 0;
+    }
+
+
+
+    NL_INLINE auto MmapSink::getDroppedCount() const noexcept -> std::size_t
+    {
+        return droppedCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto MmapSink::openSegment() -> Segment*
+    {
+        auto segment      = std::make_unique<Segment>();
+        segment->number   = lastSegment_ + 1;
+        segment->capacity = segmentSize_;
+
+        const std::string segmentPath = getSegmentPath(segment->number);
+        segment->fileDescriptor = ::open(segmentPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (segment->fileDescriptor < 0)
+            throw FileSinkException(segmentPath, errno);
+
+        // reserve the blocks up front so writers never fault on a full disk
+        int error = ::posix_fallocate(segment->fileDescriptor, 0, static_cast<off_t>(segmentSize_));
+        void* data = error == 0 ? ::mmap(nullptr, segmentSize_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                         segment->fileDescriptor, 0)
+                                : MAP_FAILED;
+        if (data == MAP_FAILED)
+        {
+            error = error != 0 ? error : errno;
+            ::close(segment->fileDescriptor);
+            ::unlink(segmentPath.c_str());
+            throw FileSinkException(segmentPath, error);
+        }
+
+        segment->data = static_cast<char*>(data);
+        lastSegment_  = segment->number;
+        segments_.push_back(std::move(segment));
+        return segments_.back().get();
+    }
+
+
+
+    NL_INLINE auto MmapSink::reopenSegment() -> bool
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (current_.load(std::memory_order_acquire) != nullptr)
+            return true;
+
+        try
+        {
+            current_.store(openSegment(), std::memory_order_release);
+            return true;
+        }
+        catch (const FileSinkException&)
+        {
+            return false;
+        }
+    }
+
+
+
+    NL_INLINE auto MmapSink::roll(Segment& full, std::size_t usedSize) -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        Segment* next = nullptr;
+        try
+        {
+            next = openSegment();
+        }
+        catch (const FileSinkException&)
+        {
+            // writers drop their messages and retry to open a segment
+        }
+
+        current_.store(next, std::memory_order_release);
+        closeSegment(full, usedSize);
+    }
+
+
+
+    NL_INLINE auto MmapSink::closeSegment(Segment& segment, std::size_t usedSize) -> void
+    {
+        while (segment.committed.load(std::memory_order_acquire) < usedSize)
+            std::this_thread::yield();
+
+        if (syncPolicy_.onRoll)
+            sync(segment, 0, usedSize, syncPolicy_.mode);
+
+        ::munmap(segment.data, segment.capacity);
+        static_cast<void>(::ftruncate(segment.fileDescriptor, static_cast<off_t>(usedSize)));
+        ::close(segment.fileDescriptor);
+    }
+
+
+
+    NL_INLINE auto MmapSink::sync(const Segment& segment, std::size_t begin, std::size_t end, MsyncMode mode) const
+        -> void
+    {
+        if (end <= begin)
+            return;
+
+        // msync needs a page aligned address
+        const std::size_t alignedBegin = begin - begin % pageSize_;
+        ::msync(segment.data + alignedBegin, end - alignedBegin, mode == MsyncMode::Sync ? MS_SYNC : MS_ASYNC);
+    }
+    // }}}
+
+} // namespace nealog
+
+#endif // !_WIN32
@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/RateLimit.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <ctime>
+
+
+namespace nealog
+{
+
+    NL_INLINE auto readCoarseSteadyNanoseconds() noexcept -> std::int64_t
+    {
+#ifdef CLOCK_MONOTONIC_COARSE
+        timespec now{};
+        ::clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#else
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+
+
+    NL_INLINE auto nextSampleRandom() noexcept -> std::uint32_t
+    {
+        // xorshift64*, seeded with the address of the state which differs per thread
+        thread_local std::uint64_t state = 0;
+        if (state == 0)
+        {
+            state = reinterpret_cast<std::uintptr_t>(&state) ^
+                    static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            state |= 1;
+        }
+
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return static_cast<std::uint32_t>((state * 0x2545F4914F6CDD1DULL) >> 32);
+    }
+
+} // namespace nealog
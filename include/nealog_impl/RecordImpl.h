@@ -0,0 +1,288 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/Record.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <fmt/args.h>
+#include <iterator>
+
+
+namespace nealog
+{
+
+    /******************************
+     * Record
+     ******************************/
+    // {{{
+
+    NL_INLINE auto Record::captureMessage(Severity severity, std::string_view message) -> void
+    {
+        severity_      = severity;
+        timestamp_     = captureTimestamp();
+        thread_        = getCurrentThread();
+        location_      = nullptr;
+        format_        = PLAIN_MESSAGE_FORMAT;
+        argumentsSize_ = 0;
+        fieldsSize_    = 0;
+        eagerMessage_.clear();
+        eagerFields_.clear();
+
+        if (!captureString(message))
+        {
+            format_ = {};
+            eagerMessage_.assign(message.data(), message.size());
+        }
+    }
+
+
+
+    NL_INLINE auto Record::captureString(std::string_view value) -> bool
+    {
+        const auto length = static_cast<std::uint32_t>(value.size());
+
+        if (argumentsSize_ + 1 + sizeof(length) + value.size() > ARGUMENT_CAPACITY)
+            return false;
+
+        char* position = arguments_.data() + argumentsSize_;
+        *position++    = static_cast<char>(ArgumentType::String);
+        std::memcpy(position, &length, sizeof(length));
+        std::memcpy(position + sizeof(length), value.data(), value.size());
+        argumentsSize_ += 1 + sizeof(length) + value.size();
+        return true;
+    }
+
+
+
+    template <typename T>
+    inline auto readArgumentValue(const char*& position) -> T
+    {
+        T value;
+        std::memcpy(&value, position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+
+
+    NL_INLINE auto Record::formatMessage(fmt::memory_buffer& out) const -> void
+    {
+        formatMessageWithoutFields(out);
+
+        forEachField(getFields(), [&out](std::string_view key, const ArgumentValue& value) {
+            out.push_back(' ');
+            out.append(key.data(), key.data() + key.size());
+            out.push_back('=');
+            appendArgumentText(out, value);
+        });
+    }
+
+
+
+    NL_INLINE auto Record::formatMessageWithoutFields(fmt::memory_buffer& out) const -> void
+    {
+        if (format_.data() == nullptr)
+        {
+            out.append(eagerMessage_.data(), eagerMessage_.data() + eagerMessage_.size());
+            return;
+        }
+
+        formatArguments(out, format_, getArguments());
+    }
+
+
+
+    NL_INLINE auto Record::getSeverity() const noexcept -> Severity
+    {
+        return severity_;
+    }
+
+
+
+    NL_INLINE auto Record::getTimestamp() const noexcept -> std::chrono::system_clock::time_point
+    {
+        return timestamp_;
+    }
+
+
+
+    NL_INLINE auto Record::getThread() const noexcept -> const ThreadIdentity&
+    {
+        return thread_;
+    }
+
+
+
+    NL_INLINE auto Record::setLocation(const SourceLocation* location) noexcept -> void
+    {
+        location_ = location;
+    }
+
+
+
+    NL_INLINE auto Record::getLocation() const noexcept -> const SourceLocation*
+    {
+        return location_;
+    }
+
+
+
+    NL_INLINE auto Record::getFormat() const noexcept -> std::string_view
+    {
+        return format_;
+    }
+
+
+
+    NL_INLINE auto Record::getArguments() const noexcept -> std::string_view
+    {
+        return {arguments_.data(), argumentsSize_};
+    }
+
+
+
+    NL_INLINE auto Record::getEagerMessage() const noexcept -> std::string_view
+    {
+        return eagerMessage_;
+    }
+
+
+
+    NL_INLINE auto Record::getFields() const noexcept -> std::string_view
+    {
+        if (!eagerFields_.empty())
+            return eagerFields_;
+
+        return {arguments_.data() + argumentsSize_, fieldsSize_};
+    }
+    // }}}
+
+
+
+    NL_INLINE auto formatArguments(fmt::memory_buffer& out, std::string_view format, std::string_view arguments)
+        -> void
+    {
+        // reused between calls so decoding does not allocate once it is warmed up
+        thread_local fmt::dynamic_format_arg_store<fmt::format_context> decodedArguments;
+        decodedArguments.clear();
+
+        const char* position = arguments.data();
+        const char* end      = position + arguments.size();
+
+        while (position < end)
+        {
+            std::visit(
+                [](auto value) {
+                    if constexpr (std::is_same_v<decltype(value), std::string_view>)
+                        decodedArguments.push_back(fmt::string_view{value.data(), value.size()});
+                    else
+                        decodedArguments.push_back(value);
+                },
+                readArgument(position));
+        }
+
+        fmt::vformat_to(std::back_inserter(out), fmt::string_view{format.data(), format.size()}, decodedArguments);
+    }
+
+
+
+    NL_INLINE auto readArgument(const char*& position) -> ArgumentValue
+    {
+        switch (static_cast<ArgumentType>(*position++))
+        {
+        case ArgumentType::Bool:
+            return readArgumentValue<bool>(position);
+        case ArgumentType::Char:
+            return readArgumentValue<char>(position);
+        case ArgumentType::Int:
+            return readArgumentValue<std::int64_t>(position);
+        case ArgumentType::UInt:
+            return readArgumentValue<std::uint64_t>(position);
+        case ArgumentType::Double:
+            return readArgumentValue<double>(position);
+        case ArgumentType::Float:
+            return readArgumentValue<float>(position);
+        case ArgumentType::Pointer:
+            return reinterpret_cast<const void*>(readArgumentValue<std::uintptr_t>(position));
+        case ArgumentType::String:
+        default: {
+            auto length = readArgumentValue<std::uint32_t>(position);
+            position += length;
+            return std::string_view{position - length, length};
+        }
+        }
+    }
+
+
+
+    NL_INLINE auto appendArgumentText(fmt::memory_buffer& out, const ArgumentValue& value) -> void
+    {
+        std::visit([&out](auto argument) { fmt::format_to(std::back_inserter(out), "{}", argument); }, value);
+    }
+
+
+
+    NL_INLINE auto isWellFormedArguments(std::string_view arguments) noexcept -> bool
+    {
+        const char* position = arguments.data();
+        const char* end      = position + arguments.size();
+
+        while (position < end)
+        {
+            std::size_t valueSize = 0;
+            switch (static_cast<ArgumentType>(*position++))
+            {
+            case ArgumentType::Bool:
+                // any other byte is no valid bool
+                if (position < end && static_cast<unsigned char>(*position) > 1)
+                    return false;
+                valueSize = sizeof(bool);
+                break;
+            case ArgumentType::Char:
+                valueSize = sizeof(char);
+                break;
+            case ArgumentType::Int:
+            case ArgumentType::UInt:
+                valueSize = sizeof(std::uint64_t);
+                break;
+            case ArgumentType::Double:
+                valueSize = sizeof(double);
+                break;
+            case ArgumentType::Float:
+                valueSize = sizeof(float);
+                break;
+            case ArgumentType::Pointer:
+                valueSize = sizeof(std::uintptr_t);
+                break;
+            case ArgumentType::String: {
+                if (static_cast<std::size_t>(end - position) < sizeof(std::uint32_t))
+                    return false;
+                valueSize = sizeof(std::uint32_t) + readArgumentValue<std::uint32_t>(position);
+                position -= sizeof(std::uint32_t);
+                break;
+            }
+            default:
+                return false;
+            }
+
+            if (static_cast<std::size_t>(end - position) < valueSize)
+                return false;
+            position += valueSize;
+        }
+
+        return true;
+    }
+
+
+
+    NL_INLINE auto appendStringArgument(fmt::memory_buffer& out, std::string_view value) -> void
+    {
+        const auto length = static_cast<std::uint32_t>(value.size());
+        const auto type   = static_cast<char>(ArgumentType::String);
+
+        out.push_back(type);
+        out.append(reinterpret_cast<const char*>(&length), reinterpret_cast<const char*>(&length) + sizeof(length));
+        out.append(value.data(), value.data() + value.size());
+    }
+
+} // namespace nealog
@@ -16,23 +16,11 @@ namespace nealog
 
     NL_INLINE auto severityToString(Severity severity) -> const std::string
     {
-        switch (severity)
-        {
-        case Severity::Trace:
-            return "Trace";
-        case Severity::Debug:
-            return "Debug";
-        case Severity::Info:
-            return "Info";
-        case Severity::Warn:
-            return "Warn";
-        case Severity::Error:
-            return "Error";
-        case Severity::Fatal:
-            return "Fatal";
-        default:
+        const std::string_view name = severityName(severity);
+        if (name.empty())
             throw ParseException(SEVERITY_PARSE_ERROR);
-        }
+
+        return std::string{name};
     }
 
 
@@ -43,14 +31,14 @@ namespace nealog
 
     NL_INLINE auto WithSeverity::setSeverity(Severity severity) -> void
     {
-        severity_ = severity;
+        severity_.store(severity, std::memory_order_relaxed);
     }
 
 
 
     NL_INLINE auto WithSeverity::getSeverity() noexcept -> Severity
     {
-        return severity_;
+        return severity_.load(std::memory_order_relaxed);
     }
 
 } // namespace nealog
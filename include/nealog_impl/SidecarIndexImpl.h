@@ -0,0 +1,419 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/SidecarIndex.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+namespace nealog
+{
+
+    constexpr std::size_t SIDECAR_INDEX_MAGIC_SIZE = 7;
+
+
+
+    NL_INLINE SidecarIndexFormatException::SidecarIndexFormatException(const std::string& reason)
+        : std::runtime_error("Malformed sidecar index: " + reason)
+    {
+    }
+
+
+
+    NL_INLINE auto isInLoggerSubtree(std::string_view loggerName, std::string_view subtree) noexcept -> bool
+    {
+        if (loggerName.compare(0, subtree.size(), subtree) != 0)
+            return false;
+
+        return subtree.empty() || loggerName.size() == subtree.size() || loggerName[subtree.size()] == '.';
+    }
+
+
+
+    NL_INLINE auto nanosecondsSinceEpoch(std::chrono::system_clock::time_point timestamp) -> std::int64_t
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    }
+
+
+
+    /******************************
+     * SidecarIndexWriter
+     ******************************/
+    // {{{
+
+    NL_INLINE SidecarIndexWriter::SidecarIndexWriter(int fileDescriptor, std::size_t blockSize,
+                                                     std::uint64_t fileSize)
+        : fileDescriptor_(fileDescriptor), blockSize_(blockSize), blockBegin_(fileSize)
+    {
+        entry_.push_back(static_cast<char>(IndexEntryType::Session));
+        entry_.append(SIDECAR_INDEX_MAGIC, SIDECAR_INDEX_MAGIC + SIDECAR_INDEX_MAGIC_SIZE);
+        entry_.push_back(static_cast<char>(SIDECAR_INDEX_VERSION));
+        writeEntry();
+    }
+
+
+
+    NL_INLINE SidecarIndexWriter::~SidecarIndexWriter()
+    {
+#ifdef _WIN32
+        ::_close(fileDescriptor_);
+#else
+        ::close(fileDescriptor_);
+#endif
+    }
+
+
+
+    NL_INLINE auto SidecarIndexWriter::add(Severity messageSeverity, std::string_view loggerName) -> void
+    {
+        if (!blockOpen_)
+        {
+            blockOpen_     = true;
+            blockOpenedAt_ = std::chrono::system_clock::now();
+        }
+
+        severityMask_ |= static_cast<std::uint8_t>(1u << static_cast<unsigned>(messageSeverity));
+
+        const std::uint64_t id = internLoggerName(loggerName);
+        if (loggerSeenInBlock_[id] != blockNumber_ + 1)
+        {
+            loggerSeenInBlock_[id] = blockNumber_ + 1;
+            blockLoggers_.push_back(id);
+        }
+    }
+
+
+
+    NL_INLINE auto SidecarIndexWriter::commit(std::uint64_t fileSize) -> void
+    {
+        if (!blockOpen_)
+        {
+            blockBegin_ = fileSize;
+            return;
+        }
+
+        if (fileSize >= blockBegin_ + blockSize_)
+            writeBlock(fileSize);
+    }
+
+
+
+    NL_INLINE auto SidecarIndexWriter::close(std::uint64_t fileSize) -> void
+    {
+        if (!blockOpen_)
+        {
+            blockBegin_ = fileSize;
+            return;
+        }
+
+        writeBlock(fileSize);
+    }
+
+
+
+    NL_INLINE auto SidecarIndexWriter::getWriteErrorCount() const noexcept -> std::size_t
+    {
+        return writeErrorCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto SidecarIndexWriter::internLoggerName(std::string_view loggerName) -> std::uint64_t
+    {
+        if (loggerName.data() == lastLoggerAddress_ && lastLoggerAddress_ != nullptr &&
+            loggerNames_[lastLoggerId_] == loggerName)
+        {
+            return lastLoggerId_;
+        }
+
+        std::uint64_t id = loggerNames_.size();
+        auto position    = loggerIds_.find(loggerName);
+        if (position != loggerIds_.end())
+        {
+            id = position->second;
+        }
+        else
+        {
+            const std::string& key = loggerNames_.emplace_back(loggerName);
+            loggerIds_.emplace(key, id);
+            loggerSeenInBlock_.push_back(0);
+
+            // new names are written in front of the block which uses them
+            entry_.push_back(static_cast<char>(IndexEntryType::LoggerName));
+            appendVarint(entry_, id);
+            appendVarint(entry_, loggerName.size());
+            entry_.append(loggerName.data(), loggerName.data() + loggerName.size());
+        }
+
+        lastLoggerAddress_ = loggerName.data();
+        lastLoggerId_      = id;
+        return id;
+    }
+
+
+
+    NL_INLINE auto SidecarIndexWriter::writeBlock(std::uint64_t fileSize) -> void
+    {
+        const std::int64_t openedAt = nanosecondsSinceEpoch(blockOpenedAt_);
+        const std::int64_t closedAt = nanosecondsSinceEpoch(std::chrono::system_clock::now());
+
+        // a failed write of the log file may leave it shorter than expected
+        const std::uint64_t blockEnd = std::max(fileSize, blockBegin_);
+
+        entry_.push_back(static_cast<char>(IndexEntryType::Block));
+        appendVarint(entry_, blockBegin_);
+        appendVarint(entry_, blockEnd - blockBegin_);
+        appendVarint(entry_, encodeZigzag(openedAt - lastBlockOpenedAt_));
+        appendVarint(entry_, static_cast<std::uint64_t>(std::max<std::int64_t>(closedAt - openedAt, 0)));
+        entry_.push_back(static_cast<char>(severityMask_));
+        appendVarint(entry_, blockLoggers_.size());
+        for (std::uint64_t id : blockLoggers_)
+            appendVarint(entry_, id);
+
+        writeEntry();
+
+        blockLoggers_.clear();
+        blockBegin_        = blockEnd;
+        blockOpen_         = false;
+        severityMask_      = 0;
+        lastBlockOpenedAt_ = openedAt;
+        blockNumber_++;
+    }
+
+
+
+    NL_INLINE auto SidecarIndexWriter::writeEntry() -> void
+    {
+        // entries are rare, so each one goes to the file right away
+        const char* data = entry_.data();
+        std::size_t size = entry_.size();
+        while (size > 0)
+        {
+#ifdef _WIN32
+            auto written = ::_write(fileDescriptor_, data, static_cast<unsigned int>(size));
+#else
+            auto written = ::write(fileDescriptor_, data, size);
+#endif
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                writeErrorCount_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        entry_.clear();
+    }
+    // }}}
+
+
+
+    /******************************
+     * SidecarIndex
+     ******************************/
+    // {{{
+
+    NL_INLINE auto readIndexByte(std::string_view& input) -> std::uint8_t
+    {
+        if (input.empty())
+            throw SidecarIndexFormatException("unexpected end of input");
+
+        const auto value = static_cast<std::uint8_t>(input.front());
+        input.remove_prefix(1);
+        return value;
+    }
+
+
+
+    NL_INLINE auto readIndexVarint(std::string_view& input) -> std::uint64_t
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            const std::uint8_t byte = readIndexByte(input);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+
+        throw SidecarIndexFormatException("number too large");
+    }
+
+
+
+    NL_INLINE auto readIndexBytes(std::string_view& input, std::uint64_t size) -> std::string_view
+    {
+        if (size > input.size())
+            throw SidecarIndexFormatException("unexpected end of input");
+
+        const std::string_view bytes = input.substr(0, static_cast<std::size_t>(size));
+        input.remove_prefix(static_cast<std::size_t>(size));
+        return bytes;
+    }
+
+
+
+    NL_INLINE auto timePointFromNanoseconds(std::int64_t nanoseconds) -> std::chrono::system_clock::time_point
+    {
+        return std::chrono::system_clock::time_point{
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{nanoseconds})};
+    }
+
+
+
+    NL_INLINE SidecarIndex::SidecarIndex(std::istream& input)
+    {
+        const std::string content{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+        std::string_view remaining{content};
+
+        while (!remaining.empty())
+        {
+            const auto type = static_cast<IndexEntryType>(readIndexByte(remaining));
+            if (type == IndexEntryType::Session)
+            {
+                readSession(remaining);
+                continue;
+            }
+
+            if (!inSession_)
+                throw SidecarIndexFormatException("missing session header");
+
+            switch (type)
+            {
+            case IndexEntryType::LoggerName:
+                readLoggerName(remaining);
+                break;
+            case IndexEntryType::Block:
+                readBlock(remaining);
+                break;
+            default:
+                throw SidecarIndexFormatException("unknown entry type " +
+                                                  std::to_string(static_cast<unsigned>(type)));
+            }
+        }
+    }
+
+
+
+    NL_INLINE auto SidecarIndex::getBlocks() const -> const std::vector<IndexedBlock>&
+    {
+        return blocks_;
+    }
+
+
+
+    NL_INLINE auto SidecarIndex::getLoggerNames() const -> const std::vector<std::string>&
+    {
+        return loggerNames_;
+    }
+
+
+
+    NL_INLINE auto SidecarIndex::findBlocks(const IndexQuery& query) const -> std::vector<const IndexedBlock*>
+    {
+        std::vector<bool> matchingLoggers(loggerNames_.size());
+        for (std::size_t i = 0; i < loggerNames_.size(); i++)
+            matchingLoggers[i] = isInLoggerSubtree(loggerNames_[i], query.loggerSubtree);
+
+        const unsigned lowestSeverity = static_cast<unsigned>(query.severity);
+
+        std::vector<const IndexedBlock*> found;
+        for (const IndexedBlock& block : blocks_)
+        {
+            if (block.lastTimestamp < query.from || block.firstTimestamp > query.to)
+                continue;
+
+            if ((block.severityMask >> lowestSeverity) == 0)
+                continue;
+
+            if (!query.loggerSubtree.empty() &&
+                std::none_of(block.loggers.begin(), block.loggers.end(),
+                             [&matchingLoggers](std::size_t logger) { return matchingLoggers[logger]; }))
+            {
+                continue;
+            }
+
+            found.push_back(&block);
+        }
+        return found;
+    }
+
+
+
+    NL_INLINE auto SidecarIndex::readSession(std::string_view& input) -> void
+    {
+        if (readIndexBytes(input, SIDECAR_INDEX_MAGIC_SIZE) != SIDECAR_INDEX_MAGIC)
+            throw SidecarIndexFormatException("not a nealog sidecar index");
+
+        if (readIndexByte(input) != SIDECAR_INDEX_VERSION)
+            throw SidecarIndexFormatException("unsupported version");
+
+        sessionLoggers_.clear();
+        lastBlockOpenedAt_ = 0;
+        inSession_         = true;
+    }
+
+
+
+    NL_INLINE auto SidecarIndex::readLoggerName(std::string_view& input) -> void
+    {
+        if (readIndexVarint(input) != sessionLoggers_.size())
+            throw SidecarIndexFormatException("logger name ids out of order");
+
+        const std::string name{readIndexBytes(input, readIndexVarint(input))};
+
+        auto position = loggerPositions_.find(name);
+        if (position == loggerPositions_.end())
+        {
+            position = loggerPositions_.emplace(name, loggerNames_.size()).first;
+            loggerNames_.push_back(name);
+        }
+        sessionLoggers_.push_back(position->second);
+    }
+
+
+
+    NL_INLINE auto SidecarIndex::readBlock(std::string_view& input) -> void
+    {
+        IndexedBlock& block = blocks_.emplace_back();
+        block.offset        = readIndexVarint(input);
+        block.size          = readIndexVarint(input);
+
+        const std::int64_t openedAt  = lastBlockOpenedAt_ + decodeZigzag(readIndexVarint(input));
+        const std::uint64_t duration = readIndexVarint(input);
+        block.firstTimestamp         = timePointFromNanoseconds(openedAt);
+        block.lastTimestamp          = timePointFromNanoseconds(openedAt + static_cast<std::int64_t>(duration));
+        block.severityMask           = readIndexByte(input);
+        lastBlockOpenedAt_           = openedAt;
+
+        const std::uint64_t loggerCount = readIndexVarint(input);
+        if (loggerCount > sessionLoggers_.size())
+            throw SidecarIndexFormatException("more loggers than names");
+
+        block.loggers.reserve(static_cast<std::size_t>(loggerCount));
+        for (std::uint64_t i = 0; i < loggerCount; i++)
+        {
+            const std::uint64_t id = readIndexVarint(input);
+            if (id >= sessionLoggers_.size())
+                throw SidecarIndexFormatException("unknown logger name id " + std::to_string(id));
+
+            block.loggers.push_back(sessionLoggers_[static_cast<std::size_t>(id)]);
+        }
+    }
+    // }}}
+
+} // namespace nealog
@@ -5,14 +5,40 @@
 #endif // !NEALOG_HEADERONLY
  
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
+#include <system_error>
+#include <vector>
+
+#ifdef NEALOG_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 
 namespace nealog
 {
-    constexpr const char* SINKTYPE_NOT_SUPPORTED = "The given Sinktype is not supported";
+    constexpr const char* SINKTYPE_NOT_SUPPORTED    = "The given Sinktype is not supported";
+    constexpr const char* COMPRESSION_NOT_SUPPORTED = "nealog was built without support for this compression";
+    constexpr const char* GZIP_SUFFIX               = ".gz";
+    constexpr const char* INCOMPLETE_SUFFIX         = ".tmp";
+    constexpr std::size_t COMPRESSION_CHUNK_SIZE    = 64 * 1024;
+    constexpr std::size_t MAX_WRITE_VECTORS         = 64;
 
     NL_INLINE UnsupportedSinkTypeException::UnsupportedSinkTypeException() : std::runtime_error(SINKTYPE_NOT_SUPPORTED)
     {
@@ -20,6 +46,20 @@ namespace nealog
 
 
 
+    NL_INLINE UnsupportedCompressionException::UnsupportedCompressionException()
+        : std::runtime_error(COMPRESSION_NOT_SUPPORTED)
+    {
+    }
+
+
+
+    NL_INLINE FileSinkException::FileSinkException(const std::string& path, int errorNumber)
+        : std::runtime_error("Cannot open log file \"" + path + "\": " + std::strerror(errorNumber))
+    {
+    }
+
+
+
     NL_INLINE auto SinkFactory::createStreamSink(const std::ostream& outputStream) -> std::shared_ptr<StreamSink>
     {
         auto sink = std::make_shared<StreamSink>(outputStream);
@@ -36,6 +76,93 @@ namespace nealog
 
 
 
+    NL_INLINE auto SinkFactory::createFileSink(const std::string& path, FileFlushPolicy flushPolicy,
+                                               std::size_t bufferSize, FileIndexPolicy indexPolicy)
+        -> std::shared_ptr<FileSink>
+    {
+        auto sink = std::make_shared<FileSink>(path, flushPolicy, bufferSize, indexPolicy);
+        return sink;
+    }
+
+
+
+    NL_INLINE auto SinkFactory::createRotatingFileSink(const std::string& path, RotationPolicy rotationPolicy,
+                                                       FileFlushPolicy flushPolicy, std::size_t bufferSize,
+                                                       FileIndexPolicy indexPolicy)
+        -> std::shared_ptr<RotatingFileSink>
+    {
+        auto sink = std::make_shared<RotatingFileSink>(path, rotationPolicy, flushPolicy, bufferSize, indexPolicy);
+        return sink;
+    }
+
+
+
+    /******************************
+     * Sink
+     ******************************/
+    NL_INLINE auto Sink::writeBatch(const SinkRecord* records, std::size_t count) -> void
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            write(records[i].severity, records[i].message);
+        }
+    }
+
+
+
+    NL_INLINE auto Sink::writeFromLogger(std::string_view, Severity messageSeverity, std::string_view message) -> void
+    {
+        write(messageSeverity, message);
+    }
+
+
+
+    NL_INLINE auto Sink::writeRecord(const Record& record, std::string_view) -> void
+    {
+        fmt::memory_buffer message;
+        record.formatMessage(message);
+        write(record.getSeverity(), {message.data(), message.size()});
+    }
+
+
+
+    NL_INLINE auto Sink::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        if (!tryLockUntil(deadline))
+            return;
+
+        flushLocked();
+        mutex_.unlock();
+    }
+
+
+
+    NL_INLINE auto Sink::tryLockUntil(std::chrono::steady_clock::time_point deadline) -> bool
+    {
+        while (!mutex_.try_lock())
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+
+
+    NL_INLINE auto Sink::flushLocked() -> void
+    {
+    }
+
+
+
+    NL_INLINE auto Sink::flushIfDue() -> void
+    {
+    }
+
+
+
     /******************************
      * NoopSink
      ******************************/
@@ -115,7 +242,7 @@ namespace nealog
     NL_INLINE auto StreamSink::write(Severity messageSeverity, std::string_view message) -> void
     {
         mutex_.lock();
-        if (messageSeverity >= severity_)
+        if (messageSeverity >= severity_.load(std::memory_order_relaxed))
         {
             stream_->write(message.data(), message.size());
         }
@@ -124,6 +251,23 @@ namespace nealog
 
 
 
+    NL_INLINE auto StreamSink::writeBatch(const SinkRecord* records, std::size_t count) -> void
+    {
+        const Severity threshold = severity_.load(std::memory_order_relaxed);
+
+        mutex_.lock();
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (records[i].severity >= threshold)
+            {
+                stream_->write(records[i].message.data(), records[i].message.size());
+            }
+        }
+        mutex_.unlock();
+    }
+
+
+
     NL_INLINE auto StreamSink::flush() -> void
     {
         mutex_.lock();
@@ -133,6 +277,13 @@ namespace nealog
 
 
 
+    NL_INLINE auto StreamSink::flushLocked() -> void
+    {
+        stream_->flush();
+    }
+
+
+
     NL_INLINE auto StreamSink::getUnderlyingStream() const -> std::shared_ptr<std::ostream>
     {
         return stream_;
@@ -149,4 +300,847 @@ namespace nealog
     {
     }
 
+
+
+
+    /******************************
+     * FileSink
+     ******************************/
+    //{{{
+
+    NL_INLINE auto openForAppending(const std::string& path) -> int
+    {
+#ifdef _WIN32
+        int fileDescriptor = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        int fileDescriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+        if (fileDescriptor < 0)
+            throw FileSinkException(path, errno);
+
+        return fileDescriptor;
+    }
+
+
+
+    /******************************
+     * FileFlushTimer
+     ******************************/
+    NL_INLINE auto FileFlushTimer::getInstance() -> FileFlushTimer&
+    {
+        static FileFlushTimer* timer = new FileFlushTimer;
+        return *timer;
+    }
+
+
+
+    NL_INLINE auto FileFlushTimer::schedule(Sink* sink, std::chrono::steady_clock::time_point deadline) -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (!started_)
+        {
+            // detached, the timer lives as long as the process
+            std::thread(&FileFlushTimer::run, this).detach();
+            started_ = true;
+        }
+
+        const auto position = deadlines_.emplace(deadline, sink);
+        if (position == deadlines_.begin())
+            condition_.notify_one();
+    }
+
+
+
+    NL_INLINE auto FileFlushTimer::cancel(Sink* sink) -> void
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        condition_.wait(lock, [this, sink] { return flushing_ != sink; });
+
+        for (auto it = deadlines_.begin(); it != deadlines_.end();)
+            it = it->second == sink ? deadlines_.erase(it) : std::next(it);
+    }
+
+
+
+    NL_INLINE auto FileFlushTimer::run() -> void
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        while (true)
+        {
+            if (deadlines_.empty())
+            {
+                condition_.wait(lock);
+                continue;
+            }
+
+            const auto first = deadlines_.begin();
+            if (std::chrono::steady_clock::now() < first->first)
+            {
+                condition_.wait_until(lock, first->first);
+                continue;
+            }
+
+            // the sink is locked without the timer mutex, which writing threads take under the sink mutex
+            Sink* sink = first->second;
+            flushing_  = sink;
+            deadlines_.erase(first);
+            lock.unlock();
+            sink->flushIfDue();
+            lock.lock();
+
+            flushing_ = nullptr;
+            condition_.notify_all();
+        }
+    }
+
+
+
+    NL_INLINE FileSink::FileSink(const std::string& path, FileFlushPolicy flushPolicy, std::size_t bufferSize,
+                                 FileIndexPolicy indexPolicy)
+        // the buffer is left uninitialized, a rotation should not pay for clearing it
+        : path_(path), flushPolicy_(flushPolicy), buffer_(new char[bufferSize]),
+          bufferCapacity_(bufferSize)
+    {
+        fileDescriptor_ = openForAppending(path);
+        syncFileSize();
+
+        if (!indexPolicy.enabled)
+            return;
+
+        try
+        {
+            index_ = std::make_unique<SidecarIndexWriter>(openForAppending(path + SIDECAR_INDEX_SUFFIX),
+                                                          indexPolicy.blockSize, fileSize_);
+        }
+        catch (const FileSinkException&)
+        {
+#ifdef _WIN32
+            ::_close(fileDescriptor_);
+#else
+            ::close(fileDescriptor_);
+#endif
+            throw;
+        }
+    }
+
+
+
+    NL_INLINE FileSink::~FileSink()
+    {
+        if (flushPolicy_.interval.count() > 0)
+            FileFlushTimer::getInstance().cancel(this);
+
+        writeBuffer();
+        if (index_)
+            index_->close(fileSize_);
+
+#ifdef _WIN32
+        ::_close(fileDescriptor_);
+#else
+        ::close(fileDescriptor_);
+#endif
+    }
+
+
+
+    NL_INLINE auto FileSink::getType() -> SinkType
+    {
+        return SinkType::File;
+    }
+
+
+
+    NL_INLINE auto FileSink::write(Severity messageSeverity, std::string_view message) -> void
+    {
+        if (messageSeverity < severity_.load(std::memory_order_relaxed))
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        append(messageSeverity, message, {});
+    }
+
+
+
+    NL_INLINE auto FileSink::writeFromLogger(std::string_view loggerName, Severity messageSeverity,
+                                             std::string_view message) -> void
+    {
+        if (messageSeverity < severity_.load(std::memory_order_relaxed))
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        append(messageSeverity, message, loggerName);
+    }
+
+
+
+    NL_INLINE auto FileSink::writeBatch(const SinkRecord* records, std::size_t count) -> void
+    {
+        const Severity threshold = severity_.load(std::memory_order_relaxed);
+
+        std::size_t batchSize = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (records[i].severity >= threshold)
+                batchSize += records[i].message.size();
+        }
+
+        if (batchSize == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (bufferSize_ + batchSize > bufferCapacity_)
+        {
+            writeVectored(records, count, threshold);
+            return;
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (records[i].severity >= threshold)
+                append(records[i].severity, records[i].message, records[i].loggerName);
+        }
+    }
+
+
+
+    NL_INLINE auto FileSink::append(Severity messageSeverity, std::string_view message, std::string_view loggerName)
+        -> void
+    {
+        if (bufferSize_ + message.size() > bufferCapacity_)
+        {
+            writeBuffer();
+
+            // too large for the buffer at all, so it bypasses it
+            if (message.size() > bufferCapacity_)
+            {
+                if (index_)
+                    index_->add(messageSeverity, loggerName);
+
+                writeToFile(message.data(), message.size());
+                if (index_)
+                    index_->commit(fileSize_);
+                return;
+            }
+        }
+
+        if (index_)
+            index_->add(messageSeverity, loggerName);
+
+        const bool checkInterval = flushPolicy_.interval.count() > 0;
+        if (bufferSize_ == 0 && checkInterval)
+        {
+            oldestBufferedAt_ = std::chrono::steady_clock::now();
+
+            // a deadline still scheduled is earlier, the timer moves it on if the buffer is not due yet
+            if (!flushScheduled_)
+            {
+                flushScheduled_ = true;
+                FileFlushTimer::getInstance().schedule(this, oldestBufferedAt_ + flushPolicy_.interval);
+            }
+        }
+
+        std::memcpy(buffer_.get() + bufferSize_, message.data(), message.size());
+        bufferSize_ += message.size();
+
+        if (messageSeverity >= flushPolicy_.severity ||
+            (checkInterval && std::chrono::steady_clock::now() - oldestBufferedAt_ >= flushPolicy_.interval))
+        {
+            writeBuffer();
+        }
+    }
+
+
+
+    NL_INLINE auto FileSink::flush() -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        writeBuffer();
+        if (index_)
+            index_->close(fileSize_);
+    }
+
+
+
+    NL_INLINE auto FileSink::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        if (!tryLockUntil(deadline))
+            return;
+
+        if (bufferSize_ > 0)
+        {
+            writeToFile(buffer_.get(), bufferSize_);
+            bufferSize_ = 0;
+        }
+        mutex_.unlock();
+    }
+
+
+
+    NL_INLINE auto FileSink::getPath() const -> const std::string&
+    {
+        return path_;
+    }
+
+
+
+    NL_INLINE auto FileSink::getWriteErrorCount() const noexcept -> std::size_t
+    {
+        const std::size_t indexErrors = index_ ? index_->getWriteErrorCount() : 0;
+        return writeErrorCount_.load(std::memory_order_relaxed) + indexErrors;
+    }
+
+
+
+    NL_INLINE auto FileSink::writeBuffer() -> void
+    {
+        if (bufferSize_ == 0)
+            return;
+
+        writeToFile(buffer_.get(), bufferSize_);
+        bufferSize_ = 0;
+
+        if (index_)
+            index_->commit(fileSize_);
+    }
+
+
+
+    NL_INLINE auto FileSink::writeToFile(const char* data, std::size_t size) -> void
+    {
+        while (size > 0)
+        {
+#ifdef _WIN32
+            auto written = ::_write(fileDescriptor_, data, static_cast<unsigned int>(size));
+#else
+            auto written = ::write(fileDescriptor_, data, size);
+#endif
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                writeErrorCount_.fetch_add(1, std::memory_order_relaxed);
+                syncFileSize();
+                return;
+            }
+
+            data += written;
+            size -= static_cast<std::size_t>(written);
+            fileSize_ += static_cast<std::uint64_t>(written);
+        }
+    }
+
+
+
+    NL_INLINE auto FileSink::writeVectored(const SinkRecord* records, std::size_t count, Severity threshold) -> void
+    {
+#ifdef _WIN32
+        writeBuffer();
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (records[i].severity < threshold)
+                continue;
+
+            if (index_)
+                index_->add(records[i].severity, records[i].loggerName);
+            writeToFile(records[i].message.data(), records[i].message.size());
+        }
+#else
+        iovec vectors[MAX_WRITE_VECTORS];
+        std::size_t vectorCount = 0;
+
+        auto writeVectors = [this, &vectors, &vectorCount]() {
+            iovec* pending = vectors;
+            while (vectorCount > 0)
+            {
+                auto written = ::writev(fileDescriptor_, pending, static_cast<int>(vectorCount));
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    writeErrorCount_.fetch_add(1, std::memory_order_relaxed);
+                    syncFileSize();
+                    break;
+                }
+
+                // skip what is written, a partial write continues within a vector
+                fileSize_ += static_cast<std::uint64_t>(written);
+                auto remaining = static_cast<std::size_t>(written);
+                while (vectorCount > 0 && remaining >= pending->iov_len)
+                {
+                    remaining -= pending->iov_len;
+                    pending++;
+                    vectorCount--;
+                }
+
+                if (vectorCount > 0)
+                {
+                    pending->iov_base = static_cast<char*>(pending->iov_base) + remaining;
+                    pending->iov_len -= remaining;
+                }
+            }
+            vectorCount = 0;
+        };
+
+        if (bufferSize_ > 0)
+            vectors[vectorCount++] = {buffer_.get(), bufferSize_};
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const SinkRecord& record = records[i];
+            if (record.severity < threshold)
+                continue;
+
+            if (index_)
+                index_->add(record.severity, record.loggerName);
+            if (record.message.empty())
+                continue;
+
+            if (vectorCount == MAX_WRITE_VECTORS)
+                writeVectors();
+
+            vectors[vectorCount++] = {const_cast<char*>(record.message.data()), record.message.size()};
+        }
+
+        writeVectors();
+        bufferSize_ = 0;
+#endif
+
+        if (index_)
+            index_->commit(fileSize_);
+    }
+
+
+
+    NL_INLINE auto FileSink::flushIfDue() -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        flushScheduled_ = false;
+        if (bufferSize_ == 0)
+            return;
+
+        const auto deadline = oldestBufferedAt_ + flushPolicy_.interval;
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            writeBuffer();
+            return;
+        }
+
+        flushScheduled_ = true;
+        FileFlushTimer::getInstance().schedule(this, deadline);
+    }
+
+
+
+    NL_INLINE auto FileSink::syncFileSize() -> void
+    {
+#ifdef _WIN32
+        auto size = ::_lseeki64(fileDescriptor_, 0, SEEK_END);
+#else
+        auto size = ::lseek(fileDescriptor_, 0, SEEK_END);
+#endif
+        if (size >= 0)
+            fileSize_ = static_cast<std::uint64_t>(size);
+    }
+
+    //}}}
+
+
+
+
+    NL_INLINE auto findLastSegment(const std::string& path) -> std::uint64_t
+    {
+        namespace fs = std::filesystem;
+
+        const fs::path filePath{path};
+        const std::string prefix = filePath.filename().string() + ".";
+        fs::path directory       = filePath.parent_path();
+        if (directory.empty())
+            directory = ".";
+
+        std::uint64_t lastSegment = 0;
+        std::error_code error;
+        for (const auto& entry : fs::directory_iterator{directory, error})
+        {
+            const std::string name = entry.path().filename().string();
+            if (name.compare(0, prefix.size(), prefix) != 0)
+                continue;
+
+            std::uint64_t segment = 0;
+            std::size_t position  = prefix.size();
+            while (position < name.size() && name[position] >= '0' && name[position] <= '9')
+                segment = segment * 10 + static_cast<std::uint64_t>(name[position++] - '0');
+
+            if (position > prefix.size())
+                lastSegment = std::max(lastSegment, segment);
+        }
+
+        return lastSegment;
+    }
+
+
+
+    /******************************
+     * RotatingFileSink
+     ******************************/
+    //{{{
+
+    NL_INLINE RotatingFileSink::RotatingFileSink(const std::string& path, RotationPolicy rotationPolicy,
+                                                 FileFlushPolicy flushPolicy, std::size_t bufferSize,
+                                                 FileIndexPolicy indexPolicy)
+        : path_(path), rotationPolicy_(rotationPolicy), flushPolicy_(flushPolicy), bufferSize_(bufferSize),
+          indexPolicy_(indexPolicy)
+    {
+#ifndef NEALOG_HAS_ZLIB
+        if (rotationPolicy.compression == SegmentCompression::Gzip)
+            throw UnsupportedCompressionException();
+#endif
+
+        file_        = std::make_unique<FileSink>(path_, flushPolicy_, bufferSize_, indexPolicy_);
+        lastSegment_ = findLastSegment(path_);
+
+        std::error_code error;
+        auto existingSize = std::filesystem::file_size(path_, error);
+        fileSize_         = error ? 0 : static_cast<std::size_t>(existingSize);
+        nextRotation_     = computeNextRotation();
+
+        worker_ = std::thread(&RotatingFileSink::run, this);
+    }
+
+
+
+    NL_INLINE RotatingFileSink::~RotatingFileSink()
+    {
+        {
+            std::lock_guard<std::mutex> lock{segmentsMutex_};
+            running_ = false;
+        }
+        segmentsCondition_.notify_all();
+
+        if (worker_.joinable())
+            worker_.join();
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::getType() -> SinkType
+    {
+        return SinkType::RotatingFile;
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::write(Severity messageSeverity, std::string_view message) -> void
+    {
+        writeFromLogger({}, messageSeverity, message);
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::writeFromLogger(std::string_view loggerName, Severity messageSeverity,
+                                                     std::string_view message) -> void
+    {
+        if (messageSeverity < severity_.load(std::memory_order_relaxed))
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (needsRotation(message.size()))
+            rotateLocked();
+
+        file_->writeFromLogger(loggerName, messageSeverity, message);
+        fileSize_ += message.size();
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::writeBatch(const SinkRecord* records, std::size_t count) -> void
+    {
+        const Severity threshold = severity_.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        // records are handed to the file in runs which end at a rotation or a skipped record
+        std::size_t runBegin = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (records[i].severity < threshold)
+            {
+                file_->writeBatch(records + runBegin, i - runBegin);
+                runBegin = i + 1;
+                continue;
+            }
+
+            if (needsRotation(records[i].message.size()))
+            {
+                file_->writeBatch(records + runBegin, i - runBegin);
+                runBegin = i;
+                rotateLocked();
+            }
+
+            fileSize_ += records[i].message.size();
+        }
+
+        file_->writeBatch(records + runBegin, count - runBegin);
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::flush() -> void
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            file_->flush();
+        }
+
+        std::unique_lock<std::mutex> lock{segmentsMutex_};
+        const std::size_t target = rotatedCount_;
+        segmentsCondition_.wait(lock, [this, target]() { return finishedCount_ >= target; });
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        if (!tryLockUntil(deadline))
+            return;
+
+        file_->flushOnCrash(deadline);
+
+        // a segment the worker took already is closed by it
+        std::unique_lock<std::mutex> lock{segmentsMutex_, std::defer_lock};
+        while (!lock.try_lock() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+
+        if (lock.owns_lock())
+        {
+            for (ClosedSegment& segment : closedSegments_)
+                segment.file->flushOnCrash(deadline);
+        }
+        mutex_.unlock();
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::rotate() -> void
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        rotateLocked();
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::needsRotation(std::size_t messageSize) const -> bool
+    {
+        const bool exceedsSize = rotationPolicy_.maxSize > 0 && fileSize_ > 0 &&
+                                 fileSize_ + messageSize > rotationPolicy_.maxSize;
+        const bool intervalPassed =
+            rotationPolicy_.interval.count() > 0 && std::chrono::system_clock::now() >= nextRotation_;
+        if (!exceedsSize && !intervalPassed)
+            return false;
+
+        // the clock is only read while a failed rotation backs off
+        return retryRotationAt_ == std::chrono::steady_clock::time_point{} ||
+               std::chrono::steady_clock::now() >= retryRotationAt_;
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::getPath() const -> const std::string&
+    {
+        return path_;
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::getSegmentPath(std::uint64_t segment) const -> std::string
+    {
+        return path_ + "." + std::to_string(segment);
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::getRotationErrorCount() const noexcept -> std::size_t
+    {
+        return rotationErrorCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::rotateLocked() -> void
+    {
+        const std::uint64_t segment = lastSegment_ + 1;
+
+        // the open descriptor of file_ follows the rename, so its buffered
+        // messages still end up in the segment when the worker closes it
+        if (std::rename(path_.c_str(), getSegmentPath(segment).c_str()) != 0)
+        {
+            backOffRotation();
+            return;
+        }
+
+        if (indexPolicy_.enabled)
+        {
+            const std::string indexPath = path_ + SIDECAR_INDEX_SUFFIX;
+            std::rename(indexPath.c_str(), (getSegmentPath(segment) + SIDECAR_INDEX_SUFFIX).c_str());
+        }
+
+        std::unique_ptr<FileSink> closedFile = std::move(file_);
+        try
+        {
+            file_ = std::make_unique<FileSink>(path_, flushPolicy_, bufferSize_, indexPolicy_);
+        }
+        catch (const FileSinkException&)
+        {
+            // keep writing into the renamed file rather than losing messages
+            file_ = std::move(closedFile);
+            backOffRotation();
+            return;
+        }
+
+        lastSegment_     = segment;
+        fileSize_        = 0;
+        nextRotation_    = computeNextRotation();
+        retryRotationAt_ = {};
+
+        {
+            std::lock_guard<std::mutex> lock{segmentsMutex_};
+            closedSegments_.push_back({std::move(closedFile), segment});
+            rotatedCount_++;
+        }
+        segmentsCondition_.notify_all();
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::backOffRotation() -> void
+    {
+        rotationErrorCount_.fetch_add(1, std::memory_order_relaxed);
+        retryRotationAt_ = std::chrono::steady_clock::now() + rotationPolicy_.retryDelay;
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::computeNextRotation() const -> std::chrono::system_clock::time_point
+    {
+        using namespace std::chrono;
+
+        if (rotationPolicy_.interval.count() <= 0)
+            return system_clock::time_point::max();
+
+        auto sinceEpoch = duration_cast<seconds>(system_clock::now().time_since_epoch());
+        auto periods    = sinceEpoch / rotationPolicy_.interval;
+        auto next       = rotationPolicy_.interval * (periods + 1);
+        return system_clock::time_point{duration_cast<system_clock::duration>(next)};
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::run() -> void
+    {
+        std::unique_lock<std::mutex> lock{segmentsMutex_};
+
+        while (true)
+        {
+            segmentsCondition_.wait(lock, [this]() { return !closedSegments_.empty() || !running_; });
+
+            // everything rotated before the shutdown is finished at this point
+            if (closedSegments_.empty())
+                break;
+
+            ClosedSegment segment = std::move(closedSegments_.front());
+            closedSegments_.pop_front();
+
+            lock.unlock();
+            finishSegment(segment);
+            lock.lock();
+
+            finishedCount_++;
+            segmentsCondition_.notify_all();
+        }
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::finishSegment(ClosedSegment& segment) -> void
+    {
+        // writes the remaining buffer and closes the descriptor
+        segment.file.reset();
+
+        if (rotationPolicy_.compression == SegmentCompression::Gzip)
+            compressSegment(getSegmentPath(segment.number));
+
+        if (segment.number <= rotationPolicy_.keptSegments)
+            return;
+
+        for (std::uint64_t expired = segment.number - rotationPolicy_.keptSegments; expired > 0; expired--)
+        {
+            if (!removeSegment(expired))
+                break;
+        }
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::compressSegment(const std::string& segmentPath) -> void
+    {
+#ifdef NEALOG_HAS_ZLIB
+        const std::string compressedPath = segmentPath + GZIP_SUFFIX;
+        const std::string incompletePath = compressedPath + INCOMPLETE_SUFFIX;
+
+        std::ifstream segment{segmentPath, std::ios::binary};
+        gzFile compressed = gzopen(incompletePath.c_str(), "wb");
+        if (!segment || compressed == nullptr)
+        {
+            if (compressed != nullptr)
+                gzclose(compressed);
+            return;
+        }
+
+        std::vector<char> chunk(COMPRESSION_CHUNK_SIZE);
+        bool failed = false;
+        while (!failed && (segment.read(chunk.data(), chunk.size()) || segment.gcount() > 0))
+        {
+            failed = gzwrite(compressed, chunk.data(), static_cast<unsigned>(segment.gcount())) == 0;
+        }
+
+        failed = gzclose(compressed) != Z_OK || failed;
+        segment.close();
+
+        std::error_code error;
+        if (failed)
+        {
+            std::filesystem::remove(incompletePath, error);
+            return;
+        }
+
+        // the segment only disappears once its compressed copy is complete
+        std::filesystem::rename(incompletePath, compressedPath, error);
+        if (!error)
+        {
+            std::filesystem::remove(segmentPath, error);
+            std::filesystem::remove(segmentPath + SIDECAR_INDEX_SUFFIX, error);
+        }
+#else
+        static_cast<void>(segmentPath);
+#endif
+    }
+
+
+
+    NL_INLINE auto RotatingFileSink::removeSegment(std::uint64_t segment) -> bool
+    {
+        const std::string segmentPath = getSegmentPath(segment);
+
+        std::error_code error;
+        const bool removedPlain      = std::filesystem::remove(segmentPath, error);
+        const bool removedCompressed = std::filesystem::remove(segmentPath + GZIP_SUFFIX, error);
+        std::filesystem::remove(segmentPath + SIDECAR_INDEX_SUFFIX, error);
+        return removedPlain || removedCompressed;
+    }
+
+    //}}}
+
 } // namespace nealog
@@ -0,0 +1,458 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/TcpSink.h"
+#endif // !NEALOG_HEADERONLY
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <iterator>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+#define NEALOG_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define NEALOG_SEND_FLAGS 0
+#endif
+
+
+namespace nealog
+{
+
+    // a sender waiting for a full socket checks this often whether it has to give up
+    constexpr int TCP_POLL_INTERVAL_MS = 100;
+
+    // the destruction waits at most this long for a peer not accepting data
+    constexpr std::chrono::milliseconds TCP_SHUTDOWN_SEND_TIMEOUT{1000};
+
+
+
+    /******************************
+     * TcpSink
+     ******************************/
+    // {{{
+
+    NL_INLINE TcpSink::TcpSink(const std::string& host, std::uint16_t port, TcpSinkPolicy policy)
+        : host_{host}, port_{port}, policy_{std::move(policy)}
+    {
+        if (policy_.overflow == TcpOverflow::Spill)
+            spill_ = std::make_unique<FileSink>(policy_.spillPath);
+
+        worker_ = std::thread(&TcpSink::run, this);
+    }
+
+
+
+    NL_INLINE TcpSink::~TcpSink()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            running_ = false;
+        }
+        pendingCondition_.notify_all();
+        sentCondition_.notify_all();
+        worker_.join();
+    }
+
+
+
+    NL_INLINE auto TcpSink::getType() -> SinkType
+    {
+        return SinkType::Tcp;
+    }
+
+
+
+    NL_INLINE auto TcpSink::write(Severity messageSeverity, std::string_view message) -> void
+    {
+        if (messageSeverity < severity_.load(std::memory_order_relaxed))
+            return;
+
+        std::unique_lock<std::mutex> lock{mutex_};
+        append(messageSeverity, message, lock);
+    }
+
+
+
+    NL_INLINE auto TcpSink::writeBatch(const SinkRecord* records, std::size_t count) -> void
+    {
+        const Severity sinkSeverity = severity_.load(std::memory_order_relaxed);
+
+        std::unique_lock<std::mutex> lock{mutex_};
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (records[i].severity >= sinkSeverity)
+                append(records[i].severity, records[i].message, lock);
+        }
+    }
+
+
+
+    NL_INLINE auto TcpSink::flush() -> void
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        const std::uint64_t flushedBytes = queuedBytes_;
+        if (sentBytes_ >= flushedBytes)
+            return;
+
+        flushRequested_ = true;
+        pendingCondition_.notify_one();
+        sentCondition_.wait(lock, [this, flushedBytes] {
+            return sentBytes_ >= flushedBytes || connectionDown_.load() || !running_.load();
+        });
+    }
+
+
+
+    NL_INLINE auto TcpSink::flushOnCrash(std::chrono::steady_clock::time_point deadline) -> void
+    {
+        // the sender keeps running, waiting on a condition could deadlock inside the signal handler
+        while (tryLockUntil(deadline))
+        {
+            const bool sent = sentBytes_ >= queuedBytes_;
+            flushRequested_ = true;
+            mutex_.unlock();
+
+            if (sent || connectionDown_.load() || std::chrono::steady_clock::now() >= deadline)
+                return;
+
+            pendingCondition_.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+
+
+    NL_INLINE auto TcpSink::getHost() const -> const std::string&
+    {
+        return host_;
+    }
+
+
+
+    NL_INLINE auto TcpSink::getPort() const noexcept -> std::uint16_t
+    {
+        return port_;
+    }
+
+
+
+    NL_INLINE auto TcpSink::isConnected() const noexcept -> bool
+    {
+        return connected_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto TcpSink::getConnectionCount() const noexcept -> std::size_t
+    {
+        return connectionCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto TcpSink::getDroppedCount() const noexcept -> std::size_t
+    {
+        return droppedCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto TcpSink::getSpilledCount() const noexcept -> std::size_t
+    {
+        return spilledCount_.load(std::memory_order_relaxed);
+    }
+
+
+
+    NL_INLINE auto TcpSink::append(Severity messageSeverity, std::string_view message,
+                                   std::unique_lock<std::mutex>& lock) -> void
+    {
+        // a message larger than the buffer still goes into an empty one
+        if (!pending_.empty() && pending_.size() + message.size() > policy_.bufferCapacity)
+        {
+            switch (policy_.overflow)
+            {
+            case TcpOverflow::Block:
+                sentCondition_.wait(lock, [this, &message] {
+                    return pending_.empty() || pending_.size() + message.size() <= policy_.bufferCapacity;
+                });
+                break;
+            case TcpOverflow::Drop:
+                droppedCount_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            case TcpOverflow::Spill:
+                spill_->write(messageSeverity, message);
+                spilledCount_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        // the sender is only woken for the first message of a batch and once half the buffer is taken
+        const std::size_t halfCapacity = policy_.bufferCapacity / 2;
+        const bool wakeSender =
+            pending_.empty() || (pending_.size() < halfCapacity && pending_.size() + message.size() >= halfCapacity);
+
+        pending_.append(message.data(), message.size());
+        pendingEnds_.push_back(pending_.size());
+        queuedBytes_ += message.size();
+
+        if (wakeSender)
+            pendingCondition_.notify_one();
+    }
+
+
+
+    NL_INLINE auto TcpSink::run() -> void
+    {
+        std::chrono::milliseconds reconnectDelay = policy_.minReconnectDelay;
+
+        std::unique_lock<std::mutex> lock{mutex_};
+        while (true)
+        {
+            if (batch_.empty())
+            {
+                pendingCondition_.wait(lock, [this] { return !pending_.empty() || !running_.load(); });
+                if (pending_.empty())
+                    break;
+
+                takePending(lock);
+            }
+
+            // the destruction makes no further attempt on a connection found down
+            if (!running_ && connectionDown_)
+                break;
+
+            lock.unlock();
+            const bool sent = sendBatch();
+            lock.lock();
+
+            if (sent)
+            {
+                sentBytes_ += batch_.size();
+                batch_.clear();
+                batchEnds_.clear();
+                batchSent_     = 0;
+                reconnectDelay = policy_.minReconnectDelay;
+                sentCondition_.notify_all();
+                continue;
+            }
+
+            // wakes flush(), which gives up on a connection found down
+            sentCondition_.notify_all();
+            if (!running_)
+                break;
+
+            pendingCondition_.wait_for(lock, reconnectDelay, [this] { return !running_.load(); });
+            reconnectDelay = std::min(reconnectDelay * 2, policy_.maxReconnectDelay);
+        }
+
+        closeSocket();
+        discardUnsent();
+    }
+
+
+
+    NL_INLINE auto TcpSink::takePending(std::unique_lock<std::mutex>& lock) -> void
+    {
+        if (policy_.batchDelay.count() > 0 && running_ && !flushRequested_)
+        {
+            pendingCondition_.wait_for(lock, policy_.batchDelay, [this] {
+                return flushRequested_ || !running_.load() || pending_.size() >= policy_.bufferCapacity / 2;
+            });
+        }
+
+        // the buffers keep their memory, so after the first batches none is allocated
+        batch_.swap(pending_);
+        batchEnds_.swap(pendingEnds_);
+        pending_.clear();
+        pendingEnds_.clear();
+        batchSent_      = 0;
+        flushRequested_ = false;
+
+        // wakes the writers blocked on a full buffer
+        sentCondition_.notify_all();
+    }
+
+
+
+    NL_INLINE auto TcpSink::connect() -> bool
+    {
+        addrinfo hints{};
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* addresses = nullptr;
+        if (::getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &addresses) != 0)
+        {
+            connectionDown_ = true;
+            return false;
+        }
+
+        for (const addrinfo* address = addresses; address != nullptr && socket_ < 0; address = address->ai_next)
+        {
+            const int fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (fd < 0)
+                continue;
+
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+            int result = ::connect(fd, address->ai_addr, address->ai_addrlen);
+            if (result != 0 && errno == EINPROGRESS)
+            {
+                pollfd connecting{fd, POLLOUT, 0};
+                int error         = 0;
+                socklen_t length  = sizeof(error);
+                const int timeout = static_cast<int>(policy_.connectTimeout.count());
+                if (::poll(&connecting, 1, timeout) == 1
+                    && ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0)
+                    result = 0;
+            }
+
+            if (result != 0)
+            {
+                ::close(fd);
+                continue;
+            }
+
+            // the batches are as large as they get, a partial one left waiting would only delay it
+            const int enabled = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+#ifdef SO_NOSIGPIPE
+            ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif // SO_NOSIGPIPE
+            socket_ = fd;
+        }
+        ::freeaddrinfo(addresses);
+
+        if (socket_ < 0)
+        {
+            connectionDown_ = true;
+            return false;
+        }
+
+        connected_      = true;
+        connectionDown_ = false;
+        connectionCount_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+
+
+    NL_INLINE auto TcpSink::sendBatch() -> bool
+    {
+        // a collector restarting closes the connection, sending into it would lose the first batch
+        if (socket_ >= 0 && isClosedByPeer())
+            closeSocket();
+
+        if (socket_ < 0 && !connect())
+            return false;
+
+        auto lastProgress = std::chrono::steady_clock::now();
+        while (batchSent_ < batch_.size())
+        {
+            const ssize_t written =
+                ::send(socket_, batch_.data() + batchSent_, batch_.size() - batchSent_, NEALOG_SEND_FLAGS);
+            if (written > 0)
+            {
+                batchSent_ += static_cast<std::size_t>(written);
+                lastProgress = std::chrono::steady_clock::now();
+                continue;
+            }
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                const auto timeout = running_ ? policy_.sendTimeout
+                                              : std::min(policy_.sendTimeout, TCP_SHUTDOWN_SEND_TIMEOUT);
+                if (std::chrono::steady_clock::now() - lastProgress < timeout)
+                {
+                    pollfd full{socket_, POLLOUT, 0};
+                    ::poll(&full, 1, TCP_POLL_INTERVAL_MS);
+                    continue;
+                }
+            }
+            break;
+        }
+
+        if (batchSent_ == batch_.size())
+            return true;
+
+        // the message cut off is sent again in full on the next connection
+        const auto cutEnd = std::upper_bound(batchEnds_.begin(), batchEnds_.end(), batchSent_);
+        batchSent_        = cutEnd == batchEnds_.begin() ? 0 : *std::prev(cutEnd);
+        closeSocket();
+        connectionDown_ = true;
+        return false;
+    }
+
+
+
+    NL_INLINE auto TcpSink::isClosedByPeer() const -> bool
+    {
+        pollfd readable{socket_, POLLIN, 0};
+        if (::poll(&readable, 1, 0) != 1)
+            return false;
+
+        char byte;
+        const ssize_t received = ::recv(socket_, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        return received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+    }
+
+
+
+    NL_INLINE auto TcpSink::closeSocket() -> void
+    {
+        if (socket_ < 0)
+            return;
+
+        ::close(socket_);
+        socket_    = -1;
+        connected_ = false;
+    }
+
+
+
+    NL_INLINE auto TcpSink::discardUnsent() -> void
+    {
+        const auto discard = [this](const std::string& buffer, const std::vector<std::size_t>& ends,
+                                    std::size_t begin) {
+            for (const std::size_t end : ends)
+            {
+                if (end <= begin)
+                    continue;
+
+                if (spill_)
+                {
+                    spill_->write(Severity::Trace, {buffer.data() + begin, end - begin});
+                    spilledCount_.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    droppedCount_.fetch_add(1, std::memory_order_relaxed);
+                }
+                begin = end;
+            }
+        };
+
+        discard(batch_, batchEnds_, batchSent_);
+        discard(pending_, pendingEnds_, 0);
+        batch_.clear();
+        batchEnds_.clear();
+        pending_.clear();
+        pendingEnds_.clear();
+    }
+    // }}}
+
+} // namespace nealog
+
+#endif // !_WIN32
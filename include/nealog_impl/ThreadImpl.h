@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef NEALOG_HEADERONLY
+#include "nealog/Thread.h"
+#endif // !NEALOG_HEADERONLY
+
+#include <deque>
+#include <fmt/format.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+
+namespace nealog
+{
+
+    NL_INLINE auto readThreadId() noexcept -> std::uint64_t
+    {
+#if defined(__linux__)
+        return static_cast<std::uint64_t>(::syscall(SYS_gettid));
+#elif defined(__APPLE__)
+        std::uint64_t id = 0;
+        ::pthread_threadid_np(nullptr, &id);
+        return id;
+#else
+        return static_cast<std::uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#endif
+    }
+
+
+
+    struct CurrentThread
+    {
+        ThreadIdentity identity{readThreadId()};
+        fmt::format_int idText{identity.id};
+    };
+
+    NL_INLINE auto currentThread() noexcept -> CurrentThread&
+    {
+        thread_local CurrentThread thread;
+        return thread;
+    }
+
+
+
+    NL_INLINE auto getCurrentThread() noexcept -> const ThreadIdentity&
+    {
+        return currentThread().identity;
+    }
+
+
+
+    NL_INLINE auto getCurrentThreadIdText() noexcept -> std::string_view
+    {
+        const fmt::format_int& idText = currentThread().idText;
+        return {idText.data(), idText.size()};
+    }
+
+
+
+    NL_INLINE auto setThreadName(std::string_view name) -> void
+    {
+        // never shrinks, records in queues may point into any of the names
+        static std::mutex namesMutex;
+        static std::deque<std::string> names;
+
+        std::lock_guard<std::mutex> lock{namesMutex};
+        currentThread().identity.name = names.emplace_back(name);
+    }
+
+} // namespace nealog
@@ -0,0 +1 @@
+#include "nealog_impl/ConcurrentLoggerRegistryImpl.h"
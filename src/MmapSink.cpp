@@ -0,0 +1 @@
+#include "nealog_impl/MmapSinkImpl.h"
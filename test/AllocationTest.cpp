@@ -0,0 +1,138 @@
+#include "nealog/Logger.h"
+#include "TestApi.h"
+#include "nealog/Sink.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[Logger][Allocation]";
+
+
+
+// Counts every allocation made through the global operator new on the current thread.
+thread_local std::size_t allocationCount = 0;
+
+auto operator new(std::size_t size) -> void*
+{
+    allocationCount++;
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+// GCC pairs the free() below with the new expressions inlined into the
+// callers and warns, not seeing that operator new above took it from malloc()
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+auto operator delete(void* memory) noexcept -> void
+{
+    std::free(memory);
+}
+
+auto operator delete(void* memory, std::size_t) noexcept -> void
+{
+    std::free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+
+
+/*!
+ * Keeps the last message in a string with reserved capacity.
+ */
+class LastMessageSink : public NoopSink
+{
+  public:
+    LastMessageSink()
+    {
+        lastMessage.reserve(4096);
+    }
+
+    auto write(Severity, std::string_view message) -> void override
+    {
+        lastMessage.assign(message.data(), message.size());
+    }
+
+    std::string lastMessage{};
+};
+
+
+
+TEST_CASE("allocation counter sees heap allocations", TAG)
+{
+    allocationCount = 0;
+    auto value      = std::make_unique<std::string>(100, 'x');
+    CHECK(allocationCount >= 1);
+}
+
+
+
+TEST_CASE("logging through a warmed up thread does not allocate", TAG)
+{
+    Logger logger{"allocation"};
+    auto sink = std::make_shared<LastMessageSink>();
+    logger.addSink(sink);
+    logger.setFormatter(PatternFormatter{"[%(message)]"});
+
+    const std::string longMessage(2000, 'x');
+
+    // warm up the thread local buffer
+    logger.info(longMessage);
+
+    allocationCount = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        logger.info("short message");
+        logger.warn("value {} of {}", i, "loop");
+        logger.error(longMessage);
+    }
+    const std::size_t allocations = allocationCount;
+
+    requireResultEqualsExpected(allocations, 0u);
+    requireResultEqualsExpected(sink->lastMessage, "[" + longMessage + "]");
+}
+
+
+
+TEST_CASE("a sink logging from inside write gets its own buffer", TAG)
+{
+    class ReentrantSink : public LastMessageSink
+    {
+      public:
+        ReentrantSink(Logger& nestedLogger) : nestedLogger_{nestedLogger}
+        {
+        }
+
+        auto write(Severity severity, std::string_view message) -> void override
+        {
+            nestedLogger_.info("nested");
+            LastMessageSink::write(severity, message);
+        }
+
+      private:
+        Logger& nestedLogger_;
+    };
+
+    Logger nestedLogger{"nested"};
+    auto nestedSink = std::make_shared<LastMessageSink>();
+    nestedLogger.addSink(nestedSink);
+
+    Logger logger{"outer"};
+    auto sink = std::make_shared<ReentrantSink>(nestedLogger);
+    logger.addSink(sink);
+
+    logger.info("outer");
+
+    requireResultEqualsExpected(sink->lastMessage, "outer");
+    requireResultEqualsExpected(nestedSink->lastMessage, "nested");
+}
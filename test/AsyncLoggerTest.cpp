@@ -0,0 +1,270 @@
+#include "nealog/AsyncLogger.h"
+#include "TestApi.h"
+#include "nealog/Sink.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <fmt/chrono.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[AsyncLogger]";
+constexpr const char* TAG_THREADING = "[AsyncLogger][Multithreading]";
+
+
+
+/*!
+ * Sink that takes its time for every message to simulate a slow output.
+ */
+class SlowSink : public StreamSink
+{
+  public:
+    using StreamSink::StreamSink;
+
+    auto write(Severity severity, std::string_view message) -> void override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        StreamSink::write(severity, message);
+    }
+
+    auto writeBatch(const SinkRecord* records, std::size_t count) -> void override
+    {
+        // one message after the other, each taking its time
+        Sink::writeBatch(records, count);
+    }
+};
+
+
+
+/*!
+ * Sink recording how many records every batch it got had.
+ */
+class BatchCountingSink : public StreamSink
+{
+  public:
+    using StreamSink::StreamSink;
+
+    auto writeBatch(const SinkRecord* records, std::size_t count) -> void override
+    {
+        batchSizes.push_back(count);
+        StreamSink::writeBatch(records, count);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+  public:
+    std::vector<std::size_t> batchSizes;
+};
+
+
+
+/*!
+ * Sink throwing on a message it cannot write.
+ */
+class ThrowingSink : public StreamSink
+{
+  public:
+    using StreamSink::StreamSink;
+
+    auto write(Severity severity, std::string_view message) -> void override
+    {
+        if (message == "bad")
+            throw std::runtime_error{"cannot write"};
+        StreamSink::write(severity, message);
+    }
+
+    auto writeBatch(const SinkRecord* records, std::size_t count) -> void override
+    {
+        Sink::writeBatch(records, count);
+    }
+};
+
+
+
+TEST_CASE("flush writes all enqueued messages to the sinks", TAG)
+{
+    std::ostringstream stream;
+    AsyncLogger logger{"async"};
+    logger.addSink(SinkFactory::createStreamSink(stream));
+
+    logger.info("Hello ");
+    logger.warn("world");
+    logger.flush();
+
+    requireResultEqualsExpected(stream.str(), "Hello world");
+}
+
+
+
+TEST_CASE("destroying the logger drains the queue", TAG)
+{
+    std::ostringstream stream;
+    {
+        AsyncLogger logger{"async"};
+        logger.addSink(std::make_shared<SlowSink>(stream));
+
+        for (int i = 0; i < 10; i++)
+            logger.info("x");
+    }
+
+    requireResultEqualsExpected(stream.str(), "xxxxxxxxxx");
+}
+
+
+
+TEST_CASE("queued messages are written to the sinks in batches", TAG)
+{
+    std::ostringstream stream;
+    auto sink = std::make_shared<BatchCountingSink>(stream);
+    std::string expected;
+    {
+        AsyncLogger logger{"async"};
+        logger.addSink(sink);
+
+        for (int i = 0; i < 1000; i++)
+        {
+            logger.info(std::to_string(i));
+            expected += std::to_string(i);
+        }
+    }
+
+    requireResultEqualsExpected(stream.str(), expected);
+    REQUIRE(sink->batchSizes.size() < 1000);
+    for (std::size_t batchSize : sink->batchSizes)
+        REQUIRE(batchSize <= AsyncLogger::WRITE_BATCH_SIZE);
+}
+
+
+
+TEST_CASE("messages below the logger severity are not enqueued", TAG)
+{
+    std::ostringstream stream;
+    AsyncLogger logger{"async"};
+    logger.addSink(SinkFactory::createStreamSink(stream));
+    logger.setSeverity(Severity::Warn);
+
+    logger.info("info");
+    logger.error("error");
+    logger.flush();
+
+    requireResultEqualsExpected(stream.str(), "error");
+}
+
+
+
+TEST_CASE("Drop policy discards messages when the queue is full", TAG)
+{
+    std::ostringstream stream;
+    AsyncLogger logger{"async", 2, OverflowPolicy::Drop};
+    logger.addSink(std::make_shared<SlowSink>(stream));
+
+    for (int i = 0; i < 100; i++)
+        logger.info("x");
+    logger.flush();
+
+    CHECK(logger.getDroppedCount() > 0);
+    requireResultEqualsExpected(stream.str().size() + logger.getDroppedCount(), 100u);
+}
+
+
+
+TEST_CASE("log from different threads without missing a message", TAG_THREADING)
+{
+    constexpr int MESSAGES_PER_THREAD = 1000;
+    std::stringstream stream;
+    AsyncLogger logger{"async", 16};
+    logger.addSink(SinkFactory::createStreamSink(stream));
+
+    auto logMessages = [&logger]() {
+        for (int i = 0; i < MESSAGES_PER_THREAD; i++)
+            logger.info("Message\n");
+    };
+
+    std::thread firstThread(logMessages);
+    std::thread secondThread(logMessages);
+    firstThread.join();
+    secondThread.join();
+    logger.flush();
+
+    std::string currentLine;
+    int lines = 0;
+    while (std::getline(stream, currentLine, '\n'))
+        lines++;
+
+    requireResultEqualsExpected(lines, MESSAGES_PER_THREAD * 2);
+}
+
+
+
+TEST_CASE("arguments are captured on the caller and formatted by the worker", TAG)
+{
+    std::ostringstream stream;
+    AsyncLogger logger{"async"};
+    logger.addSink(SinkFactory::createStreamSink(stream));
+    logger.setFormatter(PatternFormatter{"[%(message)]"});
+
+    {
+        std::string temporary{"gone"};
+        logger.info("{} is {}", temporary, 42);
+    }
+    logger.flush();
+
+    requireResultEqualsExpected(stream.str(), "[gone is 42]");
+}
+
+
+
+TEST_CASE("the worker formats floats and format specs of user types like the caller", TAG)
+{
+    std::ostringstream stream;
+    AsyncLogger logger{"async"};
+    logger.addSink(SinkFactory::createStreamSink(stream));
+    logger.setFormatter(PatternFormatter{"[%(message)]"});
+
+    logger.info("t={:%S}", std::chrono::seconds{5});
+    logger.info("ratio {}", 0.1f);
+    logger.flush();
+
+    requireResultEqualsExpected(stream.str(), "[t=05][ratio 0.1]");
+}
+
+
+
+TEST_CASE("a throwing sink costs its batch but not the worker", TAG)
+{
+    std::ostringstream stream;
+    AsyncLogger logger{"async"};
+    logger.addSink(std::make_shared<ThrowingSink>(stream));
+
+    logger.info("bad");
+    logger.flush();
+    requireResultEqualsExpected(logger.getFailedCount(), std::size_t{1});
+
+    logger.info("good");
+    logger.flush();
+    requireResultEqualsExpected(stream.str(), "good");
+    requireResultEqualsExpected(logger.getFailedCount(), std::size_t{1});
+}
+
+
+
+TEST_CASE("pattern shows the thread and call site of the producer", TAG)
+{
+    std::ostringstream stream;
+    AsyncLogger logger{"async.producer"};
+    logger.addSink(SinkFactory::createStreamSink(stream));
+    logger.setFormatter(PatternFormatter{"%(thread.name) %(logger) %(SEVERITY) %(file) %(message)"});
+
+    std::thread producer{[&logger]() {
+        static constexpr SourceLocation location{"producer.cpp", 1, "run"};
+        setThreadName("producer");
+        logger.logAt<Severity::Warn>(location, "from {}", "thread");
+    }};
+    producer.join();
+    logger.flush();
+
+    requireResultEqualsExpected(stream.str(), "producer async.producer WARN producer.cpp from thread");
+}
@@ -0,0 +1,261 @@
+#include "nealog/AsyncLogger.h"
+#include "nealog/BinaryFileSink.h"
+#include "nealog/Logger.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fmt/chrono.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[Sink][BinaryFileSink]";
+
+
+
+struct DecodedRecord
+{
+    std::chrono::system_clock::time_point timestamp;
+    Severity severity;
+    std::string loggerName;
+    std::string message;
+};
+
+
+
+class BinaryFileSinkTestFixture
+{
+  public:
+    BinaryFileSinkTestFixture()
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~BinaryFileSinkTestFixture()
+    {
+        std::filesystem::remove(path);
+    }
+
+    auto readRecords() const -> std::vector<DecodedRecord>
+    {
+        std::ifstream file{path, std::ios::binary};
+        BinaryLogReader reader{file};
+        BinaryLogEntry entry;
+
+        std::vector<DecodedRecord> records;
+        while (reader.next(entry))
+        {
+            fmt::memory_buffer message;
+            entry.formatMessage(message);
+            records.push_back(
+                {entry.timestamp, entry.severity, std::string{entry.loggerName}, fmt::to_string(message)});
+        }
+        return records;
+    }
+
+  public:
+    std::string path = (std::filesystem::temp_directory_path() / "nealog_binary_file_sink_test.nlb").string();
+};
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "records decode to the messages a text sink gets", TAG)
+{
+    std::ostringstream stream;
+    {
+        Logger logger{"svc.db"};
+        auto sink = std::make_shared<BinaryFileSink>(path);
+        requireResultEqualsExpected(sink->getType(), SinkType::BinaryFile);
+
+        logger.addSink(sink);
+        logger.addSink(SinkFactory::createStreamSink(stream));
+
+        logger.info("pool resized to {} connections", 32);
+        logger.warn("plain message");
+        logger.error("{} {} {} {}", true, 'c', 1.5, -7);
+    }
+
+    auto records = readRecords();
+    REQUIRE(records.size() == 3);
+    REQUIRE(records[0].message == "pool resized to 32 connections");
+    REQUIRE(records[1].message == "plain message");
+    REQUIRE(records[2].message == "true c 1.5 -7");
+    REQUIRE(stream.str() == records[0].message + records[1].message + records[2].message);
+
+    requireResultEqualsExpected(records[0].severity, Severity::Info);
+    requireResultEqualsExpected(records[1].severity, Severity::Warn);
+    requireResultEqualsExpected(records[2].severity, Severity::Error);
+    for (const DecodedRecord& record : records)
+        REQUIRE(record.loggerName == "svc.db");
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "records keep the time of the log call", TAG)
+{
+    const auto before = std::chrono::system_clock::now();
+    {
+        BinaryFileSink sink{path};
+        Record record;
+        record.capture(Severity::Info, "{}", 1);
+        sink.writeRecord(record, "timed");
+    }
+    const auto after = std::chrono::system_clock::now();
+
+    auto records = readRecords();
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0].timestamp >= before);
+    REQUIRE(records[0].timestamp <= after);
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "format strings and logger names are written once", TAG)
+{
+    Logger logger{"svc.db"};
+    auto sink = std::make_shared<BinaryFileSink>(path);
+    logger.addSink(sink);
+    sink->flush();
+
+    auto sizeAfterLogging = [&]() {
+        logger.info("pool resized to {} connections", 32);
+        sink->flush();
+        return std::filesystem::file_size(path);
+    };
+
+    const auto sessionSize = std::filesystem::file_size(path);
+    const auto firstSize   = sizeAfterLogging() - sessionSize;
+    const auto secondSize  = sizeAfterLogging() - sessionSize - firstSize;
+
+    REQUIRE(secondSize < firstSize);
+    REQUIRE(secondSize < std::string_view{"pool resized to 32 connections"}.size());
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "message formatted on capture is decoded as well", TAG)
+{
+    const std::string longArgument(Record::ARGUMENT_CAPACITY, 'x');
+    {
+        Logger logger{"eager"};
+        logger.addSink(std::make_shared<BinaryFileSink>(path));
+        logger.info("long {}", longArgument);
+    }
+
+    auto records = readRecords();
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0].message == "long " + longArgument);
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "floats and format specs of user types decode like the call", TAG)
+{
+    {
+        Logger logger{"types"};
+        logger.addSink(std::make_shared<BinaryFileSink>(path));
+        logger.info("ratio {}", 0.1f);
+        logger.info("t={:%S}", std::chrono::seconds{5});
+    }
+
+    auto records = readRecords();
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].message == "ratio 0.1");
+    REQUIRE(records[1].message == "t=05");
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "calls with fields are stored formatted", TAG)
+{
+    {
+        Logger logger{"svc.api"};
+        logger.addSink(std::make_shared<BinaryFileSink>(path));
+        logger.info("request {} done", 7, kv("user", "bob"), kv("ms", 12));
+    }
+
+    auto records = readRecords();
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0].message == "request 7 done user=bob ms=12");
+    REQUIRE(records[0].loggerName == "svc.api");
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "appending to a file starts a new session", TAG)
+{
+    {
+        BinaryFileSink sink{path};
+        sink.write(Severity::Info, "first");
+    }
+    {
+        BinaryFileSink sink{path};
+        sink.write(Severity::Info, "second");
+    }
+
+    auto records = readRecords();
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].message == "first");
+    REQUIRE(records[1].message == "second");
+    REQUIRE(records[1].loggerName.empty());
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "messages below the sink severity are not written", TAG)
+{
+    {
+        BinaryFileSink sink{path};
+        sink.setSeverity(Severity::Warn);
+        sink.write(Severity::Info, "info");
+        sink.write(Severity::Warn, "warn");
+    }
+
+    auto records = readRecords();
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0].message == "warn");
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "AsyncLogger hands its records to a BinaryFileSink", TAG)
+{
+    {
+        AsyncLogger logger{"async"};
+        logger.addSink(std::make_shared<BinaryFileSink>(path));
+
+        for (int i = 0; i < 100; i++)
+            logger.info("message {}", i);
+    }
+
+    auto records = readRecords();
+    REQUIRE(records.size() == 100);
+    for (int i = 0; i < 100; i++)
+        REQUIRE(records[i].message == "message " + std::to_string(i));
+}
+
+
+
+TEST_CASE_METHOD(BinaryFileSinkTestFixture, "malformed input throws", TAG)
+{
+    {
+        BinaryFileSink sink{path};
+        sink.write(Severity::Info, "complete record");
+    }
+
+    SECTION("truncated record")
+    {
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+        REQUIRE_THROWS_AS(readRecords(), BinaryLogFormatException);
+    }
+
+    SECTION("no binary log at all")
+    {
+        std::ofstream{path, std::ios::binary | std::ios::trunc} << "plain text log";
+        REQUIRE_THROWS_AS(readRecords(), BinaryLogFormatException);
+    }
+}
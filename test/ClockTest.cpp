@@ -0,0 +1,101 @@
+#include "nealog/Clock.h"
+#include "nealog/Logger.h"
+#include "nealog/Record.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdlib>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[Clock]";
+
+// the coarse clock lags by up to a kernel tick, the TSC drifts a little between anchors
+constexpr std::chrono::milliseconds TOLERANCE{50};
+
+
+
+class ClockTestFixture
+{
+  public:
+    ~ClockTestFixture()
+    {
+        setClockSource(ClockSource::Standard);
+    }
+
+    static auto isCloseToSystemClock(std::chrono::system_clock::time_point timestamp) -> bool
+    {
+        const auto difference = timestamp - std::chrono::system_clock::now();
+        return difference < TOLERANCE && difference > -TOLERANCE;
+    }
+};
+
+
+
+TEST_CASE_METHOD(ClockTestFixture, "standard clock is the default and always supported", TAG)
+{
+    REQUIRE(getClockSource() == ClockSource::Standard);
+    REQUIRE(isClockSourceSupported(ClockSource::Standard));
+    REQUIRE(isCloseToSystemClock(captureTimestamp()));
+}
+
+
+
+TEST_CASE_METHOD(ClockTestFixture, "every supported clock source is close to the system clock", TAG)
+{
+    for (ClockSource source : {ClockSource::Standard, ClockSource::RealtimeCoarse, ClockSource::Tsc})
+    {
+        if (!isClockSourceSupported(source))
+            continue;
+
+        REQUIRE(setClockSource(source));
+        REQUIRE(getClockSource() == source);
+
+        for (int i = 0; i < 1000; i++)
+            REQUIRE(isCloseToSystemClock(captureTimestamp()));
+    }
+}
+
+
+
+TEST_CASE_METHOD(ClockTestFixture, "unsupported clock source falls back to the standard clock", TAG)
+{
+    for (ClockSource source : {ClockSource::RealtimeCoarse, ClockSource::Tsc})
+    {
+        if (isClockSourceSupported(source))
+            continue;
+
+        setClockSource(ClockSource::RealtimeCoarse);
+        REQUIRE_FALSE(setClockSource(source));
+        REQUIRE(getClockSource() == ClockSource::Standard);
+    }
+}
+
+
+
+TEST_CASE_METHOD(ClockTestFixture, "TSC timestamps do not go backwards within a thread", TAG)
+{
+    // nothing to check without an invariant TSC
+    if (!setClockSource(ClockSource::Tsc))
+        return;
+
+    auto previous = captureTimestamp();
+    for (int i = 0; i < 100000; i++)
+    {
+        const auto timestamp = captureTimestamp();
+        REQUIRE(timestamp >= previous - std::chrono::microseconds{100});
+        previous = timestamp;
+    }
+}
+
+
+
+TEST_CASE_METHOD(ClockTestFixture, "records are stamped by the selected clock", TAG)
+{
+    const ClockSource source = isClockSourceSupported(ClockSource::RealtimeCoarse) ? ClockSource::RealtimeCoarse
+                                                                                  : ClockSource::Standard;
+    setClockSource(source);
+
+    Record record;
+    record.capture(Severity::Info, "{}", 1);
+    REQUIRE(isCloseToSystemClock(record.getTimestamp()));
+}
@@ -0,0 +1,103 @@
+#include "nealog/ConcurrentLoggerRegistry.h"
+#include "TestApi.h"
+#include "nealog/Sink.h"
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[ConcurrentLoggerRegistry]";
+constexpr const char* TAG_THREADING = "[ConcurrentLoggerRegistry][Multithreading]";
+
+
+
+TEST_CASE("root logger exists from the start", TAG)
+{
+    ConcurrentLoggerRegistry registry;
+    requirePointerNotNull(registry.getOrCreate("").get());
+}
+
+
+
+TEST_CASE("same name returns the same logger", TAG)
+{
+    ConcurrentLoggerRegistry registry;
+    auto logger = registry.getOrCreate("svc.db");
+
+    requireResultEqualsExpected(registry.getOrCreate(std::string{"svc.db"}), logger);
+    requireResultEqualsExpected(&registry.getOrCreateReference("svc.db"), logger.get());
+}
+
+
+
+TEST_CASE("different names return different loggers", TAG)
+{
+    ConcurrentLoggerRegistry registry;
+    auto first  = registry.getOrCreate("svc.db");
+    auto second = registry.getOrCreate("svc.dc");
+    auto third  = registry.getOrCreate("svc");
+
+    CHECK(first != second);
+    CHECK(first != third);
+    CHECK(second != third);
+}
+
+
+
+TEST_CASE("creating a logger creates its parents", TAG)
+{
+    std::ostringstream stream;
+    ConcurrentLoggerRegistry registry;
+    auto logger = registry.getOrCreate("appbar.menu.about");
+
+    registry.getOrCreate("appbar")->addSink(SinkFactory::createStreamSink(stream));
+    logger->info("from about");
+
+    requireResultEqualsExpected(stream.str(), "from about");
+}
+
+
+
+TEST_CASE("a node keeps many children in the order they were created", TAG)
+{
+    ConcurrentLoggerRegistry registry;
+    std::vector<LoggerBase*> created;
+    for (int i = 0; i < 1000; i++)
+        created.push_back(&registry.getOrCreateReference("conn." + std::to_string(i)));
+
+    for (int i = 0; i < 1000; i++)
+        REQUIRE(&registry.getOrCreateReference("conn." + std::to_string(i)) == created[i]);
+
+    std::vector<LoggerBase*> visited;
+    registry.forEachLogger([&visited](LoggerBase& logger) { visited.push_back(&logger); });
+    REQUIRE(visited.size() == 1002);
+    REQUIRE(std::vector<LoggerBase*>(visited.begin() + 2, visited.end()) == created);
+}
+
+
+
+TEST_CASE("create and look up loggers on multiple threads", TAG_THREADING)
+{
+    constexpr int LOGGERS = 200;
+    ConcurrentLoggerRegistry registry;
+
+    auto createAll = [&registry](std::vector<LoggerBase*>& created) {
+        for (int i = 0; i < LOGGERS; i++)
+        {
+            const std::string name = "com.app" + std::to_string(i % 20) + ".l" + std::to_string(i);
+            created.push_back(registry.getOrCreate(name).get());
+        }
+    };
+
+    std::vector<LoggerBase*> first;
+    std::vector<LoggerBase*> second;
+    std::thread threadOne(createAll, std::ref(first));
+    std::thread threadTwo(createAll, std::ref(second));
+    threadOne.join();
+    threadTwo.join();
+
+    requireResultEqualsExpected(first, second);
+}
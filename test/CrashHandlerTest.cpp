@@ -0,0 +1,207 @@
+#include "nealog/AsyncLogger.h"
+#include "nealog/ConcurrentLoggerRegistry.h"
+#include "nealog/CrashHandler.h"
+#include "nealog/Logger.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace nealog;
+
+constexpr const char* TAG = "[CrashHandler]";
+
+constexpr FileFlushPolicy NEVER_FLUSH{std::chrono::milliseconds{0}, Severity::Fatal};
+
+
+
+/*!
+ * Counts the flushes, its mutex can be held like by a crashed thread.
+ */
+class CountingSink : public Sink
+{
+  public:
+    auto getType() -> SinkType override
+    {
+        return SinkType::Noop;
+    }
+
+    auto write(Severity, std::string_view) -> void override
+    {
+    }
+
+    auto flush() -> void override
+    {
+        flushCount++;
+    }
+
+    auto getMutex() -> std::mutex&
+    {
+        return mutex_;
+    }
+
+  protected:
+    auto flushLocked() -> void override
+    {
+        flushCount++;
+    }
+
+  public:
+    std::atomic<int> flushCount{0};
+};
+
+
+
+class CrashHandlerTestFixture : public TemporaryDirectoryFixture
+{
+  public:
+    CrashHandlerTestFixture() : TemporaryDirectoryFixture{"nealog_crash_handler_test"}
+    {
+    }
+
+    ~CrashHandlerTestFixture()
+    {
+        uninstallCrashHandler();
+    }
+};
+
+
+
+TEST_CASE("fatal calls flush before they return", TAG)
+{
+    auto sink = std::make_shared<CountingSink>();
+    Logger logger{"svc"};
+    logger.addSink(sink);
+
+    logger.error("error {}", 1);
+    logger.error("error");
+    REQUIRE(sink->flushCount == 0);
+
+    logger.fatal("fatal {}", 1);
+    REQUIRE(sink->flushCount == 1);
+    logger.fatal("fatal");
+    REQUIRE(sink->flushCount == 2);
+}
+
+
+
+TEST_CASE("fatal calls of an AsyncLogger are written before they return", TAG)
+{
+    std::ostringstream stream;
+    AsyncLogger logger{"async"};
+    logger.addSink(SinkFactory::createStreamSink(stream));
+
+    logger.info("before");
+    logger.fatal("fatal {}", 1);
+    requireResultEqualsExpected(stream.str(), "beforefatal 1");
+}
+
+
+
+TEST_CASE_METHOD(CrashHandlerTestFixture, "the crash flush writes the buffers of the registry's loggers", TAG)
+{
+    ConcurrentLoggerRegistry registry;
+    registry.getOrCreate("svc.db")->addSink(SinkFactory::createFileSink(path, NEVER_FLUSH));
+    registry.getOrCreate("svc.db")->error("connection lost");
+    REQUIRE(readFile(path).empty());
+
+    installCrashHandler(registry);
+    flushForCrash();
+    requireResultEqualsExpected(readFile(path), "connection lost");
+}
+
+
+
+TEST_CASE_METHOD(CrashHandlerTestFixture, "watched loggers are drained and flushed", TAG)
+{
+    auto sink = std::make_shared<CountingSink>();
+    Logger logger{"standalone"};
+    logger.addSink(sink);
+
+    REQUIRE(watchForCrash(logger));
+    flushForCrash();
+    REQUIRE(sink->flushCount == 1);
+
+    unwatchForCrash(logger);
+    flushForCrash();
+    REQUIRE(sink->flushCount == 1);
+
+    {
+        AsyncLogger asyncLogger{"async", AsyncLogger::DEFAULT_QUEUE_CAPACITY};
+        asyncLogger.addSink(SinkFactory::createFileSink(path, NEVER_FLUSH));
+        for (int i = 0; i < 1000; i++)
+            asyncLogger.info("message {}\n", i);
+
+        flushForCrash();
+        const std::string content = readFile(path);
+        REQUIRE(content.rfind("message 999\n") == content.size() - 12);
+    }
+}
+
+
+
+TEST_CASE("a sink locked until the deadline is skipped", TAG)
+{
+    CountingSink sink;
+    std::lock_guard<std::mutex> lock{sink.getMutex()};
+
+    const auto start = std::chrono::steady_clock::now();
+    sink.flushOnCrash(start + std::chrono::milliseconds{20});
+
+    REQUIRE(sink.flushCount == 0);
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds{20});
+}
+
+
+
+#ifndef _WIN32
+TEST_CASE_METHOD(CrashHandlerTestFixture, "a crashing process writes its buffered messages and dies of the signal",
+                 TAG)
+{
+    for (int signalNumber : {SIGSEGV, SIGABRT})
+    {
+        std::filesystem::remove(path);
+
+        const pid_t child = ::fork();
+        REQUIRE(child >= 0);
+        if (child == 0)
+        {
+            // the handler of Catch would report the crash as failure of the child
+            std::signal(signalNumber, SIG_DFL);
+
+            ConcurrentLoggerRegistry registry;
+            registry.getOrCreate("svc")->addSink(SinkFactory::createFileSink(path, NEVER_FLUSH));
+            installCrashHandler(registry);
+
+            AsyncLogger logger{"async"};
+            logger.addSink(SinkFactory::createFileSink(path, NEVER_FLUSH));
+            logger.info("queued\n");
+            registry.getOrCreate("svc")->info("buffered\n");
+
+            if (signalNumber == SIGABRT)
+                std::abort();
+            std::raise(signalNumber);
+            ::_exit(0);
+        }
+
+        int status = 0;
+        REQUIRE(::waitpid(child, &status, 0) == child);
+        REQUIRE(WIFSIGNALED(status));
+        REQUIRE(WTERMSIG(status) == signalNumber);
+
+        const std::string content = readFile(path);
+        REQUIRE(content.find("queued\n") != std::string::npos);
+        REQUIRE(content.find("buffered\n") != std::string::npos);
+    }
+}
+#endif // !_WIN32
@@ -0,0 +1,276 @@
+#include "nealog/AsyncLogger.h"
+#include "nealog/DedupSink.h"
+#include "nealog/JsonSink.h"
+#include "nealog/Logger.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[Sink][DedupSink]";
+
+constexpr DedupPolicy LONG_WINDOW{std::chrono::seconds{60}, 1024};
+
+
+
+class DedupSinkTestFixture
+{
+  public:
+    auto createLogger(DedupPolicy policy, const std::string& name = "svc") -> std::shared_ptr<Logger>
+    {
+        sink = std::make_shared<DedupSink>(SinkFactory::createStreamSink(stream), policy,
+                                           PatternFormatter{"%(logger) %(message)\n"});
+        auto logger = std::make_shared<Logger>(name);
+        // the time in the pattern of the logger does not keep repeats apart
+        logger->setFormatter(PatternFormatter{"%(time.ns) %(message)\n"});
+        logger->addSink(sink);
+        return logger;
+    }
+
+  public:
+    std::ostringstream stream;
+    std::shared_ptr<DedupSink> sink;
+};
+
+
+
+TEST_CASE_METHOD(DedupSinkTestFixture, "repeats within the window are written as one line", TAG)
+{
+    auto logger = createLogger(LONG_WINDOW);
+
+    for (int i = 0; i < 5; i++)
+        logger->warn("retrying {}", "db");
+    logger->warn("giving up");
+    requireResultEqualsExpected(stream.str(), "svc retrying db\nsvc giving up\n");
+
+    logger->flush();
+    requireResultEqualsExpected(stream.str(), "svc retrying db\nsvc giving up\nsvc repeated 4 times: retrying db\n");
+    REQUIRE(sink->getCollapsedCount() == 4);
+
+    logger->warn("retrying {}", "db");
+    requireResultEqualsExpected(stream.str(), "svc retrying db\nsvc giving up\nsvc repeated 4 times: retrying db\n"
+                                              "svc retrying db\n");
+}
+
+
+
+TEST_CASE_METHOD(DedupSinkTestFixture, "a call after the window closes it", TAG)
+{
+    auto logger = createLogger({std::chrono::milliseconds{20}, 1024});
+
+    logger->info("busy");
+    logger->info("busy");
+    logger->info("busy");
+    std::this_thread::sleep_for(std::chrono::milliseconds{40});
+    logger->info("idle");
+    logger->info("busy");
+
+    requireResultEqualsExpected(stream.str(), "svc busy\nsvc repeated 2 times: busy\nsvc idle\nsvc busy\n");
+}
+
+
+
+/*!
+ * Target whose lines can be read while the thread of the DedupSink writes.
+ */
+class LockedSink : public Sink
+{
+  public:
+    auto getType() -> SinkType override
+    {
+        return SinkType::Noop;
+    }
+
+    auto write(Severity, std::string_view message) -> void override
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        lines_.append(message);
+    }
+
+    auto flush() -> void override
+    {
+    }
+
+    auto getLines() -> std::string
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return lines_;
+    }
+
+  private:
+    std::string lines_;
+};
+
+
+
+TEST_CASE("a window closes at its end without a further call", TAG)
+{
+    auto target = std::make_shared<LockedSink>();
+    DedupSink sink{target, {std::chrono::milliseconds{20}, 1024}, PatternFormatter{"%(message)\n"}};
+
+    sink.write(Severity::Warn, "busy");
+    sink.write(Severity::Warn, "busy");
+    sink.write(Severity::Warn, "busy");
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (target->getLines() == "busy\n" && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds{5});
+
+    requireResultEqualsExpected(target->getLines(), "busy\nrepeated 2 times: busy\n");
+}
+
+
+
+TEST_CASE_METHOD(DedupSinkTestFixture, "calls of another severity, logger or with other fields are kept apart", TAG)
+{
+    auto logger = createLogger(LONG_WINDOW);
+    auto other  = std::make_shared<Logger>("other");
+    other->addSink(sink);
+
+    logger->info("x");
+    logger->warn("x");
+    other->info("x");
+    logger->info("x", kv("attempt", 1));
+    logger->info("x", kv("attempt", 2));
+
+    requireResultEqualsExpected(stream.str(), "svc x\nsvc x\nother x\nsvc x attempt=1\nsvc x attempt=2\n");
+    REQUIRE(sink->getCollapsedCount() == 0);
+}
+
+
+
+TEST_CASE_METHOD(DedupSinkTestFixture, "the oldest message makes room once the table is full", TAG)
+{
+    auto logger = createLogger({std::chrono::seconds{60}, 2});
+
+    logger->info("a");
+    logger->info("a");
+    logger->info("b");
+    logger->info("c");
+    logger->info("a");
+
+    requireResultEqualsExpected(stream.str(), "svc a\nsvc b\nsvc repeated 1 times: a\nsvc c\nsvc a\n");
+}
+
+
+
+TEST_CASE_METHOD(DedupSinkTestFixture, "a full table collapses like a list of the tracked messages", TAG)
+{
+    constexpr std::size_t CAPACITY = 16;
+    auto logger                    = createLogger({std::chrono::seconds{60}, CAPACITY});
+
+    // a slow model of the table keeping the messages in the order they were first written
+    std::deque<std::pair<std::string, int>> tracked;
+    std::string expected;
+
+    std::mt19937 random{42};
+    for (int i = 0; i < 20000; i++)
+    {
+        const std::string message = "m" + std::to_string(random() % 40);
+        logger->info(message);
+
+        auto it = std::find_if(tracked.begin(), tracked.end(),
+                               [&message](const auto& entry) { return entry.first == message; });
+        if (it != tracked.end())
+        {
+            it->second++;
+            continue;
+        }
+
+        if (tracked.size() == CAPACITY)
+        {
+            if (tracked.front().second > 0)
+                expected += fmt::format("svc repeated {} times: {}\n", tracked.front().second, tracked.front().first);
+            tracked.pop_front();
+        }
+        tracked.emplace_back(message, 0);
+        expected += "svc " + message + "\n";
+    }
+
+    requireResultEqualsExpected(stream.str(), expected);
+}
+
+
+
+TEST_CASE_METHOD(DedupSinkTestFixture, "a capacity of zero writes every call", TAG)
+{
+    auto logger = createLogger({std::chrono::seconds{60}, 0});
+
+    logger->info("a");
+    logger->info("a");
+    logger->flush();
+
+    requireResultEqualsExpected(stream.str(), "svc a\nsvc a\n");
+}
+
+
+
+TEST_CASE("messages written directly are collapsed until the sink is destroyed", TAG)
+{
+    std::ostringstream stream;
+    {
+        DedupSink sink{SinkFactory::createStreamSink(stream), LONG_WINDOW, PatternFormatter{"%(message)|"}};
+        sink.write(Severity::Error, "disk full");
+        sink.write(Severity::Error, "disk full");
+        sink.write(Severity::Error, "disk full");
+        requireResultEqualsExpected(stream.str(), "disk full|");
+
+        sink.setSeverity(Severity::Info);
+        sink.write(Severity::Trace, "filtered");
+    }
+
+    requireResultEqualsExpected(stream.str(), "disk full|repeated 2 times: disk full|");
+}
+
+
+
+TEST_CASE_METHOD(DedupSinkTestFixture, "the crash flush writes the repeats counted so far", TAG)
+{
+    auto logger = createLogger(LONG_WINDOW);
+
+    logger->error("retrying");
+    logger->error("retrying");
+    logger->error("retrying");
+    sink->flushOnCrash(std::chrono::steady_clock::now() + std::chrono::seconds{2});
+
+    requireResultEqualsExpected(stream.str(), "svc retrying\nsvc repeated 2 times: retrying\n");
+}
+
+
+
+TEST_CASE("targets taking records get the records", TAG)
+{
+    std::ostringstream stream;
+    auto json = std::make_shared<JsonSink>(SinkFactory::createStreamSink(stream));
+    auto sink = std::make_shared<DedupSink>(json, LONG_WINDOW);
+
+    AsyncLogger logger{"svc.api"};
+    logger.addSink(sink);
+    logger.error("timeout after {} ms", 250, kv("peer", "10.0.0.7"));
+    logger.error("timeout after {} ms", 250, kv("peer", "10.0.0.7"));
+    logger.flush();
+
+    const std::string output = stream.str();
+    REQUIRE(output.find(R"("logger":"svc.api")") != std::string::npos);
+    REQUIRE(output.find(R"("message":"timeout after 250 ms","peer":"10.0.0.7"})") != std::string::npos);
+    REQUIRE(output.find(R"("message":"repeated 1 times: timeout after 250 ms peer=10.0.0.7"})") != std::string::npos);
+}
+
+
+
+TEST_CASE("a target writing text needs a pattern", TAG)
+{
+    std::ostringstream stream;
+    REQUIRE_THROWS_AS(DedupSink{SinkFactory::createStreamSink(stream)}, DedupPatternException);
+    REQUIRE_NOTHROW(DedupSink{std::make_shared<JsonSink>(SinkFactory::createStreamSink(stream))});
+}
@@ -0,0 +1,122 @@
+#include "nealog/EpochReclaimer.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[EpochReclaimer]";
+constexpr const char* TAG_THREADING = "[EpochReclaimer][Multithreading]";
+
+constexpr int VALID = 42;
+
+
+
+TEST_CASE("a snapshot retired while no thread reads is freed right away", TAG)
+{
+    auto snapshot                        = std::make_shared<const int>(VALID);
+    const std::weak_ptr<const int> freed = snapshot;
+
+    EpochReclaimer::getInstance().retire(std::move(snapshot));
+
+    REQUIRE(freed.expired());
+    requireResultEqualsExpected(EpochReclaimer::getInstance().getRetiredCount(), 0U);
+}
+
+
+
+TEST_CASE("a snapshot is kept until the guard from before it was retired is gone", TAG)
+{
+    auto snapshot                        = std::make_shared<const int>(VALID);
+    const std::weak_ptr<const int> freed = snapshot;
+
+    {
+        const EpochReclaimer::ReadGuard guard;
+        {
+            // a nested guard leaving does not end the outer one
+            const EpochReclaimer::ReadGuard nested;
+        }
+        EpochReclaimer::getInstance().retire(std::move(snapshot));
+        EpochReclaimer::getInstance().reclaim();
+        REQUIRE_FALSE(freed.expired());
+    }
+
+    EpochReclaimer::getInstance().reclaim();
+    REQUIRE(freed.expired());
+}
+
+
+
+TEST_CASE("a guard on another thread keeps the snapshot", TAG_THREADING)
+{
+    auto snapshot                        = std::make_shared<const int>(VALID);
+    const std::weak_ptr<const int> freed = snapshot;
+
+    std::atomic<bool> entered{false};
+    std::atomic<bool> leave{false};
+    std::thread reader{[&entered, &leave] {
+        const EpochReclaimer::ReadGuard guard;
+        entered = true;
+        while (!leave)
+            std::this_thread::yield();
+    }};
+    while (!entered)
+        std::this_thread::yield();
+
+    EpochReclaimer::getInstance().retire(std::move(snapshot));
+    REQUIRE_FALSE(freed.expired());
+
+    leave = true;
+    reader.join();
+    EpochReclaimer::getInstance().reclaim();
+    REQUIRE(freed.expired());
+}
+
+
+
+TEST_CASE("readers never see a freed snapshot while it is replaced", TAG_THREADING)
+{
+    auto current = std::make_unique<int>(VALID);
+    std::atomic<const int*> published{current.get()};
+    std::atomic<bool> running{true};
+    std::atomic<int> invalidReads{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++)
+    {
+        readers.emplace_back([&published, &running, &invalidReads] {
+            while (running)
+            {
+                const EpochReclaimer::ReadGuard guard;
+                if (*published.load(std::memory_order_acquire) != VALID)
+                    invalidReads++;
+            }
+        });
+    }
+
+    // overwritten before it is freed, so a reader of a freed one would notice
+    auto overwriteAndDelete = [](int* value) {
+        *value = 0;
+        delete value;
+    };
+
+    for (int i = 0; i < 10000; i++)
+    {
+        auto replacement = std::make_unique<int>(VALID);
+        published.store(replacement.get(), std::memory_order_release);
+        std::shared_ptr<int> replaced{current.release(), overwriteAndDelete};
+        current = std::move(replacement);
+        EpochReclaimer::getInstance().retire(std::move(replaced));
+    }
+
+    running = false;
+    for (auto& reader : readers)
+        reader.join();
+    EpochReclaimer::getInstance().reclaim();
+
+    requireResultEqualsExpected(invalidReads.load(), 0);
+    requireResultEqualsExpected(EpochReclaimer::getInstance().getRetiredCount(), 0U);
+}
@@ -0,0 +1,211 @@
+#include "nealog/Sink.h"
+#include "TestApi.h"
+#include "typehelper.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[Sink][FileSink]";
+constexpr const char* TAG_THREADING = "[Sink][FileSink][Multithreading]";
+
+constexpr FileFlushPolicy NEVER_FLUSH{std::chrono::milliseconds{0}, Severity::Fatal};
+
+
+
+class FileSinkTestFixture : public TemporaryDirectoryFixture
+{
+  public:
+    FileSinkTestFixture() : TemporaryDirectoryFixture{"nealog_file_sink_test"}
+    {
+    }
+};
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "Create a FileSink", TAG)
+{
+    auto createdSink = SinkFactory::createFileSink(path);
+
+    CHECK(isInstanceOf<FileSink>(createdSink.get()));
+    requireResultEqualsExpected(createdSink->getType(), SinkType::File);
+    requireResultEqualsExpected(createdSink->getPath(), path);
+}
+
+
+
+TEST_CASE("opening a file in a missing directory throws", TAG)
+{
+    REQUIRE_THROWS_AS(FileSink{"/nonexistent-nealog-directory/file.log"}, FileSinkException);
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "messages stay buffered until flush", TAG)
+{
+    FileSink sink{path, NEVER_FLUSH};
+    sink.write(Severity::Info, "first ");
+    sink.write(Severity::Error, "second");
+
+    REQUIRE(readFile(path).empty());
+
+    sink.flush();
+    REQUIRE(readFile(path) == "first second");
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "messages reaching the flush severity are written right away", TAG)
+{
+    FileSink sink{path, FileFlushPolicy{std::chrono::milliseconds{0}, Severity::Error}};
+    sink.write(Severity::Info, "info ");
+
+    REQUIRE(readFile(path).empty());
+
+    sink.write(Severity::Error, "error");
+    REQUIRE(readFile(path) == "info error");
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "buffer is written once the flush interval passed", TAG)
+{
+    FileSink sink{path, FileFlushPolicy{std::chrono::milliseconds{100}, Severity::Fatal}};
+    sink.write(Severity::Info, "old ");
+    sink.write(Severity::Info, "new");
+    REQUIRE(readFile(path).empty());
+
+    // no further write comes, the timer writes the buffer
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (readFile(path).empty() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds{5});
+
+    REQUIRE(readFile(path) == "old new");
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "full buffer is written before it overflows", TAG)
+{
+    FileSink sink{path, NEVER_FLUSH, 8};
+    sink.write(Severity::Info, "12345");
+    sink.write(Severity::Info, "6789");
+
+    REQUIRE(readFile(path) == "12345");
+
+    sink.write(Severity::Info, "message larger than the buffer");
+    REQUIRE(readFile(path) == "123456789message larger than the buffer");
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "batch fitting into the buffer stays buffered", TAG)
+{
+    FileSink sink{path, NEVER_FLUSH, 16};
+    const SinkRecord records[] = {
+        {Severity::Info, "first "}, {Severity::Trace, "skipped "}, {Severity::Info, "second"}};
+    sink.setSeverity(Severity::Info);
+    sink.writeBatch(records, 3);
+
+    REQUIRE(readFile(path).empty());
+
+    sink.flush();
+    REQUIRE(readFile(path) == "first second");
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "batch larger than the buffer is written right away in order", TAG)
+{
+    FileSink sink{path, NEVER_FLUSH, 8};
+    sink.write(Severity::Info, "buffered ");
+
+    // more records than fit into one writev call
+    std::vector<std::string> messages;
+    std::vector<SinkRecord> records;
+    std::string expected = "buffered ";
+    for (int i = 0; i < 200; i++)
+        messages.push_back(std::to_string(i) + " ");
+    for (const std::string& message : messages)
+    {
+        records.push_back({Severity::Info, message});
+        expected += message;
+    }
+
+    sink.writeBatch(records.data(), records.size());
+
+    REQUIRE(readFile(path) == expected);
+    requireResultEqualsExpected(sink.getWriteErrorCount(), std::size_t{0});
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "destroying the sink writes the buffer", TAG)
+{
+    {
+        FileSink sink{path, NEVER_FLUSH};
+        sink.write(Severity::Info, "pending");
+    }
+
+    REQUIRE(readFile(path) == "pending");
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "existing content is appended to", TAG)
+{
+    {
+        FileSink sink{path};
+        sink.write(Severity::Info, "first ");
+    }
+    {
+        FileSink sink{path};
+        sink.write(Severity::Info, "second");
+    }
+
+    REQUIRE(readFile(path) == "first second");
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "messages below the sink severity are not written", TAG)
+{
+    FileSink sink{path, NEVER_FLUSH};
+    sink.setSeverity(Severity::Warn);
+    sink.write(Severity::Info, "info");
+    sink.write(Severity::Warn, "warn");
+    sink.flush();
+
+    REQUIRE(readFile(path) == "warn");
+}
+
+
+
+TEST_CASE_METHOD(FileSinkTestFixture, "write to a FileSink from multiple threads", TAG_THREADING)
+{
+    constexpr int MESSAGES_PER_THREAD = 1000;
+    {
+        FileSink sink{path, NEVER_FLUSH, 256};
+        auto writeMessages = [&sink]() {
+            for (int i = 0; i < MESSAGES_PER_THREAD; i++)
+                sink.write(Severity::Info, "message\n");
+        };
+
+        std::thread firstThread(writeMessages);
+        std::thread secondThread(writeMessages);
+        firstThread.join();
+        secondThread.join();
+    }
+
+    std::istringstream content{readFile(path)};
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(content, line);)
+        lines.push_back(line);
+
+    REQUIRE(lines.size() == 2 * MESSAGES_PER_THREAD);
+    REQUIRE(lines.front() == "message");
+}
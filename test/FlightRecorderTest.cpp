@@ -0,0 +1,187 @@
+#include "nealog/AsyncLogger.h"
+#include "nealog/FlightRecorder.h"
+#include "nealog/JsonSink.h"
+#include "nealog/Logger.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <fmt/chrono.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[FlightRecorder]";
+
+constexpr FlightRecorderPolicy KEEP_THREE_DEBUG{3, Severity::Debug, Severity::Error};
+
+
+
+TEST_CASE("the ring keeps the newest records in their order", TAG)
+{
+    FlightRecorder recorder{{3}};
+
+    for (int i = 0; i < 5; i++)
+    {
+        Record record;
+        record.capture(Severity::Debug, "record {}", i);
+        recorder.keep(record);
+    }
+    requireResultEqualsExpected(recorder.getSize(), std::size_t{3});
+
+    std::vector<Record> records;
+    recorder.takeAll(records);
+    REQUIRE(records.size() == 3);
+    for (int i = 0; i < 3; i++)
+    {
+        fmt::memory_buffer message;
+        records[i].formatMessage(message);
+        REQUIRE(fmt::to_string(message) == "record " + std::to_string(i + 2));
+    }
+
+    requireResultEqualsExpected(recorder.getSize(), std::size_t{0});
+    recorder.takeAll(records);
+    REQUIRE(records.empty());
+}
+
+
+
+TEST_CASE("calls below the severity are written in front of the trigger", TAG)
+{
+    std::ostringstream stream;
+    Logger logger{"svc"};
+    logger.setSeverity(Severity::Info);
+    logger.setFormatter(PatternFormatter{"%(severity) %(message)\n"});
+    logger.addSink(SinkFactory::createStreamSink(stream));
+    logger.setFlightRecorder(KEEP_THREE_DEBUG);
+
+    REQUIRE_FALSE(logger.isEnabled(Severity::Trace));
+    REQUIRE(logger.isEnabled(Severity::Debug));
+
+    logger.trace("not kept");
+    for (int i = 0; i < 5; i++)
+        logger.debug("step {}", i);
+    logger.debug("plain");
+    logger.info("running");
+    requireResultEqualsExpected(stream.str(), "Info running\n");
+
+    logger.error("failed");
+    requireResultEqualsExpected(stream.str(),
+                                "Info running\nDebug step 3\nDebug step 4\nDebug plain\nError failed\n");
+
+    // the ring was emptied by the first error
+    stream.str("");
+    logger.error("failed again");
+    requireResultEqualsExpected(stream.str(), "Error failed again\n");
+}
+
+
+
+TEST_CASE("kept calls keep their fields and can be written on demand", TAG)
+{
+    std::ostringstream stream;
+    Logger logger{"svc"};
+    logger.setSeverity(Severity::Warn);
+    logger.addSink(std::make_shared<JsonSink>(SinkFactory::createStreamSink(stream)));
+    logger.setFlightRecorder(KEEP_THREE_DEBUG);
+
+    logger.info("request", kv("user", "bob"));
+    REQUIRE(stream.str().empty());
+
+    logger.writeFlightRecorder();
+    REQUIRE(stream.str().find("\"message\":\"request\",\"user\":\"bob\"}\n") != std::string::npos);
+}
+
+
+
+TEST_CASE("kept calls are formatted like the ones written right away", TAG)
+{
+    std::ostringstream stream;
+    Logger logger{"svc"};
+    logger.setSeverity(Severity::Warn);
+    logger.setFormatter(PatternFormatter{"%(message)|"});
+    logger.addSink(SinkFactory::createStreamSink(stream));
+    logger.setFlightRecorder(KEEP_THREE_DEBUG);
+
+    logger.info("t={:%S} ratio {}", std::chrono::seconds{5}, 0.1f);
+    logger.info("ratio {}", 0.1f);
+    logger.writeFlightRecorder();
+
+    requireResultEqualsExpected(stream.str(), "t=05 ratio 0.1|ratio 0.1|");
+}
+
+
+
+TEST_CASE("a capacity of 0 removes the recorder", TAG)
+{
+    std::ostringstream stream;
+    Logger logger{"svc"};
+    logger.setSeverity(Severity::Info);
+    logger.addSink(SinkFactory::createStreamSink(stream));
+    logger.setFlightRecorder(KEEP_THREE_DEBUG);
+    logger.debug("dropped with the recorder");
+
+    logger.setFlightRecorder({});
+    REQUIRE_FALSE(logger.isEnabled(Severity::Debug));
+
+    logger.error("failed");
+    requireResultEqualsExpected(stream.str(), "failed");
+}
+
+
+
+TEST_CASE("replaced recorders are freed while no thread keeps a call", TAG)
+{
+    std::ostringstream stream;
+    Logger logger{"svc"};
+    logger.setSeverity(Severity::Info);
+    logger.addSink(SinkFactory::createStreamSink(stream));
+
+    for (int i = 0; i < 100; i++)
+    {
+        logger.setFlightRecorder(KEEP_THREE_DEBUG);
+        logger.debug("kept {}", i);
+    }
+    requireResultEqualsExpected(EpochReclaimer::getInstance().getRetiredCount(), 0U);
+
+    // only the calls of the recorder set last are left
+    logger.error("failed");
+    requireResultEqualsExpected(stream.str(), "kept 99failed");
+}
+
+
+
+TEST_CASE("AsyncLogger writes kept calls of all threads before the trigger", TAG)
+{
+    std::ostringstream stream;
+    {
+        AsyncLogger logger{"async"};
+        logger.setSeverity(Severity::Info);
+        logger.setFormatter(PatternFormatter{"%(message)\n"});
+        logger.addSink(SinkFactory::createStreamSink(stream));
+        logger.setFlightRecorder({100, Severity::Debug, Severity::Error});
+
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < 4; thread++)
+        {
+            threads.emplace_back([&logger, thread]() {
+                for (int i = 0; i < 10; i++)
+                    logger.debug("thread {} step {}", thread, i);
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        logger.error("failed");
+    }
+
+    std::istringstream lines{stream.str()};
+    std::vector<std::string> messages;
+    for (std::string line; std::getline(lines, line);)
+        messages.push_back(line);
+
+    REQUIRE(messages.size() == 41);
+    REQUIRE(messages.back() == "failed");
+}
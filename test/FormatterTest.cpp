@@ -5,7 +5,12 @@
 #include <algorithm>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_all.hpp>
+#include <chrono>
+#include <ctime>
 #include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace nealog;
 
@@ -105,3 +110,216 @@ TEST_CASE("PatternFormatter with set pattern returns formatted message", TAG)
 }
 
 //}}}
+
+
+
+/******************************
+ * Pattern engine
+ ******************************/
+
+//{{{
+
+TEST_CASE("pattern is tokenized into literals and placeholders", TAG)
+{
+    std::vector<PatternToken> tokens;
+    tokenizePattern("[%(message)] %(message)", [&](PatternToken token) { tokens.push_back(token); });
+
+    REQUIRE(tokens.size() == 4);
+    CHECK(tokens[0].type == PatternTokenType::Literal);
+    CHECK(tokens[1].type == PatternTokenType::Message);
+    CHECK(tokens[2].type == PatternTokenType::Literal);
+    CHECK(tokens[2].length == 2);
+    CHECK(tokens[3].type == PatternTokenType::Message);
+}
+
+
+
+TEST_CASE("PatternFormatter appends to a caller supplied buffer", TAG)
+{
+    PatternFormatter formatter("<%(message)>");
+    fmt::memory_buffer buffer;
+
+    formatter.formatTo(buffer, "one is {}", 1);
+    formatter.render(buffer, "{plain}");
+
+    requireResultEqualsExpected(fmt::to_string(buffer), "<one is 1><{plain}>");
+}
+
+
+
+TEST_CASE("PatternFormatter substitutes every placeholder", TAG)
+{
+    PatternFormatter formatter("%(message) and %(message)");
+
+    requireResultEqualsExpected(formatter.format("this"), "this and this");
+}
+
+
+
+TEST_CASE("copied PatternFormatter renders the same as the original", TAG)
+{
+    PatternFormatter original("x %(message) y");
+    PatternFormatter copy{original};
+
+    requireResultEqualsExpected(copy.format("m"), "x m y");
+}
+
+
+
+TEST_CASE("StaticPattern is tokenized at compile time", TAG)
+{
+    constexpr StaticPattern<> pattern{"[%(message)]"};
+    static_assert(pattern.getTokenCount() == 3);
+
+    fmt::memory_buffer buffer;
+    pattern.formatTo(buffer, "{}+{}", 1, 2);
+
+    requireResultEqualsExpected(fmt::to_string(buffer), "[1+2]");
+}
+
+
+
+
+TEST_CASE("unknown placeholders are kept as literals", TAG)
+{
+    PatternFormatter formatter("%(unknown) %(message) %(");
+
+    requireResultEqualsExpected(formatter.format("m"), "%(unknown) m %(");
+}
+
+//}}}
+
+
+
+/******************************
+ * Timestamps
+ ******************************/
+
+//{{{
+
+namespace
+{
+    auto localSeconds(std::time_t seconds) -> std::string
+    {
+        char text[32];
+        return {text, std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds))};
+    }
+} // namespace
+
+
+
+TEST_CASE("time placeholders render the local time of the context", TAG)
+{
+    using namespace std::chrono;
+    const std::time_t seconds = 1714564800;
+    const auto timestamp      = system_clock::time_point{duration_cast<system_clock::duration>(
+        std::chrono::seconds{seconds} + nanoseconds{123456789})};
+
+    PatternFormatter formatter("%(time)|%(time.us)|%(time.ns) %(message)");
+    fmt::memory_buffer buffer;
+    formatter.render(buffer, "m", PatternContext{timestamp});
+
+    const std::string expectedSeconds = localSeconds(seconds);
+    requireResultEqualsExpected(fmt::to_string(buffer), expectedSeconds + ".123|" + expectedSeconds + ".123456|" +
+                                                            expectedSeconds + ".123456789 m");
+}
+
+
+
+TEST_CASE("cached timestamp prefix follows changes of the second", TAG)
+{
+    using namespace std::chrono;
+    const std::time_t seconds = 1714564800;
+
+    fmt::memory_buffer buffer;
+    for (std::time_t second : {seconds, seconds, seconds + 1, seconds - 86400})
+    {
+        buffer.clear();
+        appendTimestamp(buffer, system_clock::time_point{std::chrono::seconds{second}} + milliseconds{7}, 3);
+        requireResultEqualsExpected(fmt::to_string(buffer), localSeconds(second) + ".007");
+    }
+}
+
+
+
+TEST_CASE("time placeholder without a timestamp reads the clock", TAG)
+{
+    PatternFormatter formatter("%(time)");
+    const std::string before = localSeconds(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+
+    const std::string result = formatter.format("");
+    const std::string after  = localSeconds(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+
+    REQUIRE(result.size() == before.size() + 4);
+    REQUIRE(result.substr(0, before.size()) >= before);
+    REQUIRE(result.substr(0, after.size()) <= after);
+}
+
+
+
+TEST_CASE("StaticPattern tokenizes time placeholders", TAG)
+{
+    constexpr StaticPattern<> pattern{"%(time.us) %(message)"};
+    static_assert(pattern.getTokenCount() == 3);
+}
+
+//}}}
+
+
+
+/******************************
+ * Context placeholders
+ ******************************/
+
+//{{{
+
+TEST_CASE("context placeholders show severity, logger, thread and call site", TAG)
+{
+    const ThreadIdentity thread{42, "worker"};
+    const SourceLocation location{"main.cpp", 7, "run"};
+    const PatternContext context{{}, Severity::Warn, "svc.db", &thread, &location};
+
+    PatternFormatter formatter(
+        "%(severity)|%(SEVERITY)|%(logger)|%(thread)|%(thread.name)|%(file):%(line)|%(function)|%(message)");
+    fmt::memory_buffer buffer;
+    formatter.render(buffer, "m", context);
+
+    requireResultEqualsExpected(fmt::to_string(buffer), "Warn|WARN|svc.db|42|worker|main.cpp:7|run|m");
+}
+
+
+
+TEST_CASE("context placeholders without a context show the rendering thread", TAG)
+{
+    PatternFormatter formatter("%(logger)|%(thread)|%(thread.name)|%(file):%(line)%(function)");
+    const std::string currentThreadId{getCurrentThreadIdText()};
+
+    requireResultEqualsExpected(formatter.format(""), "|" + currentThreadId + "|" + currentThreadId + "|:");
+
+    std::string named;
+    std::string namedThreadId;
+    std::thread thread{[&]() {
+        setThreadName("named");
+        named         = formatter.format("");
+        namedThreadId = std::string{getCurrentThreadIdText()};
+    }};
+    thread.join();
+
+    REQUIRE(namedThreadId != currentThreadId);
+    requireResultEqualsExpected(named, "|" + namedThreadId + "|named|:");
+}
+
+
+
+TEST_CASE("source file names drop their directories", TAG)
+{
+    STATIC_REQUIRE(sourceFileName("src/nealog/Logger.cpp") == "Logger.cpp");
+    STATIC_REQUIRE(sourceFileName("C:\\src\\Logger.cpp") == "Logger.cpp");
+    STATIC_REQUIRE(sourceFileName("Logger.cpp") == "Logger.cpp");
+
+    constexpr SourceLocation location = NEALOG_SOURCE_LOCATION;
+    STATIC_REQUIRE(location.file == "FormatterTest.cpp");
+    REQUIRE(location.line == __LINE__ - 2);
+}
+
+//}}}
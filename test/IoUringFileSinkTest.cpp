@@ -0,0 +1,145 @@
+#include "nealog/IoUringFileSink.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[Sink][IoUringFileSink]";
+constexpr const char* TAG_THREADING = "[Sink][IoUringFileSink][Multithreading]";
+
+constexpr FileFlushPolicy NEVER_FLUSH{std::chrono::milliseconds{0}, Severity::Fatal};
+
+
+
+class IoUringFileSinkTestFixture : public TemporaryDirectoryFixture
+{
+  public:
+    IoUringFileSinkTestFixture() : TemporaryDirectoryFixture{"nealog_io_uring_file_sink_test"}
+    {
+    }
+};
+
+
+
+TEST_CASE_METHOD(IoUringFileSinkTestFixture, "messages stay buffered until flush", TAG)
+{
+    IoUringFileSink sink{path, NEVER_FLUSH};
+    requireResultEqualsExpected(sink.getType(), SinkType::IoUringFile);
+
+    sink.write(Severity::Info, "first ");
+    sink.write(Severity::Info, "second");
+    REQUIRE(readFile(path).empty());
+
+    sink.flush();
+    REQUIRE(readFile(path) == "first second");
+}
+
+
+
+TEST_CASE_METHOD(IoUringFileSinkTestFixture, "a buffered message is written once the interval passed", TAG)
+{
+    IoUringFileSink sink{path, FileFlushPolicy{std::chrono::milliseconds{50}, Severity::Fatal}};
+    sink.write(Severity::Info, "quiet");
+    REQUIRE(readFile(path).empty());
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (readFile(path).empty() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+    REQUIRE(readFile(path) == "quiet");
+}
+
+
+
+TEST_CASE_METHOD(IoUringFileSinkTestFixture, "several full buffers end up in order", TAG)
+{
+    {
+        IoUringFileSink sink{path, NEVER_FLUSH, FileDurability::None, 8, 2};
+        for (char digit = '0'; digit <= '9'; digit++)
+            sink.write(Severity::Info, std::string(3, digit));
+        sink.write(Severity::Info, "message larger than a buffer");
+    }
+
+    REQUIRE(readFile(path) == "000111222333444555666777888999message larger than a buffer");
+}
+
+
+
+TEST_CASE_METHOD(IoUringFileSinkTestFixture, "writes are synced with the configured durability", TAG)
+{
+    for (FileDurability durability : {FileDurability::Fdatasync, FileDurability::Fsync})
+    {
+        std::filesystem::remove(path);
+        {
+            IoUringFileSink sink{path, NEVER_FLUSH, durability, 4};
+            sink.write(Severity::Info, "sync");
+            sink.write(Severity::Info, "ed");
+            sink.flush();
+
+            REQUIRE(readFile(path) == "synced");
+            REQUIRE(sink.getWriteErrorCount() == 0);
+        }
+    }
+}
+
+
+
+TEST_CASE_METHOD(IoUringFileSinkTestFixture, "the crash flush writes the buffered messages", TAG)
+{
+    IoUringFileSink sink{path, NEVER_FLUSH, FileDurability::None, 8, 2};
+    for (char digit = '0'; digit <= '4'; digit++)
+        sink.write(Severity::Info, std::string(3, digit));
+
+    sink.flushOnCrash(std::chrono::steady_clock::now() + std::chrono::seconds{2});
+    REQUIRE(readFile(path) == "000111222333444");
+}
+
+
+
+TEST_CASE_METHOD(IoUringFileSinkTestFixture, "existing content is appended to", TAG)
+{
+    {
+        IoUringFileSink sink{path};
+        sink.write(Severity::Info, "first ");
+    }
+    {
+        IoUringFileSink sink{path};
+        sink.write(Severity::Info, "second");
+    }
+
+    REQUIRE(readFile(path) == "first second");
+}
+
+
+
+TEST_CASE_METHOD(IoUringFileSinkTestFixture, "write to an IoUringFileSink from multiple threads", TAG_THREADING)
+{
+    constexpr int MESSAGES_PER_THREAD = 1000;
+    {
+        IoUringFileSink sink{path, NEVER_FLUSH, FileDurability::None, 256, 3};
+        auto writeMessages = [&sink]() {
+            for (int i = 0; i < MESSAGES_PER_THREAD; i++)
+                sink.write(Severity::Info, "message\n");
+        };
+
+        std::thread firstThread(writeMessages);
+        std::thread secondThread(writeMessages);
+        firstThread.join();
+        secondThread.join();
+    }
+
+    std::istringstream content{readFile(path)};
+    int lineCount = 0;
+    for (std::string line; std::getline(content, line);)
+    {
+        REQUIRE(line == "message");
+        lineCount++;
+    }
+
+    REQUIRE(lineCount == 2 * MESSAGES_PER_THREAD);
+}
@@ -0,0 +1,224 @@
+#include "nealog/AsyncLogger.h"
+#include "nealog/JsonSink.h"
+#include "nealog/Logger.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <fmt/chrono.h>
+#include <limits>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[Sink][JsonSink]";
+
+constexpr JsonEscapeKernel ALL_KERNELS[] = {JsonEscapeKernel::Scalar, JsonEscapeKernel::Sse2, JsonEscapeKernel::Avx2};
+
+
+
+auto escape(std::string_view text, JsonEscapeKernel kernel) -> std::string
+{
+    fmt::memory_buffer out;
+    appendJsonEscaped(out, text, kernel);
+    return fmt::to_string(out);
+}
+
+
+
+auto jsonValue(const ArgumentValue& value) -> std::string
+{
+    fmt::memory_buffer out;
+    appendJsonValue(out, value);
+    return fmt::to_string(out);
+}
+
+
+
+/*!
+ * The line without the time, which is checked on its own.
+ */
+auto withoutTime(const std::string& line) -> std::string
+{
+    static const std::regex TIME{R"(^\{"time":"\d{4}-\d\d-\d\dT\d\d:\d\d:\d\d\.\d{6}Z",)"};
+    REQUIRE(std::regex_search(line, TIME));
+    return "{" + line.substr(line.find(",\"severity\"") + 1);
+}
+
+
+
+TEST_CASE("special characters are escaped", TAG)
+{
+    for (JsonEscapeKernel kernel : ALL_KERNELS)
+    {
+        if (!isJsonEscapeKernelSupported(kernel))
+            continue;
+
+        requireResultEqualsExpected(escape("plain text", kernel), "plain text");
+        requireResultEqualsExpected(escape("say \"hi\"\\", kernel), "say \\\"hi\\\"\\\\");
+        requireResultEqualsExpected(escape("a\nb\tc\rd\be\ff", kernel), "a\\nb\\tc\\rd\\be\\ff");
+        requireResultEqualsExpected(escape(std::string_view{"\0\x01\x1f", 3}, kernel), "\\u0000\\u0001\\u001f");
+        requireResultEqualsExpected(escape("gr\xC3\xBC\xC3\x9F\x7f", kernel), "gr\xC3\xBC\xC3\x9F\x7f");
+    }
+}
+
+
+
+TEST_CASE("every kernel escapes like the scalar one", TAG)
+{
+    std::mt19937 random{42};
+    std::uniform_int_distribution<int> byte{0, 255};
+    std::uniform_int_distribution<int> plainByte{0x20, 0x7e};
+
+    for (std::size_t length : {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 200})
+    {
+        for (int round = 0; round < 20; round++)
+        {
+            // mostly plain text with a few special characters, like real messages
+            std::string text(length, ' ');
+            for (char& character : text)
+                character = static_cast<char>(round % 2 == 0 ? byte(random) : plainByte(random));
+
+            const std::string expected = escape(text, JsonEscapeKernel::Scalar);
+            for (JsonEscapeKernel kernel : ALL_KERNELS)
+            {
+                if (isJsonEscapeKernelSupported(kernel))
+                    requireResultEqualsExpected(escape(text, kernel), expected);
+            }
+        }
+    }
+}
+
+
+
+TEST_CASE("values are written as JSON", TAG)
+{
+    requireResultEqualsExpected(jsonValue(true), "true");
+    requireResultEqualsExpected(jsonValue('"'), "\"\\\"\"");
+    requireResultEqualsExpected(jsonValue(std::int64_t{-42}), "-42");
+    requireResultEqualsExpected(jsonValue(std::numeric_limits<std::uint64_t>::max()), "18446744073709551615");
+    requireResultEqualsExpected(jsonValue(0.1), "0.1");
+    requireResultEqualsExpected(jsonValue(std::numeric_limits<double>::quiet_NaN()), "null");
+    requireResultEqualsExpected(jsonValue(-std::numeric_limits<double>::infinity()), "null");
+    requireResultEqualsExpected(jsonValue(std::string_view{"line\n"}), "\"line\\n\"");
+    requireResultEqualsExpected(jsonValue(static_cast<const void*>(nullptr)), "\"0x0\"");
+}
+
+
+
+TEST_CASE("timestamps are written as UTC in ISO 8601", TAG)
+{
+    using namespace std::chrono;
+
+    auto iso = [](microseconds sinceEpoch) {
+        fmt::memory_buffer out;
+        appendIsoTimestamp(out, system_clock::time_point{duration_cast<system_clock::duration>(sinceEpoch)});
+        return fmt::to_string(out);
+    };
+
+    requireResultEqualsExpected(iso(seconds{1714564800} + microseconds{250000}), "2024-05-01T12:00:00.250000Z");
+    requireResultEqualsExpected(iso(seconds{1714564801}), "2024-05-01T12:00:01.000000Z");
+    requireResultEqualsExpected(iso(seconds{951782400}), "2000-02-29T00:00:00.000000Z");
+    requireResultEqualsExpected(iso(microseconds{-1}), "1969-12-31T23:59:59.999999Z");
+}
+
+
+
+TEST_CASE("log calls become one JSON object per line", TAG)
+{
+    static constexpr SourceLocation location{"src/api.cpp", 42, "handle"};
+    std::ostringstream stream;
+    {
+        Logger logger{"svc.api"};
+        auto sink = std::make_shared<JsonSink>(SinkFactory::createStreamSink(stream));
+        requireResultEqualsExpected(sink->getType(), SinkType::Json);
+        logger.addSink(sink);
+
+        logger.info("request {} done", 7, kv("user", "bob \"b\""), kv("ms", 1.5), kv("ok", true));
+        logger.logAt<Severity::Warn>(location, "slow", kv("ms", 900));
+        logger.error("no fields");
+    }
+
+    std::istringstream lines{stream.str()};
+    std::vector<std::string> objects;
+    for (std::string line; std::getline(lines, line);)
+        objects.push_back(withoutTime(line));
+
+    const std::string thread = fmt::format("\"thread\":{}", getCurrentThread().id);
+    REQUIRE(objects.size() == 3);
+    REQUIRE(objects[0] == "{\"severity\":\"Info\",\"logger\":\"svc.api\"," + thread +
+                              ",\"message\":\"request 7 done\",\"user\":\"bob \\\"b\\\"\",\"ms\":1.5,\"ok\":true}");
+    REQUIRE(objects[1] == "{\"severity\":\"Warn\",\"logger\":\"svc.api\"," + thread +
+                              ",\"message\":\"slow\",\"file\":\"src/api.cpp\",\"line\":42,\"function\":\"handle\","
+                              "\"ms\":900}");
+    REQUIRE(objects[2] == "{\"severity\":\"Error\",\"logger\":\"svc.api\"," + thread + ",\"message\":\"no fields\"}");
+}
+
+
+
+TEST_CASE("text sinks show the fields behind the message", TAG)
+{
+    std::ostringstream stream;
+    Logger logger{"text"};
+    logger.addSink(SinkFactory::createStreamSink(stream));
+
+    logger.info("request done", kv("user", 42), kv("name", "bob"));
+    requireResultEqualsExpected(stream.str(), "request done user=42 name=bob");
+}
+
+
+
+TEST_CASE("float fields and format specs of user types survive the capture", TAG)
+{
+    std::ostringstream text;
+    std::ostringstream json;
+    Logger logger{"svc"};
+    logger.addSink(SinkFactory::createStreamSink(text));
+    logger.addSink(std::make_shared<JsonSink>(SinkFactory::createStreamSink(json)));
+
+    logger.info("t={:%S}", std::chrono::seconds{5}, kv("ratio", 0.1f), kv("elapsed", std::chrono::seconds{5}));
+
+    requireResultEqualsExpected(text.str(), "t=05 ratio=0.1 elapsed=5s");
+    REQUIRE(json.str().find(R"("message":"t=05","ratio":0.1,"elapsed":"5s"})") != std::string::npos);
+}
+
+
+
+TEST_CASE("AsyncLogger hands fields to a JsonSink", TAG)
+{
+    std::ostringstream stream;
+    {
+        AsyncLogger logger{"async"};
+        logger.addSink(std::make_shared<JsonSink>(SinkFactory::createStreamSink(stream)));
+
+        for (int i = 0; i < 100; i++)
+            logger.info("message {}", i, kv("index", i));
+    }
+
+    std::istringstream lines{stream.str()};
+    int index = 0;
+    for (std::string line; std::getline(lines, line); index++)
+    {
+        const std::string expected = fmt::format("\"message\":\"message {0}\",\"index\":{0}}}", index);
+        REQUIRE(line.size() > expected.size());
+        REQUIRE(line.compare(line.size() - expected.size(), expected.size(), expected) == 0);
+    }
+    REQUIRE(index == 100);
+}
+
+
+
+TEST_CASE("formatted messages are written as objects as well", TAG)
+{
+    std::ostringstream stream;
+    JsonSink sink{SinkFactory::createStreamSink(stream)};
+    sink.setSeverity(Severity::Warn);
+
+    sink.write(Severity::Info, "dropped");
+    sink.write(Severity::Error, "tab\there");
+    requireResultEqualsExpected(withoutTime(stream.str()), "{\"severity\":\"Error\",\"message\":\"tab\\there\"}\n");
+}
@@ -2,6 +2,7 @@
 #include "nealog/Sink.h"
 #include "TestApi.h"
 #include <catch2/catch_test_macros.hpp>
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <sstream>
@@ -93,3 +94,79 @@ auto createLoggerTree() -> void
     auto aboutLogger  = facade.getLogger("appbar.menu.about");
 }
 
+
+
+
+TEST_CASE("child follows severity changes of the parent after it was used", TAG_INTEGRATION)
+{
+    LoggerRegistry_st registry;
+    auto rootLogger = registry.getOrCreate("");
+    std::ostringstream oss;
+    rootLogger->addSink(SinkFactory::createStreamSink(oss));
+    auto logger = registry.getOrCreate("com.app");
+
+    logger->debug("a");
+    rootLogger->setSeverity(Severity::Info);
+    logger->debug("b");
+    REQUIRE_FALSE(logger->isEnabled(Severity::Debug));
+    logger->info("c");
+
+    requireResultEqualsExpected(oss.str(), "ac");
+}
+
+
+
+TEST_CASE("child with own sinks stops writing to the parent sinks", TAG_INTEGRATION)
+{
+    LoggerRegistry_st registry;
+    std::ostringstream rootStream;
+    std::ostringstream childStream;
+    registry.getOrCreate("")->addSink(SinkFactory::createStreamSink(rootStream));
+    auto logger = registry.getOrCreate("com");
+
+    logger->info("root");
+    logger->addSink(SinkFactory::createStreamSink(childStream));
+    logger->info("child");
+
+    requireResultEqualsExpected(rootStream.str(), "root");
+    requireResultEqualsExpected(childStream.str(), "child");
+}
+
+
+
+TEST_CASE("child without sinks uses the formatter of the parent", TAG_INTEGRATION)
+{
+    LoggerRegistry_st registry;
+    std::ostringstream oss;
+    auto rootLogger = registry.getOrCreate("");
+    rootLogger->addSink(SinkFactory::createStreamSink(oss));
+    rootLogger->setFormatter(PatternFormatter{"root: %(message)"});
+
+    registry.getOrCreate("com.app")->info("hello {}", 1);
+
+    requireResultEqualsExpected(oss.str(), "root: hello 1");
+}
+
+
+
+TEST_CASE("change the severity while other threads are logging", TAG_THREADING)
+{
+    LoggerRegistry_mt registry;
+    auto rootLogger = registry.getOrCreate("");
+    rootLogger->addSink(std::make_shared<NoopSink>());
+    auto logger = registry.getOrCreate("com.app");
+
+    std::atomic<bool> running{true};
+    std::thread loggingThread([&]() {
+        while (running)
+            logger->debug("message {}", 1);
+    });
+
+    for (int i = 0; i < 1000; i++)
+        rootLogger->setSeverity(i % 2 == 0 ? Severity::Info : Severity::Trace);
+
+    running = false;
+    loggingThread.join();
+    rootLogger->setSeverity(Severity::Info);
+    REQUIRE_FALSE(logger->isEnabled(Severity::Debug));
+}
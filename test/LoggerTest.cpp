@@ -229,6 +229,74 @@ TEST_CASE("all sinks should write the message", TAG)
 
 
 
+TEST_CASE("removed sinks do not write anymore", TAG)
+{
+    std::ostringstream firstStream;
+    std::ostringstream secondStream;
+    auto secondSink = SinkFactory::createStreamSink(secondStream);
+
+    auto logger = getLoggerWithStreamSink(firstStream);
+    logger->addSink(secondSink);
+
+    REQUIRE(logger->removeSink(secondSink));
+    REQUIRE_FALSE(logger->removeSink(secondSink));
+    logger->log(Severity::Error, "Message");
+
+    REQUIRE(logger->getSinks().size() == 1);
+    REQUIRE(firstStream.str() == "Message");
+    REQUIRE(secondStream.str() == "");
+}
+
+
+
+TEST_CASE("a removed sink is released once no thread writes to it", TAG)
+{
+    std::ostringstream stream;
+    auto logger                        = getLoggerWithStreamSink(stream);
+    auto sink                          = std::make_shared<NoopSink>();
+    const std::weak_ptr<Sink> released = sink;
+
+    logger->addSink(sink);
+    logger->log(Severity::Error, "Message");
+    REQUIRE(logger->removeSink(sink));
+    sink.reset();
+
+    REQUIRE(released.expired());
+    REQUIRE(logger->getSinks().size() == 1);
+}
+
+
+
+TEST_CASE_METHOD(TestFixture, "sinks can be added and removed while other threads log", TAG_THREADING)
+{
+    std::stringstream stream{};
+    auto sink = SinkFactory::createStreamSink(stream);
+    logger.addSink(sink);
+
+    std::thread firstThread(logOnFirstThread, &logger);
+    std::thread secondThread(logOnSecondThread, &logger);
+
+    std::vector<std::weak_ptr<Sink>> temporarySinks;
+    for (int i = 0; i < 100; i++)
+    {
+        auto temporarySink = std::make_shared<NoopSink>();
+        temporarySinks.emplace_back(temporarySink);
+        logger.addSink(temporarySink);
+        logger.removeSink(temporarySink);
+    }
+
+    firstThread.join();
+    secondThread.join();
+    EpochReclaimer::getInstance().reclaim();
+
+    REQUIRE(logger.getSinks().size() == 1);
+    REQUIRE(logger.getSinks().front() == sink);
+    for (const auto& temporarySink : temporarySinks)
+        REQUIRE(temporarySink.expired());
+}
+
+
+
 TEST_CASE("format output with formatter", TAG)
 {
     std::ostringstream stream;
@@ -254,3 +322,106 @@ TEST_CASE("set formatter in logger and log to stream with pattern", TAG)
     logger->log(Severity::Error, "Lorem");
     requireResultEqualsExpected(stream.str(), "super Lorem");
 }
+
+
+
+/******************************
+ * Variadic format API
+ ******************************/
+
+//{{{
+
+struct CountedFormat
+{
+    static inline int formatCount = 0;
+};
+
+template <>
+struct fmt::formatter<CountedFormat> : fmt::formatter<std::string_view>
+{
+    template <typename TContext>
+    auto format(const CountedFormat&, TContext& context) const
+    {
+        CountedFormat::formatCount++;
+        return fmt::formatter<std::string_view>::format("counted", context);
+    }
+};
+
+
+
+TEST_CASE("variadic overloads format the arguments into the pattern", TAG)
+{
+    std::ostringstream stream;
+    auto logger = getLoggerWithStreamSink(stream);
+    logger->setFormatter(PatternFormatter{"<%(message)>"});
+
+    logger->info("x={} y={:.1f}", 1, 2.0);
+
+    REQUIRE(stream.str() == "<x=1 y=2.0>");
+}
+
+
+
+TEST_CASE("plain messages are not parsed as format string", TAG)
+{
+    std::ostringstream stream;
+    auto logger = getLoggerWithStreamSink(stream);
+
+    REQUIRE_NOTHROW(logger->info("{ not a placeholder }"));
+    REQUIRE(stream.str() == "{ not a placeholder }");
+}
+
+
+
+TEST_CASE("arguments of disabled calls are not formatted", TAG)
+{
+    std::ostringstream stream;
+    auto logger = getLoggerWithStreamSink(stream);
+    logger->setSeverity(Severity::Warn);
+    CountedFormat::formatCount = 0;
+
+    logger->debug("{}", CountedFormat{});
+    REQUIRE(CountedFormat::formatCount == 0);
+
+    logger->error("{}", CountedFormat{});
+    REQUIRE(CountedFormat::formatCount == 1);
+    REQUIRE(stream.str() == "counted");
+}
+
+
+
+TEST_CASE("format strings compiled with FMT_COMPILE are accepted", TAG)
+{
+    std::ostringstream stream;
+    auto logger = getLoggerWithStreamSink(stream);
+
+    logger->log(Severity::Info, FMT_COMPILE("{}-{}"), 1, "two");
+
+    REQUIRE(stream.str() == "1-two");
+}
+
+
+
+TEST_CASE("variadic calls through LoggerBase reach the parent sinks", TAG)
+{
+    std::ostringstream stream;
+    LoggerRegistry_st registry;
+    registry.getOrCreate("")->addSink(SinkFactory::createStreamSink(stream));
+    LoggerBase::SPtr child = registry.getOrCreate("child");
+
+    child->warn("{} {}", "from", "child");
+
+    REQUIRE(stream.str() == "from child");
+}
+
+//}}}
+
+
+
+TEST_CASE("logger without sinks and parent is disabled", TAG)
+{
+    Logger logger{"orphan"};
+
+    REQUIRE_FALSE(logger.isEnabled(Severity::Fatal));
+    REQUIRE_NOTHROW(logger.fatal("nowhere"));
+}
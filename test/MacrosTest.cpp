@@ -0,0 +1,180 @@
+// Strip everything below Info in this translation unit only.
+#undef NEALOG_ACTIVE_LEVEL
+#define NEALOG_ACTIVE_LEVEL NEALOG_LEVEL_INFO
+
+#include "nealog/Macros.h"
+#include "TestApi.h"
+#include "nealog/Logger.h"
+#include "nealog/Sink.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[Macros]";
+
+
+
+static int evaluationCount = 0;
+
+auto countedArgument() -> int
+{
+    return ++evaluationCount;
+}
+
+
+
+class MacrosTestFixture
+{
+  public:
+    MacrosTestFixture()
+    {
+        logger->addSink(SinkFactory::createStreamSink(stream));
+        evaluationCount = 0;
+    }
+
+  public:
+    std::ostringstream stream;
+    std::shared_ptr<Logger> logger = std::make_shared<Logger>("macros");
+};
+
+
+
+TEST_CASE("compile time active level follows NEALOG_ACTIVE_LEVEL", TAG)
+{
+    STATIC_REQUIRE_FALSE(isActiveAtCompileTime(Severity::Debug));
+    STATIC_REQUIRE(isActiveAtCompileTime(Severity::Info));
+}
+
+
+
+TEST_CASE_METHOD(MacrosTestFixture, "calls below the active level are stripped with their arguments", TAG)
+{
+    NEALOG_TRACE(logger, "trace {}", countedArgument());
+    NEALOG_DEBUG(*logger, "debug {}", countedArgument());
+
+    REQUIRE(evaluationCount == 0);
+    REQUIRE(stream.str().empty());
+}
+
+
+
+TEST_CASE_METHOD(MacrosTestFixture, "calls at or above the active level are written", TAG)
+{
+    NEALOG_INFO(logger, "info {} ", countedArgument());
+    NEALOG_WARN(logger.get(), "warn ");
+    NEALOG_ERROR(*logger, "error {} ", countedArgument());
+
+    REQUIRE(evaluationCount == 2);
+    REQUIRE(stream.str() == "info 1 warn error 2 ");
+}
+
+
+
+TEST_CASE_METHOD(MacrosTestFixture, "runtime disabled calls do not evaluate their arguments", TAG)
+{
+    logger->setSeverity(Severity::Error);
+
+    NEALOG_WARN(logger, "warn {}", countedArgument());
+
+    REQUIRE(evaluationCount == 0);
+    REQUIRE(stream.str().empty());
+}
+
+
+
+TEST_CASE_METHOD(MacrosTestFixture, "logAt removes calls below the active level", TAG)
+{
+    logger->logAt<Severity::Debug>("debug");
+    logger->logAt<Severity::Fatal>("fatal {}", 1);
+
+    REQUIRE(stream.str() == "fatal 1");
+}
+
+
+
+auto fetchCallSiteLogger() -> LoggerBase&
+{
+    return NEALOG_LOGGER("macros.callsite");
+}
+
+
+
+TEST_CASE("NEALOG_LOGGER resolves the default registry logger once per call site", TAG)
+{
+    LoggerBase& logger = fetchCallSiteLogger();
+
+    requireResultEqualsExpected(&fetchCallSiteLogger(), &logger);
+    requireResultEqualsExpected(&getDefaultRegistry().getOrCreateReference("macros.callsite"), &logger);
+}
+
+
+
+TEST_CASE("NEALOG_LOGGER can be passed to the logging macros", TAG)
+{
+    std::ostringstream stream;
+    NEALOG_LOGGER("macros.handle").addSink(SinkFactory::createStreamSink(stream));
+
+    NEALOG_INFO(NEALOG_LOGGER("macros.handle"), "handle {}", 1);
+
+    REQUIRE(stream.str() == "handle 1");
+}
+
+
+
+auto logFromNamedFunction(LoggerBase& logger) -> int
+{
+    NEALOG_WARN(logger, "located {}|", 1);
+    NEALOG_WARN(logger, "plain|");
+    return __LINE__ - 2;
+}
+
+
+
+TEST_CASE_METHOD(MacrosTestFixture, "macros hand their call site to the pattern", TAG)
+{
+    logger->setFormatter(PatternFormatter{"%(file):%(line) %(function) %(message)"});
+
+    const int line = logFromNamedFunction(*logger);
+
+    requireResultEqualsExpected(stream.str(), "MacrosTest.cpp:" + std::to_string(line) +
+                                                  " logFromNamedFunction located 1|MacrosTest.cpp:" +
+                                                  std::to_string(line + 1) + " logFromNamedFunction plain|");
+}
+
+
+
+TEST_CASE_METHOD(MacrosTestFixture, "limited calls evaluate arguments only if they pass", TAG)
+{
+    for (int i = 0; i < 7; i++)
+        NEALOG_WARN_LIMITED(logger, EveryN(3), "{} {}|", i, countedArgument());
+
+    REQUIRE(evaluationCount == 3);
+    requireResultEqualsExpected(stream.str(), "0 1|suppressed 2 messages3 2|6 3|");
+}
+
+
+
+TEST_CASE_METHOD(MacrosTestFixture, "each call site has its own limit", TAG)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        NEALOG_INFO_LIMITED(logger, Sampled(0.0), "never|");
+        NEALOG_INFO_LIMITED(logger, RateLimit(1, 1), "first|");
+        NEALOG_ERROR_LIMITED(*logger, EveryN(1), "always|");
+    }
+
+    requireResultEqualsExpected(stream.str(), "first|always|always|");
+}
+
+
+
+TEST_CASE_METHOD(MacrosTestFixture, "limited calls below the active level are stripped", TAG)
+{
+    NEALOG_DEBUG_LIMITED(logger, EveryN(1), "debug {}", countedArgument());
+
+    REQUIRE(evaluationCount == 0);
+    REQUIRE(stream.str().empty());
+}
@@ -0,0 +1,127 @@
+#include "nealog/MmapSink.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[Sink][MmapSink]";
+constexpr const char* TAG_THREADING = "[Sink][MmapSink][Multithreading]";
+
+
+
+class MmapSinkTestFixture : public TemporaryDirectoryFixture
+{
+  public:
+    MmapSinkTestFixture() : TemporaryDirectoryFixture{"nealog_mmap_sink_test"}
+    {
+    }
+};
+
+
+
+TEST_CASE_METHOD(MmapSinkTestFixture, "segment is preallocated and truncated on close", TAG)
+{
+    {
+        MmapSink sink{path, 4096};
+        requireResultEqualsExpected(sink.getType(), SinkType::Mmap);
+        requireResultEqualsExpected(std::filesystem::file_size(path + ".1"), std::uintmax_t{4096});
+
+        sink.write(Severity::Info, "first ");
+        sink.write(Severity::Info, "second");
+        sink.flush();
+    }
+
+    REQUIRE(readFile(path + ".1") == "first second");
+}
+
+
+
+TEST_CASE_METHOD(MmapSinkTestFixture, "full segment rolls over to the next one", TAG)
+{
+    {
+        MmapSink sink{path, 10};
+        sink.write(Severity::Info, "12345");
+        sink.write(Severity::Info, "67890");
+        sink.write(Severity::Info, "next");
+
+        requireResultEqualsExpected(sink.getCurrentSegment(), std::uint64_t{2});
+    }
+
+    REQUIRE(readFile(path + ".1") == "1234567890");
+    REQUIRE(readFile(path + ".2") == "next");
+}
+
+
+
+TEST_CASE_METHOD(MmapSinkTestFixture, "messages larger than a segment are dropped", TAG)
+{
+    MmapSink sink{path, 8};
+    sink.write(Severity::Info, "too large for a segment");
+
+    requireResultEqualsExpected(sink.getDroppedCount(), std::size_t{1});
+}
+
+
+
+TEST_CASE_METHOD(MmapSinkTestFixture, "numbering continues after existing segments", TAG)
+{
+    {
+        MmapSink sink{path, 4096};
+        sink.write(Severity::Info, "first");
+    }
+
+    MmapSink sink{path, 4096};
+    requireResultEqualsExpected(sink.getCurrentSegment(), std::uint64_t{2});
+}
+
+
+
+TEST_CASE_METHOD(MmapSinkTestFixture, "messages below the sink severity are not written", TAG)
+{
+    {
+        MmapSink sink{path, 4096};
+        sink.setSeverity(Severity::Warn);
+        sink.write(Severity::Info, "info");
+        sink.write(Severity::Warn, "warn");
+    }
+
+    REQUIRE(readFile(path + ".1") == "warn");
+}
+
+
+
+TEST_CASE_METHOD(MmapSinkTestFixture, "rolling while multiple threads write loses no message", TAG_THREADING)
+{
+    constexpr int MESSAGES_PER_THREAD = 2000;
+    {
+        MmapSink sink{path, 4096, MmapSyncPolicy{1024, true, MsyncMode::Async}};
+        auto writeMessages = [&sink]() {
+            for (int i = 0; i < MESSAGES_PER_THREAD; i++)
+                sink.write(Severity::Info, "message\n");
+        };
+
+        std::thread firstThread(writeMessages);
+        std::thread secondThread(writeMessages);
+        firstThread.join();
+        secondThread.join();
+    }
+
+    std::string content;
+    for (const auto& entry : std::filesystem::directory_iterator{directory})
+        content += readFile(entry.path().string());
+
+    std::istringstream lines{content};
+    int lineCount = 0;
+    for (std::string line; std::getline(lines, line);)
+    {
+        REQUIRE(line == "message");
+        lineCount++;
+    }
+
+    REQUIRE(lineCount == 2 * MESSAGES_PER_THREAD);
+}
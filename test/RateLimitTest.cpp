@@ -0,0 +1,106 @@
+#include "nealog/RateLimit.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[RateLimit]";
+
+
+
+template <typename TLimit>
+auto countPassing(TLimit& limit, int calls) -> int
+{
+    int passing = 0;
+    for (int i = 0; i < calls; i++)
+        passing += limit.tryPass() ? 1 : 0;
+    return passing;
+}
+
+
+
+TEST_CASE("EveryN passes the first and every nth call", TAG)
+{
+    EveryN limit{4};
+
+    std::vector<bool> passed;
+    for (int i = 0; i < 9; i++)
+        passed.push_back(limit.tryPass());
+
+    requireResultEqualsExpected(passed, std::vector<bool>{true, false, false, false, true, false, false, false, true});
+    REQUIRE(limit.getSuppressed() == 6);
+
+    EveryN everyCall{0};
+    REQUIRE(countPassing(everyCall, 10) == 10);
+}
+
+
+
+TEST_CASE("Sampled passes calls with its probability", TAG)
+{
+    Sampled never{0.0};
+    Sampled always{1.0};
+    Sampled quarter{0.25};
+
+    REQUIRE(countPassing(never, 1000) == 0);
+    REQUIRE(never.getSuppressed() == 1000);
+    REQUIRE(countPassing(always, 1000) == 1000);
+
+    const int passing = countPassing(quarter, 100000);
+    REQUIRE(passing > 23000);
+    REQUIRE(passing < 27000);
+}
+
+
+
+TEST_CASE("RateLimit passes a burst and refills over time", TAG)
+{
+    RateLimit limit{20, 5};
+
+    REQUIRE(countPassing(limit, 100) == 5);
+    REQUIRE(limit.getSuppressed() == 95);
+
+    // one token takes 50 ms, the coarse clock may lag a few milliseconds
+    std::this_thread::sleep_for(std::chrono::milliseconds{120});
+    const int passing = countPassing(limit, 100);
+    REQUIRE(passing >= 1);
+    REQUIRE(passing <= 3);
+}
+
+
+
+TEST_CASE("RateLimit holds under concurrent calls", TAG)
+{
+    RateLimit limit{1, 1000};
+    std::atomic<int> passing{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&limit, &passing] { passing += countPassing(limit, 10000); });
+    for (std::thread& thread : threads)
+        thread.join();
+
+    REQUIRE(passing >= 1000);
+    REQUIRE(passing <= 1002);
+    REQUIRE(limit.getSuppressed() == 40000 - static_cast<std::uint64_t>(passing));
+}
+
+
+
+TEST_CASE("suppressed calls are reported once per interval", TAG)
+{
+    EveryN limit{10};
+    REQUIRE(limit.takeSuppressed() == 0);
+
+    countPassing(limit, 25);
+    REQUIRE(limit.takeSuppressed() == 22);
+
+    countPassing(limit, 10);
+    REQUIRE(limit.takeSuppressed() == 0);
+    REQUIRE(limit.getSuppressed() == 9);
+}
@@ -0,0 +1,159 @@
+#include "nealog/Record.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <fmt/chrono.h>
+#include <string>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[Record]";
+
+
+
+auto formatRecord(const Record& record) -> std::string
+{
+    fmt::memory_buffer buffer;
+    record.formatMessage(buffer);
+    return fmt::to_string(buffer);
+}
+
+
+
+struct Point
+{
+    int x;
+    int y;
+};
+
+template <>
+struct fmt::formatter<Point> : fmt::formatter<std::string_view>
+{
+    template <typename TContext>
+    auto format(const Point& point, TContext& context) const
+    {
+        return fmt::format_to(context.out(), "({}, {})", point.x, point.y);
+    }
+};
+
+
+
+TEST_CASE("captured arithmetic arguments are formatted later", TAG)
+{
+    Record record;
+    record.capture(Severity::Info, "{} {} {} {} {:.2f}", true, 'c', -42, 42u, 1.5);
+
+    requireResultEqualsExpected(record.getSeverity(), Severity::Info);
+    requireResultEqualsExpected(formatRecord(record), "true c -42 42 1.50");
+}
+
+
+
+TEST_CASE("captured strings are copied into the record", TAG)
+{
+    Record record;
+    {
+        std::string temporary{"temporary"};
+        record.capture(Severity::Debug, "{}|{}|{}", temporary, std::string_view{"view"}, "literal");
+    }
+
+    requireResultEqualsExpected(formatRecord(record), "temporary|view|literal");
+}
+
+
+
+TEST_CASE("types with a user formatter are formatted on capture", TAG)
+{
+    Record record;
+    record.capture(Severity::Info, "point {}", Point{1, 2});
+
+    requireResultEqualsExpected(formatRecord(record), "point (1, 2)");
+}
+
+
+
+TEST_CASE("types with a user formatter keep their format spec", TAG)
+{
+    Record record;
+    record.capture(Severity::Info, "t={:%S} {}", std::chrono::seconds{5}, 7);
+
+    REQUIRE(record.getArguments().empty());
+    requireResultEqualsExpected(formatRecord(record), "t=05 7");
+}
+
+
+
+TEST_CASE("float is formatted as float", TAG)
+{
+    Record record;
+    record.capture(Severity::Info, "{} {}", 0.1f, 0.1);
+    record.captureFields(kv("ratio", 0.1f), kv("elapsed", std::chrono::milliseconds{3}));
+
+    requireResultEqualsExpected(formatRecord(record), "0.1 0.1 ratio=0.1 elapsed=3ms");
+}
+
+
+
+TEST_CASE("a plain message is not parsed as format string", TAG)
+{
+    Record record;
+    record.captureMessage(Severity::Warn, "{not a placeholder}");
+
+    requireResultEqualsExpected(formatRecord(record), "{not a placeholder}");
+}
+
+
+
+TEST_CASE("arguments that do not fit are formatted eagerly", TAG)
+{
+    const std::string longArgument(Record::ARGUMENT_CAPACITY * 2, 'x');
+    Record record;
+    record.capture(Severity::Info, "<{}>", longArgument);
+
+    REQUIRE(record.getArguments().empty());
+    requireResultEqualsExpected(formatRecord(record), "<" + longArgument + ">");
+}
+
+
+
+TEST_CASE("fields are captured behind the arguments and shown as key=value", TAG)
+{
+    const std::string user{"bob"};
+    Record record;
+    record.capture(Severity::Info, "request {}", 7);
+    record.captureFields(kv("user", user), kv("ms", 1.5), kv("ok", true));
+
+    requireResultEqualsExpected(formatRecord(record), "request 7 user=bob ms=1.5 ok=true");
+
+    fmt::memory_buffer message;
+    record.formatMessageWithoutFields(message);
+    requireResultEqualsExpected(fmt::to_string(message), "request 7");
+
+    std::vector<std::string> keys;
+    std::vector<ArgumentValue> values;
+    forEachField(record.getFields(), [&](std::string_view key, const ArgumentValue& value) {
+        keys.emplace_back(key);
+        values.push_back(value);
+    });
+    REQUIRE(keys == std::vector<std::string>{"user", "ms", "ok"});
+    REQUIRE(std::get<std::string_view>(values[0]) == "bob");
+    REQUIRE(std::get<double>(values[1]) == 1.5);
+    REQUIRE(std::get<bool>(values[2]));
+}
+
+
+
+TEST_CASE("fields that do not fit are kept in a string of their own", TAG)
+{
+    const std::string longValue(Record::ARGUMENT_CAPACITY, 'x');
+    Record record;
+    record.capture(Severity::Info, "{}", 1);
+    record.captureFields(kv("id", 42), kv("payload", longValue));
+
+    requireResultEqualsExpected(record.getArguments().size(), std::size_t{9});
+    requireResultEqualsExpected(formatRecord(record), "1 id=42 payload=" + longValue);
+
+    record.capture(Severity::Info, "{}", 2);
+    REQUIRE(record.getFields().empty());
+}
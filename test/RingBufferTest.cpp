@@ -0,0 +1,90 @@
+#include "nealog/RingBuffer.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[RingBuffer]";
+constexpr const char* TAG_THREADING = "[RingBuffer][Multithreading]";
+
+
+
+TEST_CASE("capacity is rounded up to the next power of two", TAG)
+{
+    MpscRingBuffer<int> buffer{5};
+    requireResultEqualsExpected(buffer.capacity(), 8u);
+}
+
+
+
+TEST_CASE("values are popped in the order they were pushed", TAG)
+{
+    MpscRingBuffer<int> buffer{4};
+    REQUIRE(buffer.empty());
+
+    REQUIRE(buffer.tryPush(1));
+    REQUIRE(buffer.tryPush(2));
+
+    int value = 0;
+    REQUIRE(buffer.tryPop(value));
+    requireResultEqualsExpected(value, 1);
+    REQUIRE(buffer.tryPop(value));
+    requireResultEqualsExpected(value, 2);
+    REQUIRE_FALSE(buffer.tryPop(value));
+}
+
+
+
+TEST_CASE("pushing into a full buffer fails until a value is popped", TAG)
+{
+    MpscRingBuffer<int> buffer{2};
+    REQUIRE(buffer.tryPush(1));
+    REQUIRE(buffer.tryPush(2));
+    REQUIRE_FALSE(buffer.tryPush(3));
+
+    int value = 0;
+    REQUIRE(buffer.tryPop(value));
+    REQUIRE(buffer.tryPush(3));
+    requireResultEqualsExpected(buffer.pushedCount(), 3u);
+}
+
+
+
+TEST_CASE("multiple producers push without losing a value", TAG_THREADING)
+{
+    constexpr int VALUES_PER_PRODUCER = 10000;
+    constexpr int PRODUCERS           = 4;
+    MpscRingBuffer<int> buffer{64};
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < PRODUCERS; producer++)
+    {
+        producers.emplace_back([&buffer]() {
+            for (int i = 1; i <= VALUES_PER_PRODUCER; i++)
+            {
+                while (!buffer.tryPush(int{i}))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    long long sum = 0;
+    int popped    = 0;
+    while (popped < VALUES_PER_PRODUCER * PRODUCERS)
+    {
+        int value = 0;
+        if (buffer.tryPop(value))
+        {
+            sum += value;
+            popped++;
+        }
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    const long long expectedSum = PRODUCERS * (VALUES_PER_PRODUCER * (VALUES_PER_PRODUCER + 1LL) / 2);
+    requireResultEqualsExpected(sum, expectedSum);
+}
@@ -0,0 +1,270 @@
+#include "nealog/Sink.h"
+#include "TestApi.h"
+#include "typehelper.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef NEALOG_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[Sink][RotatingFileSink]";
+constexpr const char* TAG_THREADING = "[Sink][RotatingFileSink][Multithreading]";
+
+constexpr FileFlushPolicy NEVER_FLUSH{std::chrono::milliseconds{0}, Severity::Fatal};
+
+
+
+class RotatingFileSinkTestFixture : public TemporaryDirectoryFixture
+{
+  public:
+    RotatingFileSinkTestFixture() : TemporaryDirectoryFixture{"nealog_rotating_file_sink_test"}
+    {
+    }
+};
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "Create a RotatingFileSink", TAG)
+{
+    auto createdSink = SinkFactory::createRotatingFileSink(path);
+
+    CHECK(isInstanceOf<RotatingFileSink>(createdSink.get()));
+    requireResultEqualsExpected(createdSink->getPath(), path);
+    requireResultEqualsExpected(createdSink->getSegmentPath(3), path + ".3");
+}
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "file is rotated before it exceeds the maximum size", TAG)
+{
+    RotationPolicy policy;
+    policy.maxSize = 10;
+
+    RotatingFileSink sink{path, policy, NEVER_FLUSH};
+    sink.write(Severity::Info, "12345");
+    sink.write(Severity::Info, "67890");
+    sink.write(Severity::Info, "next");
+    sink.flush();
+
+    REQUIRE(readFile(path + ".1") == "1234567890");
+    REQUIRE(readFile(path) == "next");
+}
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "file is rotated within a batch", TAG)
+{
+    RotationPolicy policy;
+    policy.maxSize = 10;
+
+    RotatingFileSink sink{path, policy, NEVER_FLUSH};
+    sink.setSeverity(Severity::Info);
+
+    const SinkRecord records[] = {
+        {Severity::Info, "12345"}, {Severity::Trace, "skipped"}, {Severity::Info, "67890"}, {Severity::Info, "next"}};
+    sink.writeBatch(records, 4);
+    sink.flush();
+
+    REQUIRE(readFile(path + ".1") == "1234567890");
+    REQUIRE(readFile(path) == "next");
+}
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "only the configured number of segments is kept", TAG)
+{
+    RotationPolicy policy;
+    policy.keptSegments = 2;
+
+    RotatingFileSink sink{path, policy};
+    for (int i = 1; i <= 4; i++)
+    {
+        sink.write(Severity::Info, std::to_string(i));
+        sink.rotate();
+    }
+    sink.flush();
+
+    REQUIRE_FALSE(std::filesystem::exists(path + ".1"));
+    REQUIRE_FALSE(std::filesystem::exists(path + ".2"));
+    REQUIRE(readFile(path + ".3") == "3");
+    REQUIRE(readFile(path + ".4") == "4");
+}
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "numbering continues after existing segments", TAG)
+{
+    {
+        RotatingFileSink sink{path};
+        sink.write(Severity::Info, "first");
+        sink.rotate();
+    }
+
+    RotatingFileSink sink{path};
+    sink.write(Severity::Info, "second");
+    sink.rotate();
+    sink.flush();
+
+    REQUIRE(readFile(path + ".1") == "first");
+    REQUIRE(readFile(path + ".2") == "second");
+}
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "file is rotated when the interval passed", TAG)
+{
+    RotationPolicy policy;
+    policy.maxSize  = 0;
+    policy.interval = std::chrono::seconds{1};
+
+    RotatingFileSink sink{path, policy};
+    sink.write(Severity::Info, "old");
+    std::this_thread::sleep_for(std::chrono::milliseconds{1100});
+    sink.write(Severity::Info, "new");
+    sink.flush();
+
+    REQUIRE(std::filesystem::exists(path + ".1"));
+    REQUIRE(readFile(path) == "new");
+}
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "a failed rotation is retried after the delay", TAG)
+{
+    RotationPolicy policy;
+    policy.maxSize    = 10;
+    policy.retryDelay = std::chrono::milliseconds{100};
+
+    RotatingFileSink sink{path, policy, NEVER_FLUSH};
+    // the rename fails while a non-empty directory takes the name of the segment
+    std::filesystem::create_directories(path + ".1/blocked");
+
+    for (int i = 0; i < 10; i++)
+        sink.write(Severity::Info, "12345678");
+    REQUIRE(sink.getRotationErrorCount() == 1);
+
+    std::filesystem::remove_all(path + ".1");
+    std::this_thread::sleep_for(std::chrono::milliseconds{150});
+    sink.write(Severity::Info, "next");
+    sink.flush();
+
+    REQUIRE(sink.getRotationErrorCount() == 1);
+    REQUIRE(readFile(path + ".1").size() == 80);
+    REQUIRE(readFile(path) == "next");
+}
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "the crash flush writes the buffer of the active file", TAG)
+{
+    RotatingFileSink sink{path, RotationPolicy{}, NEVER_FLUSH};
+    sink.write(Severity::Info, "first");
+    sink.rotate();
+    sink.write(Severity::Info, "second");
+    REQUIRE(readFile(path).empty());
+
+    sink.flushOnCrash(std::chrono::steady_clock::now() + std::chrono::seconds{2});
+    REQUIRE(readFile(path) == "second");
+
+    sink.flush();
+    REQUIRE(readFile(path + ".1") == "first");
+}
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "sidecar index moves along with its segment", TAG)
+{
+    RotationPolicy policy;
+    policy.keptSegments = 1;
+
+    RotatingFileSink sink{path, policy, NEVER_FLUSH, FileSink::DEFAULT_BUFFER_SIZE, FileIndexPolicy{true, 1}};
+    sink.writeFromLogger("rotated", Severity::Info, "first");
+    sink.rotate();
+    sink.writeFromLogger("rotated", Severity::Info, "second");
+    sink.rotate();
+    sink.flush();
+
+    REQUIRE_FALSE(std::filesystem::exists(path + ".1" + SIDECAR_INDEX_SUFFIX));
+
+    std::ifstream indexFile{path + ".2" + SIDECAR_INDEX_SUFFIX, std::ios::binary};
+    const SidecarIndex index{indexFile};
+    REQUIRE(index.getBlocks().size() == 1);
+    REQUIRE(index.getBlocks()[0].size == 6);
+    REQUIRE(std::filesystem::exists(path + SIDECAR_INDEX_SUFFIX));
+}
+
+
+
+#ifdef NEALOG_HAS_ZLIB
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "closed segments are compressed with gzip", TAG)
+{
+    RotationPolicy policy;
+    policy.compression = SegmentCompression::Gzip;
+
+    RotatingFileSink sink{path, policy};
+    sink.write(Severity::Info, "compressed message");
+    sink.rotate();
+    sink.flush();
+
+    REQUIRE_FALSE(std::filesystem::exists(path + ".1"));
+
+    gzFile compressed = gzopen((path + ".1.gz").c_str(), "rb");
+    requirePointerNotNull(compressed);
+    std::string content(64, '\0');
+    content.resize(static_cast<std::size_t>(gzread(compressed, content.data(), 64)));
+    gzclose(compressed);
+
+    REQUIRE(content == "compressed message");
+}
+#else
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "gzip compression needs zlib", TAG)
+{
+    RotationPolicy policy;
+    policy.compression = SegmentCompression::Gzip;
+
+    REQUIRE_THROWS_AS(RotatingFileSink(path, policy), UnsupportedCompressionException);
+}
+#endif
+
+
+
+TEST_CASE_METHOD(RotatingFileSinkTestFixture, "rotating while multiple threads write loses no message", TAG_THREADING)
+{
+    constexpr int MESSAGES_PER_THREAD = 1000;
+    RotationPolicy policy;
+    policy.maxSize      = 512;
+    policy.keptSegments = 1000;
+
+    {
+        RotatingFileSink sink{path, policy, NEVER_FLUSH};
+        auto writeMessages = [&sink]() {
+            for (int i = 0; i < MESSAGES_PER_THREAD; i++)
+                sink.write(Severity::Info, "message\n");
+        };
+
+        std::thread firstThread(writeMessages);
+        std::thread secondThread(writeMessages);
+        firstThread.join();
+        secondThread.join();
+    }
+
+    std::string content;
+    for (const auto& entry : std::filesystem::directory_iterator{directory})
+        content += readFile(entry.path().string());
+
+    std::istringstream lines{content};
+    int lineCount = 0;
+    for (std::string line; std::getline(lines, line);)
+        lineCount++;
+
+    REQUIRE(lineCount == 2 * MESSAGES_PER_THREAD);
+}
@@ -47,3 +47,12 @@ TEST_CASE("Parse Severity to string", TAG)
         REQUIRE_THROWS_AS(severityToString(UNSUPPORTED_SEVERITY), ParseException);
     }
 }
+
+
+
+TEST_CASE("severity names are constant and never throw", TAG)
+{
+    STATIC_REQUIRE(severityName(Severity::Warn) == "Warn");
+    STATIC_REQUIRE(severityUppercaseName(Severity::Fatal) == "FATAL");
+    STATIC_REQUIRE(severityName(UNSUPPORTED_SEVERITY).empty());
+}
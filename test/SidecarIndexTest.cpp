@@ -0,0 +1,238 @@
+#include "nealog/AsyncLogger.h"
+#include "nealog/Logger.h"
+#include "nealog/SidecarIndex.h"
+#include "nealog/Sink.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG = "[SidecarIndex]";
+
+constexpr FileFlushPolicy NEVER_FLUSH{std::chrono::milliseconds{0}, Severity::Fatal};
+constexpr FileIndexPolicy SMALL_BLOCKS{true, 64};
+
+
+
+class SidecarIndexTestFixture
+{
+  public:
+    SidecarIndexTestFixture()
+    {
+        std::filesystem::remove(path);
+        std::filesystem::remove(indexPath);
+    }
+
+    ~SidecarIndexTestFixture()
+    {
+        std::filesystem::remove(path);
+        std::filesystem::remove(indexPath);
+    }
+
+    auto readIndex() const -> SidecarIndex
+    {
+        std::ifstream file{indexPath, std::ios::binary};
+        return SidecarIndex{file};
+    }
+
+    auto readBlock(const IndexedBlock& block) const -> std::string
+    {
+        std::ifstream file{path, std::ios::binary};
+        file.seekg(static_cast<std::streamoff>(block.offset));
+
+        std::string content(static_cast<std::size_t>(block.size), '\0');
+        file.read(content.data(), static_cast<std::streamsize>(content.size()));
+        return content;
+    }
+
+    static auto loggersOf(const SidecarIndex& index, const IndexedBlock& block) -> std::vector<std::string>
+    {
+        std::vector<std::string> names;
+        for (std::size_t logger : block.loggers)
+            names.push_back(index.getLoggerNames()[logger]);
+        return names;
+    }
+
+  public:
+    std::string path      = (std::filesystem::temp_directory_path() / "nealog_sidecar_index_test.log").string();
+    std::string indexPath = path + SIDECAR_INDEX_SUFFIX;
+};
+
+
+
+TEST_CASE_METHOD(SidecarIndexTestFixture, "no index is written unless the policy enables it", TAG)
+{
+    {
+        FileSink sink{path};
+        sink.write(Severity::Info, "message\n");
+    }
+
+    REQUIRE(std::filesystem::exists(path));
+    REQUIRE_FALSE(std::filesystem::exists(indexPath));
+}
+
+
+
+TEST_CASE_METHOD(SidecarIndexTestFixture, "blocks cover the file in whole messages", TAG)
+{
+    {
+        Logger logger{"svc.db"};
+        logger.addSink(SinkFactory::createFileSink(path, NEVER_FLUSH, 128, SMALL_BLOCKS));
+
+        for (int i = 0; i < 100; i++)
+            logger.info("message number {}\n", i);
+    }
+
+    const SidecarIndex index = readIndex();
+    const auto& blocks       = index.getBlocks();
+    REQUIRE(blocks.size() > 10);
+
+    std::string content;
+    std::uint64_t expectedOffset = 0;
+    for (const IndexedBlock& block : blocks)
+    {
+        REQUIRE(block.offset == expectedOffset);
+        if (&block != &blocks.back())
+            REQUIRE(block.size >= SMALL_BLOCKS.blockSize);
+        REQUIRE(block.firstTimestamp <= block.lastTimestamp);
+        REQUIRE(loggersOf(index, block) == std::vector<std::string>{"svc.db"});
+
+        const std::string blockContent = readBlock(block);
+        REQUIRE(blockContent.back() == '\n');
+        content += blockContent;
+        expectedOffset += block.size;
+    }
+
+    REQUIRE(expectedOffset == std::filesystem::file_size(path));
+    REQUIRE(content.rfind("message number 99\n") == content.size() - 18);
+}
+
+
+
+TEST_CASE_METHOD(SidecarIndexTestFixture, "blocks are found by severity, logger subtree and time", TAG)
+{
+    Logger database{"svc.db"};
+    Logger databasePool{"svc.db.pool"};
+    Logger api{"svc.api"};
+
+    auto sink = SinkFactory::createFileSink(path, NEVER_FLUSH, FileSink::DEFAULT_BUFFER_SIZE, SMALL_BLOCKS);
+    for (Logger* logger : {&database, &databasePool, &api})
+        logger->addSink(sink);
+
+    database.info("connected\n");
+    sink->flush();
+    databasePool.error("pool exhausted\n");
+    sink->flush();
+    const auto beforeApi = std::chrono::system_clock::now();
+    api.warn("slow request\n");
+    sink->flush();
+
+    const SidecarIndex index = readIndex();
+    REQUIRE(index.getBlocks().size() == 3);
+
+    auto find = [&index](const IndexQuery& query) {
+        std::vector<std::string> found;
+        for (const IndexedBlock* block : index.findBlocks(query))
+            found.push_back(index.getLoggerNames()[block->loggers.front()]);
+        return found;
+    };
+
+    REQUIRE(find({}) == std::vector<std::string>{"svc.db", "svc.db.pool", "svc.api"});
+
+    IndexQuery bySeverity;
+    bySeverity.severity = Severity::Warn;
+    REQUIRE(find(bySeverity) == std::vector<std::string>{"svc.db.pool", "svc.api"});
+
+    IndexQuery byLogger;
+    byLogger.loggerSubtree = "svc.db";
+    REQUIRE(find(byLogger) == std::vector<std::string>{"svc.db", "svc.db.pool"});
+
+    IndexQuery byTime;
+    byTime.from = beforeApi;
+    REQUIRE(find(byTime) == std::vector<std::string>{"svc.api"});
+
+    byTime.to = beforeApi - std::chrono::hours{1};
+    REQUIRE(find(byTime).empty());
+}
+
+
+
+TEST_CASE_METHOD(SidecarIndexTestFixture, "appending to a file starts a new session behind the old content", TAG)
+{
+    for (const char* loggerName : {"first", "second"})
+    {
+        Logger logger{loggerName};
+        logger.addSink(SinkFactory::createFileSink(path, NEVER_FLUSH, FileSink::DEFAULT_BUFFER_SIZE, SMALL_BLOCKS));
+        logger.info("message of {}\n", loggerName);
+    }
+
+    const SidecarIndex index = readIndex();
+    const auto& blocks       = index.getBlocks();
+    REQUIRE(blocks.size() == 2);
+    REQUIRE(readBlock(blocks[0]) == "message of first\n");
+    REQUIRE(readBlock(blocks[1]) == "message of second\n");
+    REQUIRE(loggersOf(index, blocks[1]) == std::vector<std::string>{"second"});
+}
+
+
+
+TEST_CASE_METHOD(SidecarIndexTestFixture, "batches of an AsyncLogger are indexed with their logger", TAG)
+{
+    {
+        AsyncLogger logger{"async.worker"};
+        logger.addSink(SinkFactory::createFileSink(path, NEVER_FLUSH, 256, SMALL_BLOCKS));
+
+        for (int i = 0; i < 200; i++)
+            logger.info("queued message {}\n", i);
+    }
+
+    const SidecarIndex index  = readIndex();
+    std::uint64_t indexedSize = 0;
+    for (const IndexedBlock& block : index.getBlocks())
+    {
+        REQUIRE(loggersOf(index, block) == std::vector<std::string>{"async.worker"});
+        indexedSize += block.size;
+    }
+
+    REQUIRE(indexedSize == std::filesystem::file_size(path));
+}
+
+
+
+TEST_CASE("logger subtrees end at a separator", TAG)
+{
+    REQUIRE(isInLoggerSubtree("svc.db", "svc.db"));
+    REQUIRE(isInLoggerSubtree("svc.db.pool", "svc.db"));
+    REQUIRE(isInLoggerSubtree("svc.db", ""));
+    REQUIRE_FALSE(isInLoggerSubtree("svc.dbx", "svc.db"));
+    REQUIRE_FALSE(isInLoggerSubtree("svc", "svc.db"));
+}
+
+
+
+TEST_CASE_METHOD(SidecarIndexTestFixture, "malformed index throws", TAG)
+{
+    {
+        FileSink sink{path, NEVER_FLUSH, FileSink::DEFAULT_BUFFER_SIZE, SMALL_BLOCKS};
+        sink.writeFromLogger("logger", Severity::Info, "message\n");
+    }
+
+    SECTION("truncated block")
+    {
+        std::filesystem::resize_file(indexPath, std::filesystem::file_size(indexPath) - 1);
+        REQUIRE_THROWS_AS(readIndex(), SidecarIndexFormatException);
+    }
+
+    SECTION("no index at all")
+    {
+        std::ofstream{indexPath, std::ios::binary | std::ios::trunc} << "plain text";
+        REQUIRE_THROWS_AS(readIndex(), SidecarIndexFormatException);
+    }
+}
@@ -140,6 +140,21 @@ TEST_CASE("Write to StreamSink and check output", TAG)
 
 
 
+TEST_CASE("Write a batch to StreamSink", TAG)
+{
+    std::stringstream outputStream;
+    auto createdSink = SinkFactory::createStreamSink(outputStream);
+    createdSink->setSeverity(Severity::Warn);
+
+    const SinkRecord records[] = {
+        {Severity::Warn, "first "}, {Severity::Info, "skipped "}, {Severity::Error, "second"}};
+    createdSink->writeBatch(records, 3);
+
+    CHECK(outputStream.str() == "first second");
+}
+
+
+
 TEST_CASE("Create a stdout sink", TAG)
 {
     auto createdSink = SinkFactory::createStdOutSink();
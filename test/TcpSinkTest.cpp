@@ -0,0 +1,383 @@
+#include "nealog/TcpSink.h"
+#include "TestApi.h"
+#include <catch2/catch_test_macros.hpp>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* TAG           = "[Sink][TcpSink]";
+constexpr const char* TAG_THREADING = "[Sink][TcpSink][Multithreading]";
+
+constexpr const char* LOOPBACK = "127.0.0.1";
+
+
+
+/*!
+ * Collector on the loopback interface, receiving everything sent to it on
+ * a thread of its own.
+ */
+class LoopbackListener
+{
+  public:
+    explicit LoopbackListener(std::uint16_t port = 0)
+    {
+        socket_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        REQUIRE(socket_ >= 0);
+
+        const int enabled = 1;
+        ::setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port        = htons(port);
+        REQUIRE(::bind(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+        REQUIRE(::listen(socket_, 4) == 0);
+
+        socklen_t length = sizeof(address);
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+
+        thread_ = std::thread(&LoopbackListener::run, this);
+    }
+
+    ~LoopbackListener()
+    {
+        running_ = false;
+        thread_.join();
+        for (const int connection : connections_)
+            ::close(connection);
+        ::close(socket_);
+    }
+
+    auto getPort() const -> std::uint16_t
+    {
+        return port_;
+    }
+
+    /*!
+     * Waits up to five seconds for size bytes and returns what arrived.
+     */
+    auto waitForReceived(std::size_t size) -> std::string
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                if (received_.size() >= size)
+                    break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        }
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        return received_;
+    }
+
+    /*!
+     * Closes the accepted connections, like a collector restarting.
+     */
+    auto dropConnections() -> void
+    {
+        dropRequested_ = true;
+        while (dropRequested_)
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+  private:
+    auto run() -> void
+    {
+        std::vector<pollfd> watched;
+        while (running_)
+        {
+            if (dropRequested_)
+            {
+                for (const int connection : connections_)
+                    ::close(connection);
+                connections_.clear();
+                dropRequested_ = false;
+            }
+
+            watched.assign(1, pollfd{socket_, POLLIN, 0});
+            for (const int connection : connections_)
+                watched.push_back(pollfd{connection, POLLIN, 0});
+            if (::poll(watched.data(), watched.size(), 10) <= 0)
+                continue;
+
+            if (watched[0].revents & POLLIN)
+                connections_.push_back(::accept(socket_, nullptr, nullptr));
+
+            for (std::size_t i = 1; i < watched.size(); i++)
+            {
+                if (watched[i].revents == 0)
+                    continue;
+
+                char buffer[4096];
+                const ssize_t received = ::recv(watched[i].fd, buffer, sizeof(buffer), 0);
+                if (received > 0)
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    received_.append(buffer, static_cast<std::size_t>(received));
+                }
+            }
+        }
+    }
+
+  private:
+    int socket_         = -1;
+    std::uint16_t port_ = 0;
+    std::vector<int> connections_;
+    std::mutex mutex_;
+    std::string received_;
+    std::atomic<bool> running_{true};
+    std::atomic<bool> dropRequested_{false};
+    std::thread thread_;
+};
+
+
+
+/*!
+ * A loopback port nothing listens on, until a test starts a listener there.
+ */
+auto getUnusedPort() -> std::uint16_t
+{
+    return LoopbackListener{}.getPort();
+}
+
+
+
+auto repeat(const std::string& message, std::size_t count) -> std::string
+{
+    std::string repeated;
+    for (std::size_t i = 0; i < count; i++)
+        repeated += message;
+    return repeated;
+}
+
+
+
+class TcpSinkTestFixture : public TemporaryDirectoryFixture
+{
+  public:
+    TcpSinkTestFixture() : TemporaryDirectoryFixture{"nealog_tcp_sink_test"}
+    {
+    }
+};
+
+
+
+TEST_CASE("messages arrive in order over one connection", TAG)
+{
+    LoopbackListener listener;
+    TcpSink sink{LOOPBACK, listener.getPort()};
+    requireResultEqualsExpected(sink.getType(), SinkType::Tcp);
+
+    std::string expected;
+    for (int i = 0; i < 1000; i++)
+    {
+        const std::string message = "message " + std::to_string(i) + "\n";
+        sink.write(Severity::Info, message);
+        expected += message;
+    }
+    sink.flush();
+
+    requireResultEqualsExpected(listener.waitForReceived(expected.size()), expected);
+    REQUIRE(sink.isConnected());
+    REQUIRE(sink.getConnectionCount() == 1);
+    REQUIRE(sink.getDroppedCount() == 0);
+}
+
+
+
+TEST_CASE("a batch is filtered by the sink severity", TAG)
+{
+    LoopbackListener listener;
+    TcpSink sink{LOOPBACK, listener.getPort()};
+    sink.setSeverity(Severity::Warn);
+
+    const SinkRecord records[] = {
+        {Severity::Info, "info\n"}, {Severity::Warn, "warn\n"}, {Severity::Error, "error\n"}};
+    sink.writeBatch(records, 3);
+    sink.write(Severity::Debug, "debug\n");
+    sink.flush();
+
+    requireResultEqualsExpected(listener.waitForReceived(11), "warn\nerror\n");
+}
+
+
+
+TEST_CASE("the sink reconnects after the collector dropped the connection", TAG)
+{
+    LoopbackListener listener;
+    TcpSinkPolicy policy;
+    policy.minReconnectDelay = std::chrono::milliseconds{10};
+    TcpSink sink{LOOPBACK, listener.getPort(), policy};
+
+    sink.write(Severity::Info, "first\n");
+    sink.flush();
+    requireResultEqualsExpected(listener.waitForReceived(6), "first\n");
+
+    listener.dropConnections();
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    sink.write(Severity::Info, "second\n");
+    sink.flush();
+
+    requireResultEqualsExpected(listener.waitForReceived(13), "first\nsecond\n");
+    REQUIRE(sink.getConnectionCount() == 2);
+}
+
+
+
+TEST_CASE("messages written while the collector is down are sent once it is up", TAG)
+{
+    const std::uint16_t port = getUnusedPort();
+    TcpSinkPolicy policy;
+    policy.minReconnectDelay = std::chrono::milliseconds{10};
+    policy.maxReconnectDelay = std::chrono::milliseconds{20};
+    TcpSink sink{LOOPBACK, port, policy};
+
+    sink.write(Severity::Info, "early\n");
+    // returns once the connection is found down instead of waiting for it
+    sink.flush();
+    REQUIRE_FALSE(sink.isConnected());
+
+    LoopbackListener listener{port};
+    sink.write(Severity::Info, "late\n");
+
+    requireResultEqualsExpected(listener.waitForReceived(11), "early\nlate\n");
+    REQUIRE(sink.getDroppedCount() == 0);
+}
+
+
+
+TEST_CASE("messages without room are dropped", TAG)
+{
+    TcpSinkPolicy policy;
+    policy.bufferCapacity = 8;
+    policy.overflow       = TcpOverflow::Drop;
+    TcpSink sink{LOOPBACK, getUnusedPort(), policy};
+
+    for (int i = 0; i < 10; i++)
+        sink.write(Severity::Info, "abcd");
+
+    // at most two messages wait in the buffer and two in the batch of the sender
+    REQUIRE(sink.getDroppedCount() >= 6);
+    REQUIRE(sink.getSpilledCount() == 0);
+}
+
+
+
+TEST_CASE_METHOD(TcpSinkTestFixture, "messages without room and the unsent ones are spilled to the file", TAG)
+{
+    TcpSinkPolicy policy;
+    policy.bufferCapacity = 8;
+    policy.overflow       = TcpOverflow::Spill;
+    policy.spillPath      = path;
+    {
+        TcpSink sink{LOOPBACK, getUnusedPort(), policy};
+        for (int i = 0; i < 10; i++)
+            sink.write(Severity::Info, "abcd");
+
+        REQUIRE(sink.getSpilledCount() >= 6);
+        REQUIRE(sink.getDroppedCount() == 0);
+    }
+
+    requireResultEqualsExpected(readFile(path), repeat("abcd", 10));
+}
+
+
+
+TEST_CASE("a writer blocks without room until the collector is up", TAG_THREADING)
+{
+    const std::uint16_t port = getUnusedPort();
+    TcpSinkPolicy policy;
+    policy.bufferCapacity    = 8;
+    policy.overflow          = TcpOverflow::Block;
+    policy.minReconnectDelay = std::chrono::milliseconds{10};
+    policy.maxReconnectDelay = std::chrono::milliseconds{20};
+    TcpSink sink{LOOPBACK, port, policy};
+
+    std::atomic<bool> written{false};
+    std::thread writer{[&sink, &written] {
+        for (int i = 0; i < 6; i++)
+            sink.write(Severity::Info, "abcd");
+        written = true;
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    const bool writtenWhileDown = written;
+
+    LoopbackListener listener{port};
+    writer.join();
+    sink.flush();
+
+    REQUIRE_FALSE(writtenWhileDown);
+    requireResultEqualsExpected(listener.waitForReceived(24), repeat("abcd", 6));
+    REQUIRE(sink.getDroppedCount() == 0);
+}
+
+
+
+TEST_CASE("concurrent writers keep their messages whole", TAG_THREADING)
+{
+    LoopbackListener listener;
+    TcpSinkPolicy policy;
+    policy.bufferCapacity = 1024;
+    policy.overflow       = TcpOverflow::Block;
+    TcpSink sink{LOOPBACK, listener.getPort(), policy};
+
+    constexpr int THREADS  = 4;
+    constexpr int MESSAGES = 2000;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; t++)
+    {
+        writers.emplace_back([&sink, t] {
+            const std::string message = "writer " + std::to_string(t) + "\n";
+            for (int i = 0; i < MESSAGES; i++)
+                sink.write(Severity::Info, message);
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    sink.flush();
+
+    const std::string received = listener.waitForReceived(THREADS * MESSAGES * 9);
+    REQUIRE(received.size() == THREADS * MESSAGES * 9);
+    for (int t = 0; t < THREADS; t++)
+    {
+        const std::string message = "writer " + std::to_string(t) + "\n";
+        std::size_t count         = 0;
+        std::size_t position      = received.find(message);
+        while (position != std::string::npos)
+        {
+            count++;
+            position = received.find(message, position + message.size());
+        }
+        REQUIRE(count == MESSAGES);
+    }
+}
+
+
+
+TEST_CASE("a crash flush hands the buffer to the socket before the deadline", TAG)
+{
+    LoopbackListener listener;
+    TcpSink sink{LOOPBACK, listener.getPort()};
+
+    sink.write(Severity::Fatal, "crashing\n");
+    sink.flushOnCrash(std::chrono::steady_clock::now() + std::chrono::seconds{2});
+
+    requireResultEqualsExpected(listener.waitForReceived(9), "crashing\n");
+}
@@ -2,7 +2,11 @@
 
 #include "nealog/Logger.h"
 #include "catch2/catch_test_macros.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <memory>
+#include <string>
 
 
 class TestFacade
@@ -30,3 +34,37 @@ inline auto requirePointerNotNull(T* pointer) -> void
 {
     REQUIRE(pointer != nullptr);
 }
+
+
+
+inline auto readFile(const std::string& path) -> std::string
+{
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+
+
+/*!
+ * Fixture of the file sink tests, whose directory is empty at the start of
+ * each test and removed after it.
+ */
+class TemporaryDirectoryFixture
+{
+  public:
+    explicit TemporaryDirectoryFixture(const std::string& name)
+        : directory{std::filesystem::temp_directory_path() / name}, path{(directory / "app.log").string()}
+    {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+    }
+
+    ~TemporaryDirectoryFixture()
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+  public:
+    std::filesystem::path directory;
+    std::string path;
+};
@@ -0,0 +1,124 @@
+#include "nealog/BinaryFileSink.h"
+#include "nealog/Formatter.h"
+
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace nealog;
+
+constexpr const char* USAGE = "usage: nealog-decode [--pattern <pattern>] <file>...\n"
+                              "\n"
+                              "Writes the records of binary nealog log files as text to stdout, each one\n"
+                              "rendered with the pattern like a PatternFormatter of a logger would.\n"
+                              "The pattern defaults to \"%(message)\\n\", \\n, \\t and \\\\ in it are unescaped.\n"
+                              "%(time), %(severity), %(logger) and the other placeholders of a pattern are\n"
+                              "taken from the record, the thread and the source location are not stored.\n";
+
+constexpr const char* DEFAULT_PATTERN = "%(message)\n";
+
+
+
+/*!
+ * Replaces the escape sequences a shell does not turn into control characters.
+ */
+auto unescape(std::string_view pattern) -> std::string
+{
+    std::string result;
+    for (std::size_t i = 0; i < pattern.size(); i++)
+    {
+        if (pattern[i] != '\\' || i + 1 == pattern.size())
+        {
+            result += pattern[i];
+            continue;
+        }
+
+        switch (pattern[++i])
+        {
+        case 'n':
+            result += '\n';
+            break;
+        case 't':
+            result += '\t';
+            break;
+        case '\\':
+            result += '\\';
+            break;
+        default:
+            result += '\\';
+            result += pattern[i];
+        }
+    }
+    return result;
+}
+
+
+
+auto decodeFile(const std::string& path, const PatternFormatter& formatter) -> bool
+{
+    std::ifstream file{path, std::ios::binary};
+    if (!file)
+    {
+        std::cerr << "nealog-decode: cannot open " << path << "\n";
+        return false;
+    }
+
+    BinaryLogReader reader{file};
+    BinaryLogEntry entry;
+    fmt::memory_buffer message;
+    fmt::memory_buffer line;
+    // the binary format does not keep the thread, it shows as 0
+    const ThreadIdentity unknownThread{};
+
+    try
+    {
+        while (reader.next(entry))
+        {
+            message.clear();
+            entry.formatMessage(message);
+
+            line.clear();
+            const PatternContext context{entry.timestamp, entry.severity, entry.loggerName, &unknownThread};
+            formatter.render(line, {message.data(), message.size()}, context);
+            std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << "nealog-decode: " << path << ": " << exception.what() << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+
+
+auto main(int argc, char* argv[]) -> int
+{
+    std::string pattern = DEFAULT_PATTERN;
+    int firstFile       = 1;
+
+    if (argc > 2 && std::string_view{argv[1]} == "--pattern")
+    {
+        pattern   = unescape(argv[2]);
+        firstFile = 3;
+    }
+
+    if (firstFile >= argc || std::string_view{argv[1]} == "--help")
+    {
+        std::cerr << USAGE;
+        return 2;
+    }
+
+    std::ios::sync_with_stdio(false);
+    const PatternFormatter formatter{pattern};
+
+    bool succeeded = true;
+    for (int i = firstFile; i < argc; i++)
+        succeeded = decodeFile(argv[i], formatter) && succeeded;
+
+    return succeeded ? 0 : 1;
+}
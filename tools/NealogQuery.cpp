@@ -0,0 +1,375 @@
+#include "nealog/Severity.h"
+#include "nealog/SidecarIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace nealog;
+
+constexpr const char* USAGE =
+    "usage: nealog-query [options] <file>...\n"
+    "\n"
+    "Prints the lines of text log files which a FileSink wrote with a sidecar\n"
+    "index. The index selects the blocks which may hold matching messages, these\n"
+    "are scanned in parallel and printed in file order. Every line of a selected\n"
+    "block is printed unless --grep filters them.\n"
+    "\n"
+    "  --from <time>       blocks with messages at or after the time\n"
+    "  --to <time>         blocks with messages at or before the time\n"
+    "  --severity <level>  blocks with a message of the severity or a higher one\n"
+    "  --logger <name>     blocks with a message of the logger or a descendant\n"
+    "  --grep <text>       only lines containing the text\n"
+    "  --threads <count>   threads scanning blocks, defaults to the number of cores\n"
+    "\n"
+    "Times are UTC like 2024-05-01T12:00:00.250 or seconds since the epoch and\n"
+    "compared with when the messages reached the sink. Levels are trace, debug,\n"
+    "info, warn, error and fatal.\n";
+
+// blocks in flight per scanning thread, bounds the memory of a query
+constexpr std::size_t BLOCKS_PER_THREAD = 2;
+
+
+
+struct Options
+{
+    IndexQuery query{};
+    std::string grep{};
+    std::size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> files{};
+};
+
+
+
+/*!
+ * Days between 1970-01-01 and the date of the proleptic Gregorian calendar.
+ */
+auto daysFromCivil(int year, unsigned month, unsigned day) -> std::int64_t
+{
+    year -= month <= 2 ? 1 : 0;
+    const int era            = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned dayOfEra  = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return static_cast<std::int64_t>(era) * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+}
+
+
+
+auto parseTime(const std::string& text) -> std::optional<std::chrono::system_clock::time_point>
+{
+    using namespace std::chrono;
+
+    std::int64_t seconds = 0;
+    double fraction      = 0;
+    int consumed         = 0;
+
+    int year       = 0;
+    unsigned month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (std::sscanf(text.c_str(), "%d-%u-%uT%u:%u:%u%n", &year, &month, &day, &hour, &minute, &second, &consumed) == 6)
+    {
+        if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+            return std::nullopt;
+
+        seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    }
+    else
+    {
+        long long epochSeconds = 0;
+        if (std::sscanf(text.c_str(), "%lld%n", &epochSeconds, &consumed) != 1)
+            return std::nullopt;
+
+        seconds = epochSeconds;
+    }
+
+    const std::string rest = text.substr(static_cast<std::size_t>(consumed));
+    if (!rest.empty())
+    {
+        int fractionConsumed = 0;
+        if (rest[0] != '.' || std::sscanf(rest.c_str(), "%lf%n", &fraction, &fractionConsumed) != 1 ||
+            static_cast<std::size_t>(fractionConsumed) != rest.size())
+        {
+            return std::nullopt;
+        }
+    }
+
+    const auto sinceEpoch = std::chrono::seconds{seconds} + duration_cast<nanoseconds>(duration<double>{fraction});
+    return system_clock::time_point{duration_cast<system_clock::duration>(sinceEpoch)};
+}
+
+
+
+auto parseSeverity(std::string_view text) -> std::optional<Severity>
+{
+    for (Severity severity : {Severity::Trace, Severity::Debug, Severity::Info, Severity::Warn, Severity::Error,
+                              Severity::Fatal})
+    {
+        const std::string_view name = severityName(severity);
+        if (name.size() == text.size() &&
+            std::equal(name.begin(), name.end(), text.begin(), [](char left, char right) {
+                return std::tolower(static_cast<unsigned char>(left)) ==
+                       std::tolower(static_cast<unsigned char>(right));
+            }))
+        {
+            return severity;
+        }
+    }
+    return std::nullopt;
+}
+
+
+
+auto parseOptions(int argc, char* argv[]) -> std::optional<Options>
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view argument{argv[i]};
+        if (argument.substr(0, 2) != "--")
+        {
+            options.files.emplace_back(argument);
+            continue;
+        }
+
+        if (i + 1 == argc)
+            return std::nullopt;
+
+        const std::string value{argv[++i]};
+        if (argument == "--from" || argument == "--to")
+        {
+            auto time = parseTime(value);
+            if (!time)
+                return std::nullopt;
+
+            (argument == "--from" ? options.query.from : options.query.to) = *time;
+        }
+        else if (argument == "--severity")
+        {
+            auto severity = parseSeverity(value);
+            if (!severity)
+                return std::nullopt;
+
+            options.query.severity = *severity;
+        }
+        else if (argument == "--logger")
+        {
+            options.query.loggerSubtree = value;
+        }
+        else if (argument == "--grep")
+        {
+            options.grep = value;
+        }
+        else if (argument == "--threads")
+        {
+            options.threadCount = static_cast<std::size_t>(std::max(1, std::atoi(value.c_str())));
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    if (options.files.empty())
+        return std::nullopt;
+
+    return options;
+}
+
+
+
+/*!
+ * Reads the block and keeps the lines containing grep, all of them if it is empty.
+ */
+auto scanBlock(std::ifstream& file, const IndexedBlock& block, const std::string& grep) -> std::string
+{
+    std::string content(static_cast<std::size_t>(block.size), '\0');
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(block.offset));
+    file.read(content.data(), static_cast<std::streamsize>(content.size()));
+
+    // the file may have been truncated since the index was written
+    content.resize(static_cast<std::size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+    if (grep.empty())
+        return content;
+
+    std::string matches;
+    const std::string_view lines{content};
+    std::size_t lineBegin = 0;
+    while (lineBegin < lines.size())
+    {
+        const std::size_t found = lines.find(grep, lineBegin);
+        if (found == std::string_view::npos)
+            break;
+
+        // widen the match to its line
+        const std::size_t matchLineBegin = lines.rfind('\n', found);
+        const std::size_t begin          = matchLineBegin == std::string_view::npos || matchLineBegin < lineBegin
+                                               ? lineBegin
+                                               : matchLineBegin + 1;
+        const std::size_t newline        = lines.find('\n', found + grep.size());
+        const std::size_t end            = newline == std::string_view::npos ? lines.size() : newline + 1;
+
+        matches.append(lines.substr(begin, end - begin));
+        lineBegin = end;
+    }
+    return matches;
+}
+
+
+
+/*!
+ * Results of the blocks in flight, the slot of block i is i modulo the
+ * capacity. A block is only scanned once its slot is free, so at most
+ * capacity results wait for the ones before them to be printed.
+ */
+class ReorderBuffer
+{
+  public:
+    explicit ReorderBuffer(std::size_t capacity) : slots_(capacity)
+    {
+    }
+
+    /*!
+     * Waits until the results before the block left room for it.
+     */
+    auto waitForSlot(std::size_t block) -> void
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        slotFreed_.wait(lock, [this, block]() { return block < taken_ + slots_.size(); });
+    }
+
+    auto put(std::size_t block, std::string result) -> void
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            Slot& slot  = slots_[block % slots_.size()];
+            slot.result = std::move(result);
+            slot.ready  = true;
+        }
+        resultReady_.notify_one();
+    }
+
+    /*!
+     * Waits for the result of the block after the one taken last.
+     */
+    auto takeNext() -> std::string
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        Slot& slot = slots_[taken_ % slots_.size()];
+        resultReady_.wait(lock, [&slot]() { return slot.ready; });
+
+        std::string result = std::move(slot.result);
+        slot.ready         = false;
+        taken_++;
+
+        lock.unlock();
+        slotFreed_.notify_all();
+        return result;
+    }
+
+  private:
+    struct Slot
+    {
+        std::string result{};
+        bool ready = false;
+    };
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable slotFreed_;
+    std::condition_variable resultReady_;
+    std::vector<Slot> slots_;
+    std::size_t taken_ = 0;
+};
+
+
+
+auto queryFile(const std::string& path, const Options& options) -> bool
+{
+    std::ifstream indexFile{path + SIDECAR_INDEX_SUFFIX, std::ios::binary};
+    if (!indexFile)
+    {
+        std::cerr << "nealog-query: " << path << " has no sidecar index, enable it with FileIndexPolicy\n";
+        return false;
+    }
+
+    std::optional<SidecarIndex> index;
+    try
+    {
+        index.emplace(indexFile);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << "nealog-query: " << path << SIDECAR_INDEX_SUFFIX << ": " << exception.what() << "\n";
+        return false;
+    }
+
+    if (!std::ifstream{path, std::ios::binary})
+    {
+        std::cerr << "nealog-query: cannot open " << path << "\n";
+        return false;
+    }
+
+    const std::vector<const IndexedBlock*> blocks = index->findBlocks(options.query);
+    ReorderBuffer results{options.threadCount * BLOCKS_PER_THREAD};
+    std::atomic<std::size_t> next{0};
+
+    // the threads take the blocks in file order, so the block printed next always gets scanned
+    auto scan = [&]() {
+        std::ifstream file{path, std::ios::binary};
+        for (std::size_t i = next++; i < blocks.size(); i = next++)
+        {
+            results.waitForSlot(i);
+            results.put(i, scanBlock(file, *blocks[i], options.grep));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const std::size_t threadCount = std::min(options.threadCount, blocks.size());
+    for (std::size_t i = 0; i < threadCount; i++)
+        threads.emplace_back(scan);
+
+    for (std::size_t i = 0; i < blocks.size(); i++)
+    {
+        const std::string result = results.takeNext();
+        std::cout.write(result.data(), static_cast<std::streamsize>(result.size()));
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    return true;
+}
+
+
+
+auto main(int argc, char* argv[]) -> int
+{
+    const std::optional<Options> options = parseOptions(argc, argv);
+    if (!options)
+    {
+        std::cerr << USAGE;
+        return 2;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    bool succeeded = true;
+    for (const std::string& file : options->files)
+        succeeded = queryFile(file, *options) && succeeded;
+
+    return succeeded ? 0 : 1;
+}